@@ -0,0 +1,392 @@
+/*
+ * Routine: ani — Anime/Manga scheduling information CLI
+ * Author: DannyBimma
+ * Copyright: (c) 2025 Technomancer Pirate Captain. All Rights Reserved.
+ */
+
+// ani_loadgen — drive the real ani binary with N queries at a fixed
+// concurrency and report latency percentiles, throughput, CPU and RSS.
+//
+// Typical run against the local stub:
+//   ani_stub_server --port 8088 &
+//   ani_loadgen --bin build/src/ani --base http://127.0.0.1:8088 -n 500
+//               -c 16 --json summary.json -- -a
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_EXTRA_ARGS 32
+
+static const char *const default_queries[] = {
+    "One Piece",  "Frieren",       "Berserk",      "Demon Slayer",
+    "Chainsaw Man", "Dandadan",    "Blue Lock",    "Vinland Saga",
+    "Spy x Family", "Jujutsu Kaisen", "Oshi no Ko", "Kaiju No. 8"};
+
+typedef struct {
+  pid_t pid;
+  int64_t start_us;
+} running_query;
+
+static int64_t now_us(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (int64_t)ts.tv_sec * 1000000 + (int64_t)ts.tv_nsec / 1000;
+}
+
+static int compare_i64(const void *a, const void *b) {
+  int64_t x = *(const int64_t *)a;
+  int64_t y = *(const int64_t *)b;
+
+  return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile over sorted samples
+static double percentile_ms(const int64_t *sorted, size_t n, double p) {
+  size_t rank;
+
+  if (n == 0) {
+    return 0.0;
+  }
+
+  rank = (size_t)(p / 100.0 * (double)n + 0.999999);
+  if (rank < 1) {
+    rank = 1;
+  }
+  if (rank > n) {
+    rank = n;
+  }
+
+  return (double)sorted[rank - 1] / 1000.0;
+}
+
+static char **load_queries(const char *path, size_t *count_out) {
+  FILE *f;
+  char line[1024];
+  char **queries;
+  size_t count;
+  size_t capacity;
+
+  f = fopen(path, "r");
+  if (f == NULL) {
+    return NULL;
+  }
+
+  queries = NULL;
+  count = 0;
+  capacity = 0;
+  while (fgets(line, sizeof(line), f) != NULL) {
+    size_t len = strcspn(line, "\r\n");
+    line[len] = '\0';
+    if (len == 0 || line[0] == '#') {
+      continue;
+    }
+
+    if (count == capacity) {
+      char **grown;
+      capacity = capacity == 0 ? 64 : capacity * 2;
+      grown = realloc(queries, capacity * sizeof(*grown));
+      if (grown == NULL) {
+        break;
+      }
+      queries = grown;
+    }
+    queries[count] = strdup(line);
+    if (queries[count] != NULL) {
+      count++;
+    }
+  }
+  fclose(f);
+
+  *count_out = count;
+  return queries;
+}
+
+static void set_base_urls(const char *base) {
+  char url[1024];
+
+  snprintf(url, sizeof(url), "%s/jikan", base);
+  setenv("ANI_JIKAN_URL", url, 1);
+  snprintf(url, sizeof(url), "%s/anilist", base);
+  setenv("ANI_ANILIST_URL", url, 1);
+  snprintf(url, sizeof(url), "%s/mangadex", base);
+  setenv("ANI_MANGADEX_URL", url, 1);
+}
+
+static pid_t spawn_query(const char *bin, char **extra, int extra_count,
+                         const char *query) {
+  char *child_argv[MAX_EXTRA_ARGS + 3];
+  pid_t pid;
+  int i;
+
+  child_argv[0] = (char *)bin;
+  for (i = 0; i < extra_count; i++) {
+    child_argv[i + 1] = extra[i];
+  }
+  child_argv[extra_count + 1] = (char *)query;
+  child_argv[extra_count + 2] = NULL;
+
+  pid = fork();
+  if (pid == 0) {
+    int devnull = open("/dev/null", O_WRONLY);
+    if (devnull >= 0) {
+      dup2(devnull, STDOUT_FILENO);
+      dup2(devnull, STDERR_FILENO);
+      close(devnull);
+    }
+    execv(bin, child_argv);
+    _exit(127);
+  }
+
+  return pid;
+}
+
+static void print_usage(const char *prog) {
+  printf("Usage: %s --bin <ani> [options] [-- <extra ani args>]\n\n", prog);
+  printf("Options:\n");
+  printf("  --bin <path>         ani binary to drive (required)\n");
+  printf("  -n <count>           Total queries (default: 100)\n");
+  printf("  -c <concurrency>     Queries in flight (default: 4)\n");
+  printf("  --queries <file>     One query per line (default: built-in)\n");
+  printf("  --base <url>         Point all providers at a stub server\n");
+  printf("  --json <file>        Write JSON summary to file\n");
+}
+
+int main(int argc, char **argv) {
+  const char *bin;
+  const char *queries_path;
+  const char *base;
+  const char *json_path;
+  char **extra;
+  int extra_count;
+  long total;
+  long concurrency;
+  char **queries;
+  size_t query_count;
+  running_query *running;
+  int64_t *latencies;
+  long launched;
+  long completed;
+  long failures;
+  int64_t run_start;
+  int64_t wall_us;
+  double cpu_user_s;
+  double cpu_sys_s;
+  long max_rss_kb;
+  int i;
+
+  bin = NULL;
+  queries_path = NULL;
+  base = NULL;
+  json_path = NULL;
+  extra = NULL;
+  extra_count = 0;
+  total = 100;
+  concurrency = 4;
+
+  for (i = 1; i < argc; i++) {
+    bool has_arg = i + 1 < argc;
+
+    if (strcmp(argv[i], "--bin") == 0 && has_arg) {
+      bin = argv[++i];
+    } else if (strcmp(argv[i], "-n") == 0 && has_arg) {
+      total = atol(argv[++i]);
+    } else if (strcmp(argv[i], "-c") == 0 && has_arg) {
+      concurrency = atol(argv[++i]);
+    } else if (strcmp(argv[i], "--queries") == 0 && has_arg) {
+      queries_path = argv[++i];
+    } else if (strcmp(argv[i], "--base") == 0 && has_arg) {
+      base = argv[++i];
+    } else if (strcmp(argv[i], "--json") == 0 && has_arg) {
+      json_path = argv[++i];
+    } else if (strcmp(argv[i], "--") == 0) {
+      extra = &argv[i + 1];
+      extra_count = argc - i - 1;
+      break;
+    } else {
+      print_usage(argv[0]);
+
+      return strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0
+                 ? 0
+                 : 1;
+    }
+  }
+
+  if (bin == NULL || total <= 0 || concurrency <= 0 ||
+      extra_count > MAX_EXTRA_ARGS) {
+    print_usage(argv[0]);
+
+    return 1;
+  }
+
+  if (queries_path != NULL) {
+    queries = load_queries(queries_path, &query_count);
+    if (queries == NULL || query_count == 0) {
+      fprintf(stderr, "Error: no queries in %s\n", queries_path);
+
+      return 1;
+    }
+  } else {
+    queries = (char **)default_queries;
+    query_count = sizeof(default_queries) / sizeof(default_queries[0]);
+  }
+
+  if (base != NULL) {
+    set_base_urls(base);
+  }
+
+  running = calloc((size_t)concurrency, sizeof(*running));
+  latencies = calloc((size_t)total, sizeof(*latencies));
+  if (running == NULL || latencies == NULL) {
+    fprintf(stderr, "Error: out of memory\n");
+
+    return 1;
+  }
+
+  launched = 0;
+  completed = 0;
+  failures = 0;
+  cpu_user_s = 0.0;
+  cpu_sys_s = 0.0;
+  max_rss_kb = 0;
+  run_start = now_us();
+
+  while (completed < total) {
+    struct rusage ru;
+    int status;
+    pid_t pid;
+    long slot;
+
+    // Fill free slots
+    for (slot = 0; slot < concurrency && launched < total; slot++) {
+      if (running[slot].pid != 0) {
+        continue;
+      }
+      running[slot].start_us = now_us();
+      running[slot].pid =
+          spawn_query(bin, extra, extra_count,
+                      queries[(size_t)launched % query_count]);
+      if (running[slot].pid < 0) {
+        perror("fork");
+        running[slot].pid = 0;
+        latencies[completed] = 0;
+        failures++;
+        completed++;
+      }
+      launched++;
+    }
+
+    // Reap one finished query
+    pid = wait4(-1, &status, 0, &ru);
+    if (pid < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+
+    for (slot = 0; slot < concurrency; slot++) {
+      if (running[slot].pid == pid) {
+        latencies[completed] = now_us() - running[slot].start_us;
+        running[slot].pid = 0;
+        break;
+      }
+    }
+    if (slot == concurrency) {
+      continue; // Not ours
+    }
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      failures++;
+    }
+    cpu_user_s += (double)ru.ru_utime.tv_sec + (double)ru.ru_utime.tv_usec / 1e6;
+    cpu_sys_s += (double)ru.ru_stime.tv_sec + (double)ru.ru_stime.tv_usec / 1e6;
+#ifdef __APPLE__
+    if (ru.ru_maxrss / 1024 > max_rss_kb) {
+      max_rss_kb = ru.ru_maxrss / 1024;
+    }
+#else
+    if (ru.ru_maxrss > max_rss_kb) {
+      max_rss_kb = ru.ru_maxrss;
+    }
+#endif
+    completed++;
+  }
+
+  wall_us = now_us() - run_start;
+  qsort(latencies, (size_t)completed, sizeof(*latencies), compare_i64);
+
+  {
+    double mean_ms = 0.0;
+    double throughput;
+    double p50 = percentile_ms(latencies, (size_t)completed, 50.0);
+    double p95 = percentile_ms(latencies, (size_t)completed, 95.0);
+    double p99 = percentile_ms(latencies, (size_t)completed, 99.0);
+    double max_ms = completed > 0
+                        ? (double)latencies[completed - 1] / 1000.0
+                        : 0.0;
+    long k;
+
+    for (k = 0; k < completed; k++) {
+      mean_ms += (double)latencies[k] / 1000.0;
+    }
+    if (completed > 0) {
+      mean_ms /= (double)completed;
+    }
+    throughput = wall_us > 0 ? (double)completed * 1e6 / (double)wall_us : 0.0;
+
+    printf("queries:     %ld (%ld failed), concurrency %ld\n", completed,
+           failures, concurrency);
+    printf("latency ms:  p50 %.1f  p95 %.1f  p99 %.1f  mean %.1f  max %.1f\n",
+           p50, p95, p99, mean_ms, max_ms);
+    printf("throughput:  %.1f queries/s over %.2f s\n", throughput,
+           (double)wall_us / 1e6);
+    printf("cpu:         %.3f s user, %.3f s sys (%.2f ms/query)\n",
+           cpu_user_s, cpu_sys_s,
+           completed > 0 ? (cpu_user_s + cpu_sys_s) * 1000.0 / (double)completed
+                         : 0.0);
+    printf("max rss:     %ld KB\n", max_rss_kb);
+
+    if (json_path != NULL) {
+      FILE *f = fopen(json_path, "w");
+      if (f == NULL) {
+        perror(json_path);
+
+        return 1;
+      }
+      fprintf(f,
+              "{\n"
+              "  \"queries\": %ld,\n"
+              "  \"failures\": %ld,\n"
+              "  \"concurrency\": %ld,\n"
+              "  \"wall_s\": %.3f,\n"
+              "  \"throughput_qps\": %.2f,\n"
+              "  \"latency_ms\": {\"p50\": %.2f, \"p95\": %.2f, \"p99\": %.2f, "
+              "\"mean\": %.2f, \"max\": %.2f},\n"
+              "  \"cpu_user_s\": %.3f,\n"
+              "  \"cpu_sys_s\": %.3f,\n"
+              "  \"max_rss_kb\": %ld\n"
+              "}\n",
+              completed, failures, concurrency, (double)wall_us / 1e6,
+              throughput, p50, p95, p99, mean_ms, max_ms, cpu_user_s,
+              cpu_sys_s, max_rss_kb);
+      fclose(f);
+    }
+  }
+
+  free(running);
+  free(latencies);
+  return failures > 0 ? 2 : 0;
+}
@@ -0,0 +1,1007 @@
+/*
+ * Routine: ani — Anime/Manga scheduling information CLI
+ * Author: DannyBimma
+ * Copyright: (c) 2025 Technomancer Pirate Captain. All Rights Reserved.
+ */
+
+// ani_bench — microbenchmarks for the hot paths, run as Unity test cases.
+//
+// Each case reports ns/op, allocations/op and bytes/op. With
+// --compare baseline.json a case fails when it got slower than the
+// threshold or allocates more than the baseline, so the suite can gate CI:
+//   ani_bench --json base.json            # on the old tree
+//   ani_bench --compare base.json         # on the new tree
+//
+// Allocations are counted by installing an ani_alloc_counter, so they cover
+// ani itself, yyjson and libcurl on every platform.
+
+#include "ani/alloc.h"
+#include "ani/cache.h"
+#include "ani/calendar.h"
+#include "ani/fs.h"
+#include "ani/index.h"
+#include "ani/json.h"
+#include "ani/log.h"
+#include "ani/models.h"
+#include "ani/output.h"
+#include "ani/str.h"
+#include "ani/time.h"
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <unity.h>
+#include <yyjson.h>
+
+#ifndef ANI_BENCH_FIXTURES_DIR
+#define ANI_BENCH_FIXTURES_DIR "bench/fixtures"
+#endif
+
+#define MAX_RESULTS 64
+#define REPETITIONS 3
+
+typedef void (*bench_fn)(void *arg);
+
+typedef struct {
+  char name[64];
+  double ns_per_op;
+  double allocs_per_op; // -1 when allocations are not counted
+  double bytes_per_op;
+  uint64_t iterations;
+} bench_result;
+
+typedef struct {
+  char *data;
+  size_t len;
+} bench_payload;
+
+// Options
+static const char *fixtures_dir = ANI_BENCH_FIXTURES_DIR;
+static const char *json_path = NULL;
+static const char *compare_path = NULL;
+static const char *filter = NULL;
+static double threshold_pct = 10.0;
+static int64_t min_time_ns = 200000000;
+
+// State
+static bench_result results[MAX_RESULTS];
+static size_t result_count = 0;
+static bench_result baseline[MAX_RESULTS];
+static size_t baseline_count = 0;
+static char regression_msg[256];
+static size_t regressions = 0;
+static FILE *report = NULL;
+static char *bench_tmp_dir = NULL;
+static ani_cache *bench_cache = NULL;
+static volatile size_t sink;
+
+static const char *const fixture_names[] = {
+    "jikan_search", "anilist_media", "mangadex_search", "mangadex_chapter"};
+#define FIXTURE_COUNT (sizeof(fixture_names) / sizeof(fixture_names[0]))
+static bench_payload fixtures[FIXTURE_COUNT];
+
+// Every ani, yyjson and libcurl allocation goes through this counter
+static ani_alloc_counter alloc_counter;
+
+static void alloc_totals(uint64_t *count, uint64_t *bytes) {
+  ani_alloc_stats stats;
+
+  ani_alloc_counter_stats(&alloc_counter, &stats);
+  *count = stats.allocs + stats.reallocs;
+  *bytes = stats.bytes;
+}
+
+static int64_t now_ns(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (int64_t)ts.tv_sec * 1000000000 + (int64_t)ts.tv_nsec;
+}
+
+static int64_t time_batch(bench_fn fn, void *arg, uint64_t iterations) {
+  int64_t start;
+  uint64_t i;
+
+  start = now_ns();
+  for (i = 0; i < iterations; i++) {
+    fn(arg);
+  }
+
+  return now_ns() - start;
+}
+
+static const bench_result *find_baseline(const char *name) {
+  size_t i;
+
+  for (i = 0; i < baseline_count; i++) {
+    if (strcmp(baseline[i].name, name) == 0) {
+      return &baseline[i];
+    }
+  }
+
+  return NULL;
+}
+
+static void check_regression(const bench_result *r) {
+  const bench_result *base;
+  double limit;
+
+  base = find_baseline(r->name);
+  if (base == NULL || base->ns_per_op <= 0.0) {
+    return;
+  }
+
+  limit = base->ns_per_op * (1.0 + threshold_pct / 100.0);
+  if (r->ns_per_op > limit) {
+    fprintf(report, "  REGRESSION %s: %.1f ns/op vs %.1f baseline (%+.1f%%)\n",
+            r->name, r->ns_per_op, base->ns_per_op,
+            (r->ns_per_op / base->ns_per_op - 1.0) * 100.0);
+    snprintf(regression_msg, sizeof(regression_msg), "%s slower than baseline",
+             r->name);
+    regressions++;
+  }
+
+  // Allocation counts are deterministic, so any growth is a regression
+  if (r->allocs_per_op >= 0.0 && base->allocs_per_op >= 0.0 &&
+      r->allocs_per_op > base->allocs_per_op + 0.01) {
+    fprintf(report, "  REGRESSION %s: %.2f allocs/op vs %.2f baseline\n",
+            r->name, r->allocs_per_op, base->allocs_per_op);
+    snprintf(regression_msg, sizeof(regression_msg),
+             "%s allocates more than baseline", r->name);
+    regressions++;
+  }
+}
+
+// Calibrate, measure the best of REPETITIONS runs and record the result
+static void bench_run(const char *name, bench_fn fn, void *arg) {
+  bench_result *r;
+  uint64_t iterations;
+  int64_t elapsed;
+  int64_t best;
+  int rep;
+
+  if (filter != NULL && strstr(name, filter) == NULL) {
+    return;
+  }
+  if (result_count == MAX_RESULTS) {
+    TEST_FAIL_MESSAGE("too many benchmarks");
+  }
+
+  // Grow the batch until it takes a tenth of the time budget
+  iterations = 1;
+  for (;;) {
+    elapsed = time_batch(fn, arg, iterations);
+    if (elapsed >= min_time_ns / 10 || iterations >= (UINT64_C(1) << 32)) {
+      break;
+    }
+    iterations *= 2;
+  }
+  if (elapsed <= 0) {
+    elapsed = 1;
+  }
+  iterations = (uint64_t)((double)iterations * (double)min_time_ns /
+                          (double)elapsed / REPETITIONS);
+  if (iterations == 0) {
+    iterations = 1;
+  }
+
+  r = &results[result_count++];
+  memset(r, 0, sizeof(*r));
+  ani_strlcpy(r->name, name, sizeof(r->name));
+  r->iterations = iterations;
+
+  best = INT64_MAX;
+  for (rep = 0; rep < REPETITIONS; rep++) {
+    uint64_t count_before;
+    uint64_t bytes_before;
+    uint64_t count_after;
+    uint64_t bytes_after;
+
+    alloc_totals(&count_before, &bytes_before);
+    elapsed = time_batch(fn, arg, iterations);
+    alloc_totals(&count_after, &bytes_after);
+    if (elapsed < best) {
+      best = elapsed;
+    }
+    r->allocs_per_op =
+        (double)(count_after - count_before) / (double)iterations;
+    r->bytes_per_op = (double)(bytes_after - bytes_before) / (double)iterations;
+  }
+  r->ns_per_op = (double)best / (double)iterations;
+
+  fprintf(report, "%-32s %12.1f ns/op %8.2f allocs/op %10.1f B/op\n", r->name,
+          r->ns_per_op, r->allocs_per_op, r->bytes_per_op);
+  fflush(report);
+
+  check_regression(r);
+}
+
+void setUp(void) { regressions = 0; }
+
+// Failing here marks the finished case as failed without cutting it short
+void tearDown(void) {
+  if (regressions > 0) {
+    TEST_FAIL_MESSAGE(regression_msg);
+  }
+}
+
+// --- ani_json_parse ---
+
+static void bench_json_parse(void *arg) {
+  const bench_payload *p = arg;
+  ani_json_doc *doc;
+
+  doc = ani_json_parse(p->data, p->len);
+  sink += ani_json_get_root(doc) != NULL;
+  ani_json_doc_free(doc);
+}
+
+static void test_json_parse(void) {
+  char name[64];
+  size_t i;
+
+  for (i = 0; i < FIXTURE_COUNT; i++) {
+    ani_json_doc *doc = ani_json_parse(fixtures[i].data, fixtures[i].len);
+    TEST_ASSERT_NOT_NULL_MESSAGE(doc, fixture_names[i]);
+    ani_json_doc_free(doc);
+
+    snprintf(name, sizeof(name), "json_parse/%s", fixture_names[i]);
+    bench_run(name, bench_json_parse, &fixtures[i]);
+  }
+}
+
+// --- ani_parse_iso8601 ---
+
+// The previous sscanf-based parser, kept as the baseline for the
+// fixed-position one
+static bool iso8601_sscanf(const char *str, ani_date *out) {
+  int n;
+  char tz_sign;
+  int tz_hours;
+  int tz_minutes;
+
+  if (str == NULL || out == NULL) {
+    return false;
+  }
+
+  memset(out, 0, sizeof(*out));
+  out->hour = -1;
+  out->minute = -1;
+  out->second = -1;
+  out->offset_minutes = 0;
+  out->has_time = false;
+
+  // Try YYYY-MM-DD format first
+  n = sscanf(str, "%d-%d-%d", &out->year, &out->month, &out->day);
+  if (n == 3) {
+    // Validate date
+    if (out->year < 1900 || out->year > 2100 || out->month < 1 ||
+        out->month > 12 || out->day < 1 || out->day > 31) {
+      return false;
+    }
+
+    // Check for time component
+    const char *t_pos = strchr(str, 'T');
+    if (t_pos == NULL) {
+      return true;
+    }
+
+    t_pos++; // Skip 'T'
+
+    // Parse time: hh:mm:ss
+    n = sscanf(t_pos, "%d:%d:%d", &out->hour, &out->minute, &out->second);
+    if (n >= 2) {
+      out->has_time = true;
+      if (n == 2) {
+        out->second = 0;
+      }
+
+      // Validate time
+      if (out->hour < 0 || out->hour > 23 || out->minute < 0 ||
+          out->minute > 59 || out->second < 0 || out->second > 59) {
+        return false;
+      }
+
+      // Check for timezone
+      const char *tz_pos = strpbrk(t_pos, "Zz+-");
+      if (tz_pos != NULL) {
+        if (*tz_pos == 'Z' || *tz_pos == 'z') {
+          out->offset_minutes = 0;
+        } else {
+          tz_sign = *tz_pos;
+          n = sscanf(tz_pos + 1, "%d:%d", &tz_hours, &tz_minutes);
+          if (n >= 1) {
+            out->offset_minutes = tz_hours * 60;
+            if (n == 2) {
+              out->offset_minutes += tz_minutes;
+            }
+            if (tz_sign == '-') {
+              out->offset_minutes = -out->offset_minutes;
+            }
+          }
+        }
+      }
+    }
+
+    return true;
+  }
+
+  return false;
+}
+
+static void bench_iso8601(void *arg) {
+  ani_date date;
+
+  ani_parse_iso8601(arg, &date);
+  sink += (size_t)date.day;
+}
+
+static void bench_iso8601_sscanf(void *arg) {
+  ani_date date;
+
+  // iso8601_sscanf leaves date alone when it rejects its arguments
+  memset(&date, 0, sizeof(date));
+  iso8601_sscanf(arg, &date);
+  sink += (size_t)date.day;
+}
+
+static void bench_instant(void *arg) {
+  ani_instant instant;
+
+  ani_parse_instant(arg, &instant);
+  sink += (size_t)instant.epoch;
+}
+
+static void bench_format_datetime(void *arg) {
+  char buf[32];
+
+  ani_format_datetime(arg, buf, sizeof(buf));
+  sink += (size_t)buf[0];
+}
+
+static void bench_format_instant(void *arg) {
+  char buf[32];
+
+  ani_format_instant(arg, buf, sizeof(buf));
+  sink += (size_t)buf[0];
+}
+
+static void test_iso8601(void) {
+  static const char *const inputs[] = {
+      "2025-03-09", "2025-03-09T06:30:00Z", "2025-03-09T15:30:00+09:00"};
+  ani_date date;
+  ani_date reference;
+  ani_instant instant;
+  char buf[32];
+  size_t i;
+
+  // Both parsers must agree before their speed is worth comparing
+  for (i = 0; i < sizeof(inputs) / sizeof(inputs[0]); i++) {
+    TEST_ASSERT_TRUE(ani_parse_iso8601(inputs[i], &date));
+    TEST_ASSERT_TRUE(iso8601_sscanf(inputs[i], &reference));
+    TEST_ASSERT_EQUAL_INT(reference.year, date.year);
+    TEST_ASSERT_EQUAL_INT(reference.day, date.day);
+    TEST_ASSERT_EQUAL_INT(reference.hour, date.hour);
+    TEST_ASSERT_EQUAL_INT(reference.offset_minutes, date.offset_minutes);
+  }
+  TEST_ASSERT_TRUE(ani_parse_instant(inputs[2], &instant));
+  ani_format_instant(&instant, buf, sizeof(buf));
+  TEST_ASSERT_EQUAL_STRING(inputs[2], buf);
+
+  bench_run("iso8601/date", bench_iso8601, "2025-03-09");
+  bench_run("iso8601/utc", bench_iso8601, "2025-03-09T06:30:00Z");
+  bench_run("iso8601/offset", bench_iso8601, "2025-03-09T15:30:00+09:00");
+  bench_run("iso8601_sscanf/date", bench_iso8601_sscanf, "2025-03-09");
+  bench_run("iso8601_sscanf/utc", bench_iso8601_sscanf,
+            "2025-03-09T06:30:00Z");
+  bench_run("iso8601_sscanf/offset", bench_iso8601_sscanf,
+            "2025-03-09T15:30:00+09:00");
+  bench_run("iso8601/instant", bench_instant, "2025-03-09T15:30:00+09:00");
+
+  ani_parse_iso8601(inputs[2], &date);
+  bench_run("format/datetime", bench_format_datetime, &date);
+  bench_run("format/instant", bench_format_instant, &instant);
+}
+
+// --- ani_url_encode ---
+
+static void bench_url_encode(void *arg) {
+  char *encoded;
+
+  encoded = ani_url_encode(arg);
+  sink += (size_t)encoded[0];
+  ani_free(encoded);
+}
+
+static void test_url_encode(void) {
+  char *encoded = ani_url_encode("One Piece");
+  TEST_ASSERT_TRUE(encoded != NULL && strcmp(encoded, "One+Piece") == 0);
+  ani_free(encoded);
+
+  bench_run("url_encode/ascii", bench_url_encode,
+            "Frieren: Beyond Journey's End");
+  bench_run("url_encode/utf8", bench_url_encode,
+            "\xe8\x91\xac\xe9\x80\x81\xe3\x81\xae\xe3\x83\x95\xe3\x83\xaa"
+            "\xe3\x83\xbc\xe3\x83\xac\xe3\x83\xb3");
+}
+
+// --- string kernels, per ISA ---
+
+// Long enough for the vector loops to dominate
+static const char kernel_title[] =
+    "Sousou no Frieren: Beyond Journey's End - The Great Mage's Funeral   "
+    "and   the   Thousand-Year   Journey   (Season 2)";
+static const char kernel_title_upper[] =
+    "SOUSOU NO FRIEREN: BEYOND JOURNEY'S END - THE GREAT MAGE'S FUNERAL   "
+    "AND   THE   THOUSAND-YEAR   JOURNEY   (SEASON 2)";
+
+static void bench_str_casecmp(void *arg) {
+  (void)arg;
+  sink += (size_t)ani_strcasecmp(kernel_title, kernel_title_upper);
+}
+
+static void bench_str_utf8(void *arg) {
+  sink += ani_utf8_valid(arg, strlen(arg));
+}
+
+static void bench_str_fold(void *arg) {
+  char buf[sizeof(kernel_title)];
+
+  (void)arg;
+  ani_str_fold(buf, kernel_title_upper, sizeof(buf));
+  sink += (size_t)buf[0];
+}
+
+static void bench_str_collapse(void *arg) {
+  char buf[sizeof(kernel_title)];
+
+  (void)arg;
+  memcpy(buf, kernel_title, sizeof(buf));
+  sink += ani_str_collapse_ws(buf);
+}
+
+static void test_str_kernels(void) {
+  static const char utf8_title[] =
+      "\xe8\x91\xac\xe9\x80\x81\xe3\x81\xae\xe3\x83\x95\xe3\x83\xaa"
+      "\xe3\x83\xbc\xe3\x83\xac\xe3\x83\xb3 Sousou no Frieren: Beyond "
+      "Journey's End (Season 2) \xe7\xac\xac"
+      "2\xe6\x9c\x9f";
+  static const ani_str_isa isas[] = {ANI_STR_ISA_SCALAR, ANI_STR_ISA_SSE2,
+                                     ANI_STR_ISA_AVX2, ANI_STR_ISA_NEON};
+  ani_str_isa detected;
+  char name[64];
+  size_t i;
+
+  detected = ani_str_get_isa();
+  for (i = 0; i < sizeof(isas) / sizeof(isas[0]); i++) {
+    const char *isa = ani_str_isa_name(isas[i]);
+
+    if (!ani_str_set_isa(isas[i])) {
+      continue;
+    }
+
+    TEST_ASSERT_TRUE(ani_strcasecmp(kernel_title, kernel_title_upper) == 0);
+    TEST_ASSERT_TRUE(ani_utf8_valid(utf8_title, strlen(utf8_title)));
+
+    snprintf(name, sizeof(name), "str/%s/url_encode", isa);
+    bench_run(name, bench_url_encode, (void *)kernel_title);
+    snprintf(name, sizeof(name), "str/%s/casecmp", isa);
+    bench_run(name, bench_str_casecmp, NULL);
+    snprintf(name, sizeof(name), "str/%s/utf8_valid", isa);
+    bench_run(name, bench_str_utf8, (void *)utf8_title);
+    snprintf(name, sizeof(name), "str/%s/fold", isa);
+    bench_run(name, bench_str_fold, NULL);
+    snprintf(name, sizeof(name), "str/%s/collapse_ws", isa);
+    bench_run(name, bench_str_collapse, NULL);
+  }
+  ani_str_set_isa(detected);
+}
+
+// --- ani_cache_get / ani_cache_set ---
+
+static void bench_cache_set(void *arg) {
+  sink += ani_cache_set(bench_cache, "bench", "search",
+                        ((const bench_payload *)arg)->data);
+}
+
+static void bench_cache_get(void *arg) {
+  char *data;
+
+  data = ani_cache_get(bench_cache, "bench", arg, ANI_CACHE_TTL_SEARCH);
+  sink += data != NULL;
+  ani_free(data);
+}
+
+static void test_cache(void) {
+  char *data;
+
+  TEST_ASSERT_TRUE(
+      ani_cache_set(bench_cache, "bench", "search", fixtures[0].data));
+  data = ani_cache_get(bench_cache, "bench", "search", ANI_CACHE_TTL_SEARCH);
+  TEST_ASSERT_NOT_NULL(data);
+  ani_free(data);
+
+  bench_run("cache_set/search", bench_cache_set, &fixtures[0]);
+  bench_run("cache_get/hit", bench_cache_get, "search");
+  bench_run("cache_get/miss", bench_cache_get, "missing");
+}
+
+// --- ani_index_lookup / ani_index_suggest ---
+
+static const char *const index_heads[] = {
+    "Shingeki no",  "Kimetsu no", "Sousou no", "Boku no",     "Kaguya-sama",
+    "Jujutsu",      "Chainsaw",   "Spy x",     "Mob Psycho",  "Vinland",
+    "Golden",       "Dungeon",    "Oshi no",   "Blue",        "Tokyo",
+    "Fullmetal",    "Hunter x",   "Steins",    "Kaiju No.",   "Dandadan"};
+static const char *const index_tails[] = {
+    "Kyojin", "Yaiba", "Frieren", "Hero Academia", "Love is War",
+    "Kaisen", "Man",   "Family",  "Saga",          "Kamuy",
+    "Meshi",  "Ko",    "Lock",    "Revengers",     "Alchemist"};
+
+static void bench_index_lookup(void *arg) {
+  ani_series *series;
+
+  series = ani_series_new();
+  sink += ani_index_lookup(arg, "Sousou no Frieren", ANI_MEDIA_ANIME, series);
+  ani_series_free(series);
+}
+
+static void bench_index_fuzzy(void *arg) {
+  ani_series *series;
+
+  series = ani_series_new();
+  sink += ani_index_lookup(arg, "sousou no freiren", ANI_MEDIA_ANIME, series);
+  ani_series_free(series);
+}
+
+static void bench_index_suggest(void *arg) {
+  ani_index_match matches[10];
+
+  sink += ani_index_suggest(arg, "kimetsu", ANI_INDEX_ALL, matches, 10);
+}
+
+static void test_index(void) {
+  ani_index *index;
+  ani_series *series;
+  char title[128];
+  char id[32];
+  size_t i;
+  size_t j;
+
+  index = ani_index_open(bench_tmp_dir);
+  TEST_ASSERT_NOT_NULL(index);
+
+  // 300 made-up series, one search each
+  for (i = 0; i < sizeof(index_heads) / sizeof(index_heads[0]); i++) {
+    for (j = 0; j < sizeof(index_tails) / sizeof(index_tails[0]); j++) {
+      snprintf(title, sizeof(title), "%s %s", index_heads[i], index_tails[j]);
+      snprintf(id, sizeof(id), "%zu", i * 100 + j);
+      series = ani_series_new();
+      TEST_ASSERT_NOT_NULL(series);
+      series->id = ani_strdup(id);
+      series->media_type = ANI_MEDIA_ANIME;
+      ani_title_set(&series->title, NULL, NULL, title);
+      TEST_ASSERT_TRUE(ani_index_add(index, title, series));
+      ani_series_free(series);
+    }
+  }
+
+  series = ani_series_new();
+  TEST_ASSERT_TRUE(
+      ani_index_lookup(index, "sousou no freiren", ANI_MEDIA_ANIME, series));
+  TEST_ASSERT_EQUAL_STRING("202", series->id);
+  ani_series_free(series);
+
+  // A sequel number the index does not know is left to the search
+  series = ani_series_new();
+  TEST_ASSERT_FALSE(
+      ani_index_lookup(index, "sousou no freiren 2", ANI_MEDIA_ANIME, series));
+  ani_series_free(series);
+
+  bench_run("index/lookup", bench_index_lookup, index);
+  bench_run("index/fuzzy", bench_index_fuzzy, index);
+  bench_run("index/suggest", bench_index_suggest, index);
+
+  ani_index_close(index);
+}
+
+// --- ani_calendar_fill ---
+
+#define CALENDAR_NOW 1760000000
+
+static void bench_calendar_fill(void *arg) {
+  ani_release_info release;
+
+  memset(&release, 0, sizeof(release));
+  ani_calendar_fill(arg, "1499", CALENDAR_NOW, &release);
+  sink += (size_t)release.next_number;
+}
+
+static void test_calendar(void) {
+  ani_calendar *calendar;
+  ani_release_info release;
+  char id[16];
+  int i;
+
+  // A fortnight of 150 weekly shows, episode 7 airing in the first week
+  calendar = ani_calendar_new(CALENDAR_NOW, CALENDAR_NOW + 14 * 86400);
+  TEST_ASSERT_NOT_NULL(calendar);
+  for (i = 0; i < 300; i++) {
+    TEST_ASSERT_TRUE(ani_calendar_add(
+        calendar, CALENDAR_NOW + 60 + (i % 150) * 4000 + (i / 150) * 7 * 86400,
+        7 + i / 150, 1000 + i % 150 * 10, i % 150, 12, "Weekly"));
+  }
+  ani_calendar_sort(calendar);
+
+  // Episode 6 aired before the window: the premiere date must not stay
+  memset(&release, 0, sizeof(release));
+  ani_parse_iso8601("2025-08-01", &release.latest_date);
+  TEST_ASSERT_TRUE(ani_calendar_fill(calendar, "1000", CALENDAR_NOW, &release));
+  TEST_ASSERT_EQUAL_INT(7, release.next_number);
+  TEST_ASSERT_EQUAL_INT(6, release.latest_number);
+  TEST_ASSERT_EQUAL_INT(0, release.latest_date.year);
+
+  // Past episode 7 the calendar has the latest episode's date too
+  memset(&release, 0, sizeof(release));
+  TEST_ASSERT_TRUE(
+      ani_calendar_fill(calendar, "1000", CALENDAR_NOW + 86400, &release));
+  TEST_ASSERT_EQUAL_INT(8, release.next_number);
+  TEST_ASSERT_EQUAL_INT(7, release.latest_number);
+  TEST_ASSERT_TRUE(release.latest_date.year > 0);
+
+  snprintf(id, sizeof(id), "%d", 1000 + 149 * 10);
+  TEST_ASSERT_TRUE(ani_calendar_fill(calendar, id, CALENDAR_NOW, &release));
+  TEST_ASSERT_FALSE(ani_calendar_fill(calendar, "1", CALENDAR_NOW, &release));
+
+  // Worst case: a series the calendar does not have
+  bench_run("calendar/fill", bench_calendar_fill, calendar);
+
+  ani_calendar_free(calendar);
+}
+
+// --- ani_output_print_json ---
+
+static ani_series *sample_series(ani_arena *arena, ani_media_type type) {
+  ani_series *series;
+
+  series = ani_series_new_in(arena);
+  if (series == NULL) {
+    return NULL;
+  }
+
+  series->id = ani_series_strdup(series, "21");
+  series->provider = "jikan";
+  series->media_type = type;
+  ani_series_set_title(series, "One Piece", "ONE PIECE", "One Piece");
+  series->release.provider_name = "AniList";
+  series->release.latest_number = 1122;
+  series->release.next_number = 1123;
+  series->release.total_count = -1;
+  ani_parse_iso8601("2024-10-13T23:15:00+09:00", &series->release.latest_date);
+  ani_parse_iso8601("2024-10-20T23:15:00+09:00", &series->release.next_date);
+  series->release.next_source = ANI_SOURCE_AGGREGATED_API;
+  series->release.next_confidence = ANI_CONFIDENCE_OFFICIAL;
+
+  return series;
+}
+
+static ani_result *sample_result(bool use_arena) {
+  ani_result *result;
+
+  result = use_arena ? ani_result_new_arena(NULL) : ani_result_new();
+  if (result == NULL) {
+    return NULL;
+  }
+
+  result->query = use_arena ? ani_arena_strdup(result->arena, "One Piece")
+                            : ani_strdup("One Piece");
+  result->anime = sample_series(result->arena, ANI_MEDIA_ANIME);
+  result->manga = sample_series(result->arena, ANI_MEDIA_MANGA);
+  result->has_anime = result->anime != NULL;
+  result->has_manga = result->manga != NULL;
+
+  return result;
+}
+
+static void bench_output_json(void *arg) { ani_output_print_json(arg); }
+
+static void test_output_json(void) {
+  ani_result *result;
+  int saved;
+  int devnull;
+
+  result = sample_result(false);
+  TEST_ASSERT_NOT_NULL(result);
+
+  // Rendered JSON goes to /dev/null; the report stream is a separate fd
+  fflush(stdout);
+  saved = dup(STDOUT_FILENO);
+  devnull = open("/dev/null", O_WRONLY);
+  TEST_ASSERT_TRUE(saved >= 0 && devnull >= 0);
+  dup2(devnull, STDOUT_FILENO);
+  close(devnull);
+
+  bench_run("output/print_json", bench_output_json, result);
+
+  fflush(stdout);
+  dup2(saved, STDOUT_FILENO);
+  close(saved);
+  ani_result_free(result);
+}
+
+// --- model alloc/free ---
+
+static void bench_model(void *arg) {
+  ani_result *result;
+
+  result = sample_result(arg != NULL);
+  sink += result != NULL;
+  ani_result_free(result);
+}
+
+static void bench_series(void *arg) {
+  ani_series *series;
+
+  (void)arg;
+  series = ani_series_new();
+  sink += series != NULL;
+  ani_series_free(series);
+}
+
+static void test_model(void) {
+  bench_run("model/series_new_free", bench_series, NULL);
+  bench_run("model/result_populated", bench_model, NULL);
+  bench_run("model/result_populated_arena", bench_model, "arena");
+}
+
+// --- setup ---
+
+static bool load_fixtures(void) {
+  char file[128];
+  char *path;
+  size_t i;
+
+  for (i = 0; i < FIXTURE_COUNT; i++) {
+    snprintf(file, sizeof(file), "%s.json", fixture_names[i]);
+    path = ani_path_join(fixtures_dir, file);
+    fixtures[i].data = path != NULL ? ani_read_file(path, &fixtures[i].len)
+                                    : NULL;
+    if (fixtures[i].data == NULL) {
+      fprintf(stderr, "Error: cannot read fixture %s\n",
+              path != NULL ? path : file);
+      ani_free(path);
+
+      return false;
+    }
+    ani_free(path);
+  }
+
+  return true;
+}
+
+// Point the cache at a scratch directory so runs never touch the real one
+static bool setup_cache(void) {
+  const char *tmp;
+  char template_path[512];
+
+  tmp = getenv("TMPDIR");
+  snprintf(template_path, sizeof(template_path), "%s/ani-bench-XXXXXX",
+           tmp != NULL && tmp[0] != '\0' ? tmp : "/tmp");
+  if (mkdtemp(template_path) == NULL) {
+    perror("mkdtemp");
+
+    return false;
+  }
+  bench_tmp_dir = ani_strdup(template_path);
+
+  bench_cache = ani_cache_open(bench_tmp_dir);
+  return bench_cache != NULL;
+}
+
+static void cleanup_cache(void) {
+  char *path;
+
+  if (bench_tmp_dir == NULL) {
+    return;
+  }
+
+  path = ani_path_join(bench_tmp_dir, "bench_search.json");
+  if (path != NULL) {
+    remove(path);
+  }
+  ani_free(path);
+  path = ani_path_join(bench_tmp_dir, "titles.idx");
+  if (path != NULL) {
+    remove(path);
+  }
+  ani_free(path);
+
+  ani_cache_close(bench_cache);
+  bench_cache = NULL;
+  rmdir(bench_tmp_dir);
+  ani_free(bench_tmp_dir);
+  bench_tmp_dir = NULL;
+}
+
+static double object_get_real(yyjson_val *obj, const char *key) {
+  yyjson_val *val = yyjson_obj_get(obj, key);
+
+  return yyjson_is_num(val) ? yyjson_get_num(val) : -1.0;
+}
+
+static bool load_baseline(const char *path) {
+  yyjson_doc *doc;
+  yyjson_val *arr;
+  size_t i;
+
+  doc = yyjson_read_file(path, 0, NULL, NULL);
+  arr = doc != NULL ? yyjson_obj_get(yyjson_doc_get_root(doc), "benchmarks")
+                    : NULL;
+  if (!yyjson_is_arr(arr)) {
+    fprintf(stderr, "Error: %s is not a benchmark JSON file\n", path);
+    yyjson_doc_free(doc);
+
+    return false;
+  }
+
+  for (i = 0; i < yyjson_arr_size(arr) && baseline_count < MAX_RESULTS; i++) {
+    yyjson_val *item = yyjson_arr_get(arr, i);
+    bench_result *b = &baseline[baseline_count];
+    const char *name = yyjson_get_str(yyjson_obj_get(item, "name"));
+
+    if (name == NULL) {
+      continue;
+    }
+    ani_strlcpy(b->name, name, sizeof(b->name));
+    b->ns_per_op = object_get_real(item, "ns_per_op");
+    b->allocs_per_op = object_get_real(item, "allocs_per_op");
+    b->bytes_per_op = object_get_real(item, "bytes_per_op");
+    baseline_count++;
+  }
+
+  yyjson_doc_free(doc);
+  return true;
+}
+
+static bool write_results(const char *path) {
+  yyjson_mut_doc *doc;
+  yyjson_mut_val *root;
+  yyjson_mut_val *arr;
+  size_t i;
+  bool ok;
+
+  doc = yyjson_mut_doc_new(NULL);
+  if (doc == NULL) {
+    return false;
+  }
+  root = yyjson_mut_obj(doc);
+  yyjson_mut_doc_set_root(doc, root);
+  arr = yyjson_mut_arr(doc);
+
+  for (i = 0; i < result_count; i++) {
+    const bench_result *r = &results[i];
+    yyjson_mut_val *item = yyjson_mut_obj(doc);
+
+    yyjson_mut_obj_add_str(doc, item, "name", r->name);
+    yyjson_mut_obj_add_real(doc, item, "ns_per_op", r->ns_per_op);
+    if (r->allocs_per_op >= 0.0) {
+      yyjson_mut_obj_add_real(doc, item, "allocs_per_op", r->allocs_per_op);
+      yyjson_mut_obj_add_real(doc, item, "bytes_per_op", r->bytes_per_op);
+    } else {
+      yyjson_mut_obj_add_null(doc, item, "allocs_per_op");
+      yyjson_mut_obj_add_null(doc, item, "bytes_per_op");
+    }
+    yyjson_mut_obj_add_uint(doc, item, "iterations", r->iterations);
+    yyjson_mut_arr_append(arr, item);
+  }
+  yyjson_mut_obj_add(root, yyjson_mut_str(doc, "benchmarks"), arr);
+
+  ok = yyjson_mut_write_file(path, doc, YYJSON_WRITE_PRETTY, NULL, NULL);
+  yyjson_mut_doc_free(doc);
+  return ok;
+}
+
+static void print_usage(const char *prog) {
+  printf("Usage: %s [options]\n\n", prog);
+  printf("Options:\n");
+  printf("  --json <file>        Write results as JSON\n");
+  printf("  --compare <file>     Fail cases that regressed against a baseline\n");
+  printf("  --threshold <pct>    Allowed slowdown for --compare (default: 10)\n");
+  printf("  --min-time <ms>      Time budget per case (default: 200)\n");
+  printf("  --filter <substr>    Only run cases whose name contains substr\n");
+  printf("  --fixtures <dir>     Payload directory (default: %s)\n",
+         ANI_BENCH_FIXTURES_DIR);
+}
+
+int main(int argc, char **argv) {
+  int failures;
+  int i;
+
+  for (i = 1; i < argc; i++) {
+    bool has_arg = i + 1 < argc;
+
+    if (strcmp(argv[i], "--json") == 0 && has_arg) {
+      json_path = argv[++i];
+    } else if (strcmp(argv[i], "--compare") == 0 && has_arg) {
+      compare_path = argv[++i];
+    } else if (strcmp(argv[i], "--threshold") == 0 && has_arg) {
+      threshold_pct = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--min-time") == 0 && has_arg) {
+      min_time_ns = (int64_t)atol(argv[++i]) * 1000000;
+    } else if (strcmp(argv[i], "--filter") == 0 && has_arg) {
+      filter = argv[++i];
+    } else if (strcmp(argv[i], "--fixtures") == 0 && has_arg) {
+      fixtures_dir = argv[++i];
+    } else {
+      print_usage(argv[0]);
+
+      return strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0
+                 ? 0
+                 : 1;
+    }
+  }
+
+  if (min_time_ns <= 0) {
+    min_time_ns = 200000000;
+  }
+
+  // Installed before anything allocates, removed after everything is freed
+  ani_alloc_counter_init(&alloc_counter, NULL);
+  {
+    ani_allocator counting = ani_alloc_counter_allocator(&alloc_counter);
+    ani_set_allocator(&counting);
+  }
+
+  // Quiet: benchmarks exercise warning paths (cache misses) on purpose
+  ani_log_set_level(ANI_LOG_ERROR);
+
+  // Report through its own fd so benchmarks may redirect stdout
+  report = fdopen(dup(STDOUT_FILENO), "w");
+  if (report == NULL) {
+    report = stderr;
+  }
+
+  if (!load_fixtures() || !setup_cache()) {
+    cleanup_cache();
+
+    return 1;
+  }
+  if (compare_path != NULL && !load_baseline(compare_path)) {
+    cleanup_cache();
+
+    return 1;
+  }
+
+  UNITY_BEGIN();
+  RUN_TEST(test_json_parse);
+  RUN_TEST(test_iso8601);
+  RUN_TEST(test_url_encode);
+  RUN_TEST(test_str_kernels);
+  RUN_TEST(test_cache);
+  RUN_TEST(test_index);
+  RUN_TEST(test_calendar);
+  RUN_TEST(test_output_json);
+  RUN_TEST(test_model);
+  failures = UNITY_END();
+
+  if (json_path != NULL && !write_results(json_path)) {
+    fprintf(stderr, "Error: failed to write %s\n", json_path);
+    failures++;
+  }
+
+  cleanup_cache();
+  for (i = 0; i < (int)FIXTURE_COUNT; i++) {
+    ani_free(fixtures[i].data);
+  }
+  if (report != stderr) {
+    fclose(report);
+  }
+  ani_set_allocator(NULL);
+
+  return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,511 @@
+/*
+ * Routine: ani — Anime/Manga scheduling information CLI
+ * Author: DannyBimma
+ * Copyright: (c) 2025 Technomancer Pirate Captain. All Rights Reserved.
+ */
+
+// ani_stub_server — local stand-in for the Jikan, AniList and MangaDex APIs.
+//
+// Routes (point ani at them with the base URL environment variables):
+//   ANI_JIKAN_URL=http://127.0.0.1:PORT/jikan
+//   ANI_ANILIST_URL=http://127.0.0.1:PORT/anilist
+//   ANI_MANGADEX_URL=http://127.0.0.1:PORT/mangadex
+//
+// Responses come from the fixtures directory (bench/fixtures by default, or
+// bodies pulled out of ANI_HTTP_RECORD captures). Each provider has a
+// per-minute rate limit that answers 429 with Retry-After, and an optional
+// random 5xx rate, so retry and backoff paths run like they do live.
+// GET /stats returns served, rate-limited and failed counts per provider.
+
+#include <errno.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_REQUEST 65536
+
+// Provider routes
+typedef enum { ROUTE_JIKAN, ROUTE_ANILIST, ROUTE_MANGADEX, ROUTE_COUNT } route;
+
+static const char *const route_prefixes[ROUTE_COUNT] = {"/jikan", "/anilist",
+                                                        "/mangadex"};
+
+typedef struct {
+  const char *path_prefix; // Request path prefix served by this endpoint
+  const char *fixture;     // File name inside the fixtures directory
+  const char *fallback;    // Body used when the fixture is missing
+  char *body;
+  size_t body_len;
+} stub_endpoint;
+
+static stub_endpoint endpoints[] = {
+    {"/jikan/anime", "jikan_search.json", "{\"data\":[]}", NULL, 0},
+    {"/anilist", "anilist_media.json", "{\"data\":{\"Media\":null}}", NULL, 0},
+    {"/mangadex/manga", "mangadex_search.json", "{\"data\":[]}", NULL, 0},
+    {"/mangadex/chapter", "mangadex_chapter.json", "{\"data\":[]}", NULL, 0},
+};
+
+#define ENDPOINT_COUNT (sizeof(endpoints) / sizeof(endpoints[0]))
+
+// Server settings
+static int port = 8088;
+static const char *fixtures_dir = "bench/fixtures";
+static long latency_ms = 0;
+static long jitter_ms = 0;
+static double error_rate = 0.0;
+static long rate_limits[ROUTE_COUNT] = {60, 90, 300}; // Requests per minute
+static bool verbose = false;
+
+// Shared state
+static pthread_mutex_t state_lock = PTHREAD_MUTEX_INITIALIZER;
+static time_t window_start[ROUTE_COUNT];
+static long window_count[ROUTE_COUNT];
+static uint64_t rng_state = 0x9e3779b97f4a7c15ULL;
+static uint64_t served[ROUTE_COUNT];
+static uint64_t limited[ROUTE_COUNT];
+static uint64_t failed[ROUTE_COUNT];
+
+static uint64_t next_random(void) {
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 7;
+  rng_state ^= rng_state << 17;
+
+  return rng_state;
+}
+
+static char *load_file(const char *dir, const char *name, size_t *len_out) {
+  char path[1024];
+  FILE *f;
+  long size;
+  char *data;
+
+  snprintf(path, sizeof(path), "%s/%s", dir, name);
+  f = fopen(path, "rb");
+  if (f == NULL) {
+    return NULL;
+  }
+
+  if (fseek(f, 0, SEEK_END) != 0 || (size = ftell(f)) < 0 ||
+      fseek(f, 0, SEEK_SET) != 0) {
+    fclose(f);
+
+    return NULL;
+  }
+
+  data = malloc((size_t)size + 1);
+  if (data == NULL || fread(data, 1, (size_t)size, f) != (size_t)size) {
+    free(data);
+    fclose(f);
+
+    return NULL;
+  }
+  fclose(f);
+
+  data[size] = '\0';
+  *len_out = (size_t)size;
+
+  return data;
+}
+
+static void load_fixtures(void) {
+  size_t i;
+
+  for (i = 0; i < ENDPOINT_COUNT; i++) {
+    endpoints[i].body =
+        load_file(fixtures_dir, endpoints[i].fixture, &endpoints[i].body_len);
+    if (endpoints[i].body == NULL) {
+      fprintf(stderr, "stub: %s/%s missing, using empty fallback\n",
+              fixtures_dir, endpoints[i].fixture);
+      endpoints[i].body = strdup(endpoints[i].fallback);
+      endpoints[i].body_len = strlen(endpoints[i].fallback);
+    }
+  }
+}
+
+static int route_for_path(const char *path) {
+  int i;
+
+  for (i = 0; i < ROUTE_COUNT; i++) {
+    size_t len = strlen(route_prefixes[i]);
+    if (strncmp(path, route_prefixes[i], len) == 0 &&
+        (path[len] == '/' || path[len] == '?' || path[len] == '\0')) {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+static const stub_endpoint *endpoint_for_path(const char *path) {
+  size_t i;
+
+  for (i = 0; i < ENDPOINT_COUNT; i++) {
+    size_t len = strlen(endpoints[i].path_prefix);
+    if (strncmp(path, endpoints[i].path_prefix, len) == 0) {
+      return &endpoints[i];
+    }
+  }
+
+  return NULL;
+}
+
+static void sleep_ms(long ms) {
+  struct timespec ts;
+
+  if (ms <= 0) {
+    return;
+  }
+
+  ts.tv_sec = ms / 1000;
+  ts.tv_nsec = (ms % 1000) * 1000000L;
+  nanosleep(&ts, NULL);
+}
+
+static bool write_all(int fd, const char *data, size_t len) {
+  while (len > 0) {
+    ssize_t n = write(fd, data, len);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      return false;
+    }
+    data += n;
+    len -= (size_t)n;
+  }
+
+  return true;
+}
+
+static void send_response(int fd, int status, const char *reason,
+                          const char *extra_headers, const char *body,
+                          size_t body_len) {
+  char header[1024];
+  int n;
+
+  n = snprintf(header, sizeof(header),
+               "HTTP/1.1 %d %s\r\n"
+               "Content-Type: application/json\r\n"
+               "Content-Length: %zu\r\n"
+               "Connection: close\r\n"
+               "%s"
+               "\r\n",
+               status, reason, body_len, extra_headers);
+  if (n < 0 || (size_t)n >= sizeof(header)) {
+    return;
+  }
+
+  if (write_all(fd, header, (size_t)n)) {
+    write_all(fd, body, body_len);
+  }
+}
+
+// Read one request; returns the request line path in path_out
+static bool read_request(int fd, char *buf, size_t size, char *method_out,
+                         char *path_out, size_t path_size) {
+  size_t used;
+  char *header_end;
+  char *cl;
+  size_t content_length;
+  size_t have;
+  char fmt[32];
+
+  used = 0;
+  header_end = NULL;
+  while (header_end == NULL) {
+    ssize_t n;
+
+    if (used + 1 >= size) {
+      return false;
+    }
+    n = read(fd, buf + used, size - used - 1);
+    if (n <= 0) {
+      return false;
+    }
+    used += (size_t)n;
+    buf[used] = '\0';
+    header_end = strstr(buf, "\r\n\r\n");
+  }
+
+  snprintf(fmt, sizeof(fmt), "%%15s %%%zus", path_size - 1);
+  if (sscanf(buf, fmt, method_out, path_out) != 2) {
+    return false;
+  }
+
+  // Drain the body so the client sees a clean close
+  content_length = 0;
+  cl = strstr(buf, "Content-Length:");
+  if (cl == NULL) {
+    cl = strstr(buf, "content-length:");
+  }
+  if (cl != NULL) {
+    content_length = (size_t)strtoul(cl + 15, NULL, 10);
+  }
+
+  have = used - (size_t)(header_end + 4 - buf);
+  while (have < content_length) {
+    char sink[4096];
+    ssize_t n = read(fd, sink, sizeof(sink));
+    if (n <= 0) {
+      break;
+    }
+    have += (size_t)n;
+  }
+
+  return true;
+}
+
+static void *handle_connection(void *arg) {
+  int fd;
+  char *buf;
+  char method[16];
+  char path[2048];
+  char headers[256];
+  const stub_endpoint *ep;
+  int r;
+  long remaining;
+  long retry_after;
+  bool is_limited;
+  bool is_error;
+  long delay;
+  time_t now;
+
+  fd = (int)(intptr_t)arg;
+  buf = malloc(MAX_REQUEST);
+  if (buf == NULL) {
+    close(fd);
+
+    return NULL;
+  }
+
+  if (!read_request(fd, buf, MAX_REQUEST, method, path, sizeof(path))) {
+    free(buf);
+    close(fd);
+
+    return NULL;
+  }
+  free(buf);
+
+  // Counters for the load generator
+  if (strcmp(path, "/stats") == 0) {
+    char stats[512];
+    int n;
+
+    pthread_mutex_lock(&state_lock);
+    n = snprintf(stats, sizeof(stats),
+                 "{\"served\":[%llu,%llu,%llu],\"rate_limited\":[%llu,%llu,"
+                 "%llu],\"errors\":[%llu,%llu,%llu]}",
+                 (unsigned long long)served[0], (unsigned long long)served[1],
+                 (unsigned long long)served[2], (unsigned long long)limited[0],
+                 (unsigned long long)limited[1], (unsigned long long)limited[2],
+                 (unsigned long long)failed[0], (unsigned long long)failed[1],
+                 (unsigned long long)failed[2]);
+    pthread_mutex_unlock(&state_lock);
+    send_response(fd, 200, "OK", "", stats, (size_t)n);
+    close(fd);
+
+    return NULL;
+  }
+
+  r = route_for_path(path);
+  ep = endpoint_for_path(path);
+  if (r < 0 || ep == NULL) {
+    static const char not_found[] = "{\"error\":\"not found\"}";
+    send_response(fd, 404, "Not Found", "", not_found,
+                  sizeof(not_found) - 1);
+    close(fd);
+
+    return NULL;
+  }
+
+  // Rate limit window, error injection and think time
+  pthread_mutex_lock(&state_lock);
+  now = time(NULL);
+  if (now - window_start[r] >= 60) {
+    window_start[r] = now;
+    window_count[r] = 0;
+  }
+  window_count[r]++;
+  is_limited = rate_limits[r] > 0 && window_count[r] > rate_limits[r];
+  remaining = rate_limits[r] - window_count[r];
+  retry_after = 60 - (long)(now - window_start[r]);
+  is_error = !is_limited && error_rate > 0.0 &&
+             (double)(next_random() % 1000000) / 1e6 < error_rate;
+  delay = latency_ms;
+  if (jitter_ms > 0) {
+    delay += (long)(next_random() % (uint64_t)(2 * jitter_ms + 1)) - jitter_ms;
+  }
+  if (is_limited) {
+    limited[r]++;
+  } else if (is_error) {
+    failed[r]++;
+  } else {
+    served[r]++;
+  }
+  pthread_mutex_unlock(&state_lock);
+
+  sleep_ms(delay);
+
+  if (is_limited) {
+    static const char too_many[] =
+        "{\"status\":429,\"type\":\"RateLimitException\","
+        "\"message\":\"Too Many Requests\"}";
+    snprintf(headers, sizeof(headers),
+             "X-RateLimit-Limit: %ld\r\nX-RateLimit-Remaining: 0\r\n"
+             "Retry-After: %ld\r\n",
+             rate_limits[r], retry_after);
+    send_response(fd, 429, "Too Many Requests", headers, too_many,
+                  sizeof(too_many) - 1);
+  } else if (is_error) {
+    static const char unavailable[] =
+        "{\"status\":503,\"message\":\"Service Unavailable\"}";
+    send_response(fd, 503, "Service Unavailable", "", unavailable,
+                  sizeof(unavailable) - 1);
+  } else {
+    snprintf(headers, sizeof(headers),
+             "X-RateLimit-Limit: %ld\r\nX-RateLimit-Remaining: %ld\r\n",
+             rate_limits[r], remaining < 0 ? 0 : remaining);
+    send_response(fd, 200, "OK", headers, ep->body, ep->body_len);
+  }
+
+  if (verbose) {
+    fprintf(stderr, "stub: %s %s -> %d\n", method, path,
+            is_limited ? 429 : (is_error ? 503 : 200));
+  }
+
+  close(fd);
+  return NULL;
+}
+
+static void print_usage(const char *prog) {
+  printf("Usage: %s [options]\n\n", prog);
+  printf("Options:\n");
+  printf("  --port <n>           Listen port (default: 8088)\n");
+  printf("  --fixtures <dir>     Response bodies (default: bench/fixtures)\n");
+  printf("  --latency <ms>       Server think time per request\n");
+  printf("  --jitter <ms>        Uniform +/- jitter on the think time\n");
+  printf("  --error-rate <f>     Fraction of requests answered with 503\n");
+  printf("  --rate-limit <p=n>   Requests/minute for jikan|anilist|mangadex\n");
+  printf("                       (0 disables, defaults: 60, 90, 300)\n");
+  printf("  -v, --verbose        Log every request\n");
+}
+
+static bool parse_rate_limit(const char *spec) {
+  const char *eq;
+  int i;
+
+  eq = strchr(spec, '=');
+  if (eq == NULL) {
+    return false;
+  }
+
+  for (i = 0; i < ROUTE_COUNT; i++) {
+    const char *name = route_prefixes[i] + 1;
+    if (strlen(name) == (size_t)(eq - spec) &&
+        strncmp(spec, name, (size_t)(eq - spec)) == 0) {
+      rate_limits[i] = atol(eq + 1);
+
+      return true;
+    }
+  }
+
+  return false;
+}
+
+int main(int argc, char **argv) {
+  struct sockaddr_in addr;
+  int server_fd;
+  int opt;
+  int i;
+
+  for (i = 1; i < argc; i++) {
+    bool has_arg = i + 1 < argc;
+
+    if (strcmp(argv[i], "--port") == 0 && has_arg) {
+      port = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--fixtures") == 0 && has_arg) {
+      fixtures_dir = argv[++i];
+    } else if (strcmp(argv[i], "--latency") == 0 && has_arg) {
+      latency_ms = atol(argv[++i]);
+    } else if (strcmp(argv[i], "--jitter") == 0 && has_arg) {
+      jitter_ms = atol(argv[++i]);
+    } else if (strcmp(argv[i], "--error-rate") == 0 && has_arg) {
+      error_rate = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--rate-limit") == 0 && has_arg) {
+      if (!parse_rate_limit(argv[++i])) {
+        fprintf(stderr, "Error: bad --rate-limit: %s\n", argv[i]);
+
+        return 1;
+      }
+    } else if (strcmp(argv[i], "-v") == 0 ||
+               strcmp(argv[i], "--verbose") == 0) {
+      verbose = true;
+    } else {
+      print_usage(argv[0]);
+
+      return strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0
+                 ? 0
+                 : 1;
+    }
+  }
+
+  load_fixtures();
+  signal(SIGPIPE, SIG_IGN);
+
+  server_fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (server_fd < 0) {
+    perror("socket");
+
+    return 1;
+  }
+
+  opt = 1;
+  setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons((uint16_t)port);
+
+  if (bind(server_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+      listen(server_fd, 128) != 0) {
+    perror("bind/listen");
+    close(server_fd);
+
+    return 1;
+  }
+
+  fprintf(stderr, "stub: listening on http://127.0.0.1:%d\n", port);
+
+  for (;;) {
+    pthread_t thread;
+    int client_fd = accept(server_fd, NULL, NULL);
+
+    if (client_fd < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      perror("accept");
+      break;
+    }
+
+    if (pthread_create(&thread, NULL, handle_connection,
+                       (void *)(intptr_t)client_fd) != 0) {
+      close(client_fd);
+      continue;
+    }
+    pthread_detach(thread);
+  }
+
+  close(server_fd);
+  return 0;
+}
@@ -0,0 +1,89 @@
+/*
+ * Routine: ani — Anime/Manga scheduling information CLI
+ * Author: DannyBimma
+ * Copyright: (c) 2025 Technomancer Pirate Captain. All Rights Reserved.
+ */
+
+#ifndef ANI_ALLOC_H
+#define ANI_ALLOC_H
+
+#include "ani/arena.h"
+#include "ani/thread.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Process-wide allocator used by ani itself, by yyjson (through
+// ani_json_alc) and by libcurl (through curl_global_init_mem).
+//
+// Install it before the first ani_ctx_new (or ani_http_init) and keep it
+// until the last context is gone: memory is always returned to the
+// allocator that handed it out, so swapping allocators under live objects
+// corrupts both.
+
+typedef struct {
+  void *(*malloc_fn)(void *ctx, size_t size);
+  void *(*realloc_fn)(void *ctx, void *ptr, size_t size);
+  void (*free_fn)(void *ctx, void *ptr);
+  void *ctx;
+} ani_allocator;
+
+// Install allocator (NULL restores the libc allocator)
+void ani_set_allocator(const ani_allocator *allocator);
+
+// Currently installed allocator
+ani_allocator ani_get_allocator(void);
+
+// The libc allocator
+ani_allocator ani_libc_allocator(void);
+
+// Allocation entry points for all ani code
+void *ani_malloc(size_t size);
+void *ani_calloc(size_t count, size_t size);
+void *ani_realloc(void *ptr, size_t size);
+void ani_free(void *ptr);
+
+// Counting allocator: forwards to a parent and keeps statistics. Counters
+// are updated atomically, so one counter can serve many threads.
+typedef struct {
+  uint64_t allocs;     // malloc/calloc calls
+  uint64_t reallocs;   // realloc calls (including realloc(NULL, n))
+  uint64_t frees;      // free calls with a non-NULL pointer
+  uint64_t bytes;      // Total bytes requested by malloc/calloc/realloc
+  uint64_t live_bytes; // Bytes currently allocated
+  uint64_t peak_bytes; // High-water mark of live_bytes
+} ani_alloc_stats;
+
+typedef struct {
+  ani_allocator parent;
+  ani_alloc_stats stats;
+} ani_alloc_counter;
+
+// Start counting on top of parent (NULL wraps the current allocator)
+void ani_alloc_counter_init(ani_alloc_counter *counter,
+                            const ani_allocator *parent);
+
+// Allocator view of a counter, ready for ani_set_allocator
+ani_allocator ani_alloc_counter_allocator(ani_alloc_counter *counter);
+
+// Consistent-enough snapshot of the counters
+void ani_alloc_counter_stats(ani_alloc_counter *counter, ani_alloc_stats *out);
+
+// Bump allocator: serves everything from an arena and never frees until
+// ani_bump_destroy. Suits one-shot runs (the CLI) and per-query scratch.
+// A lock makes it safe to install process-wide.
+typedef struct {
+  ani_arena *arena;
+  ani_mutex lock;
+} ani_bump;
+
+// Create the arena (block_size 0 for the default); false on failure
+bool ani_bump_init(ani_bump *bump, size_t block_size);
+
+// Release everything the bump allocator handed out
+void ani_bump_destroy(ani_bump *bump);
+
+// Allocator view of a bump allocator, ready for ani_set_allocator
+ani_allocator ani_bump_allocator(ani_bump *bump);
+
+#endif // ANI_ALLOC_H
@@ -0,0 +1,129 @@
+/*
+ * Routine: ani — Anime/Manga scheduling information CLI
+ * Author: DannyBimma
+ * Copyright: (c) 2025 Technomancer Pirate Captain. All Rights Reserved.
+ */
+
+#ifndef ANI_ANI_H
+#define ANI_ANI_H
+
+#include "ani/calendar.h"
+#include "ani/index.h"
+#include "ani/log.h"
+#include "ani/models.h"
+#include <stdbool.h>
+
+// Embeddable lookup API (libani).
+//
+//   ani_ctx *ctx = ani_ctx_new(NULL);
+//   ani_result *result;
+//   if (ani_lookup(ctx, "Frieren", ANI_LOOKUP_ANIME, &result)) {
+//     ... result->anime ...
+//     ani_result_free(result);
+//   }
+//   ani_ctx_free(ctx);
+//
+// A context owns the HTTP connection pool, cache handle, title index, rate
+// limiter and logger. ani_lookup may be called on one context from many
+// threads at once. Creating and freeing contexts is not thread-safe: do it
+// from one thread (the first context initializes libcurl globally).
+
+// Opaque lookup context
+typedef struct ani_ctx ani_ctx;
+
+// Lookup flags (neither ANIME nor MANGA means both)
+#define ANI_LOOKUP_ANIME 0x1u
+#define ANI_LOOKUP_MANGA 0x2u
+#define ANI_LOOKUP_ALL (ANI_LOOKUP_ANIME | ANI_LOOKUP_MANGA)
+#define ANI_LOOKUP_ARENA 0x4u   // Allocate the result in its own arena
+#define ANI_LOOKUP_REFRESH 0x8u // Skip local resolution, ask the providers
+// Leave anime schedules and manga chapters to ani_fill_schedules (batch runs)
+#define ANI_LOOKUP_DEFER_SCHEDULE 0x10u
+// Search AniList by title beside Jikan instead of after it (one round trip)
+#define ANI_LOOKUP_PARALLEL 0x20u
+// Estimate the next episode from the broadcast slot instead of asking AniList
+#define ANI_LOOKUP_BROADCAST 0x40u
+
+// Context options; start from ani_ctx_options_init
+typedef struct {
+  long timeout_ms;         // Overall HTTP timeout, <= 0 for the default
+  long connect_timeout_ms; // Connect timeout, <= 0 for the default
+  int max_retries;         // Retries on 429/5xx, < 0 for the default
+  const char *cache_dir;   // NULL for the per-OS default
+  bool rate_limit;         // Pace requests to provider limits (default: on)
+  bool title_index;        // Resolve repeat queries locally (default: on)
+  bool circuit_breaker;    // Fail fast on providers found down (default: on)
+  long hedge_ms;           // Hedge title searches slower than this, <= 0 off
+  double hedge_quantile;   // Once known, hedge at this latency quantile
+  bool estimates;          // Estimate unpublished schedules (default: on)
+  long deadline_ms;        // Past this, estimate schedules locally; <= 0 off
+  ani_log_level log_level; // Default: the process level at init time
+  ani_log_fn log_fn;       // NULL writes to stderr
+  void *log_userdata;
+} ani_ctx_options;
+
+// Fill options with defaults
+void ani_ctx_options_init(ani_ctx_options *options);
+
+// Create a context (options may be NULL for defaults), NULL on failure
+ani_ctx *ani_ctx_new(const ani_ctx_options *options);
+
+// Wait for requests still running on ctx's behalf (the losing side of
+// hedged searches), so their timings, metrics and trace spans are recorded.
+// ani_ctx_free does this too.
+void ani_ctx_drain(ani_ctx *ctx);
+
+// Free a context (NULL is a no-op)
+void ani_ctx_free(ani_ctx *ctx);
+
+// Look up a title. On success *result_out is a new result the caller frees
+// with ani_result_free; has_anime/has_manga say which searches matched.
+// With ANI_LOOKUP_ARENA the result, its series and strings share one arena
+// and ani_result_free releases them in one go. Queries resolved before are
+// answered from the local title index without a search request unless
+// ANI_LOOKUP_REFRESH is set.
+// Returns false only for bad arguments or allocation failure.
+bool ani_lookup(ani_ctx *ctx, const char *query, unsigned int flags,
+                ani_result **result_out);
+
+// Provider ID kinds for ani_lookup_id
+typedef enum {
+  ANI_ID_MAL,     // MyAnimeList anime ID (details via Jikan)
+  ANI_ID_ANILIST, // AniList media ID
+  ANI_ID_MANGADEX // MangaDex manga UUID
+} ani_id_type;
+
+// Look up one series by provider ID without the title search. Details are
+// cached for ANI_CACHE_TTL_DETAILS and the schedule is fetched fresh; an
+// AniList ID gets both from one request, cached for ANI_CACHE_TTL_SCHEDULE.
+// ANI_LOOKUP_REFRESH skips the cache. The ID type decides anime or manga,
+// and result->query reads "mal:<id>", "anilist:<id>" or "mangadex:<uuid>".
+// Returns false for bad arguments (including malformed IDs) or allocation
+// failure.
+bool ani_lookup_id(ani_ctx *ctx, ani_id_type type, const char *id,
+                   unsigned int flags, ani_result **result_out);
+
+// Fetch the anime schedules and manga chapters left out by
+// ANI_LOOKUP_DEFER_SCHEDULE for all results at once: one AniList request per
+// 50 anime and one MangaDex request per 100 manga instead of one each (manga
+// keep the chapter count only once finished). Returns false if any request
+// failed (those series keep no schedule).
+bool ani_fill_schedules(ani_ctx *ctx, ani_result **results, size_t count);
+
+// Sync the airing calendar for the next days (clamped to 1 to
+// ANI_CALENDAR_DAYS_MAX) from AniList, a page of 50 episodes per request.
+// The cached snapshot is reused while it covers those days and is younger
+// than ANI_CACHE_TTL_SCHEDULE, unless refresh; if the sync fails the last
+// one is kept. Anime lookups on ctx then take their next episode from the
+// snapshot without a request. Returns a copy of the snapshot for the caller
+// to free with ani_calendar_free (lookups and syncs on other threads may
+// replace the context's own at any time), or NULL if there is none.
+ani_calendar *ani_sync_calendar(ani_ctx *ctx, int days, bool refresh);
+
+// Titles from the local index that resemble query (a prefix is enough),
+// best first, without any network access; flags select anime/manga as for
+// ani_lookup. Returns the number of matches written to out.
+size_t ani_suggest(ani_ctx *ctx, const char *query, unsigned int flags,
+                   ani_index_match *out, size_t max);
+
+#endif // ANI_ANI_H
@@ -0,0 +1,38 @@
+/*
+ * Routine: ani — Anime/Manga scheduling information CLI
+ * Author: DannyBimma
+ * Copyright: (c) 2025 Technomancer Pirate Captain. All Rights Reserved.
+ */
+
+#ifndef ANI_ARENA_H
+#define ANI_ARENA_H
+
+#include <stddef.h>
+
+// Bump allocator: many small allocations, one release. Not thread-safe;
+// give each thread (or each result) its own arena.
+
+typedef struct ani_arena ani_arena;
+
+// Create an arena; block_size 0 picks the default (4 KiB)
+ani_arena *ani_arena_new(size_t block_size);
+
+// Release every allocation and the arena itself (NULL is a no-op)
+void ani_arena_free(ani_arena *arena);
+
+// Drop all allocations but keep the first block for reuse
+void ani_arena_reset(ani_arena *arena);
+
+// Zeroed, pointer-aligned allocation (NULL on failure)
+void *ani_arena_alloc(ani_arena *arena, size_t size);
+
+// Copy a string into the arena (NULL in, NULL out)
+char *ani_arena_strdup(ani_arena *arena, const char *s);
+
+// Copy at most n bytes of s into the arena, always terminated
+char *ani_arena_strndup(ani_arena *arena, const char *s, size_t n);
+
+// Bytes handed out since creation or the last reset
+size_t ani_arena_used(const ani_arena *arena);
+
+#endif // ANI_ARENA_H
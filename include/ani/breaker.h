@@ -0,0 +1,50 @@
+/*
+ * Routine: ani — Anime/Manga scheduling information CLI
+ * Author: DannyBimma
+ * Copyright: (c) 2025 Technomancer Pirate Captain. All Rights Reserved.
+ */
+
+#ifndef ANI_BREAKER_H
+#define ANI_BREAKER_H
+
+#include <stdbool.h>
+
+// Per-provider circuit breaker plus a retry budget shared by all providers.
+//
+// A provider's circuit opens after 5 failed attempts in a row (transport
+// errors and 5xx; a 429 means it is up). While open, requests fail at once
+// instead of spending the timeout and retry sequence. After a cooldown
+// (30 s, doubling up to 5 min while probes keep failing) one probe request
+// is let through: success closes the circuit, failure reopens it.
+//
+// Retries draw from a budget that every five first attempts top up by one,
+// so retries stay near 20% of requests (with a burst of 10).
+//
+// State is kept in breaker.state in the given directory, so short-lived
+// processes sharing a cache directory share what they have learned. It is
+// written only when a circuit changes state, merged with the file: for each
+// provider the most recent change wins. Safe to share between threads.
+
+typedef struct ani_breaker ani_breaker;
+
+// Create a breaker, loading state from dir (NULL keeps it in memory only)
+ani_breaker *ani_breaker_new(const char *dir);
+
+// Save state and free the breaker (NULL is a no-op)
+void ani_breaker_free(ani_breaker *breaker);
+
+// Whether a first attempt to provider may go out. Lets one probe through
+// once an open circuit has cooled down. A NULL breaker allows everything.
+bool ani_breaker_allow(ani_breaker *breaker, const char *provider);
+
+// Whether a retry to provider may go out: its circuit is closed and the
+// retry budget has a token, which is spent
+bool ani_breaker_retry(ani_breaker *breaker, const char *provider);
+
+// Record the outcome of one attempt to provider
+void ani_breaker_record(ani_breaker *breaker, const char *provider, bool ok);
+
+// Whether provider's circuit is open and still cooling down
+bool ani_breaker_is_open(ani_breaker *breaker, const char *provider);
+
+#endif // ANI_BREAKER_H
@@ -0,0 +1,25 @@
+/*
+ * Routine: ani — Anime/Manga scheduling information CLI
+ * Author: DannyBimma
+ * Copyright: (c) 2025 Technomancer Pirate Captain. All Rights Reserved.
+ */
+
+#ifndef ANI_BROADCAST_H
+#define ANI_BROADCAST_H
+
+#include "ani/models.h"
+#include <stdbool.h>
+#include <time.h>
+
+// Next episode of an airing anime worked out from its weekly broadcast slot
+// in Japan, without asking AniList.
+//
+// Episodes are counted as one per weekly slot since the premiere, so breaks
+// and double episodes put the count off; hence ANI_CONFIDENCE_ESTIMATED.
+
+// Fill release's latest and next episode from release->broadcast as of now,
+// unless it already has a next episode. Returns false when the series is
+// not airing, its slot or premiere is unknown, or every episode has aired.
+bool ani_broadcast_estimate(time_t now, ani_release_info *release);
+
+#endif // ANI_BROADCAST_H
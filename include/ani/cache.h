@@ -12,20 +12,33 @@
 #include <time.h>
 
 // Cache entry TTLs (in seconds)
-#define ANI_CACHE_TTL_SEARCH 300    // 5 minutes
-#define ANI_CACHE_TTL_DETAILS 21600 // 6 hours
-#define ANI_CACHE_TTL_SCHEDULE 1800 // 30 minutes
+#define ANI_CACHE_TTL_SEARCH 300       // 5 minutes
+#define ANI_CACHE_TTL_DETAILS 21600    // 6 hours
+#define ANI_CACHE_TTL_SCHEDULE 1800    // 30 minutes
+#define ANI_CACHE_TTL_STALE 604800     // 7 days, while a provider is down
+#define ANI_CACHE_TTL_HISTORY 31536000 // 1 year, release histories
 
-// Initialize cache directory
-bool ani_cache_init(void);
+// Opaque cache handle (one per context; safe to share between threads)
+typedef struct ani_cache ani_cache;
+
+// Open a cache rooted at dir (NULL for the per-OS default), creating it
+ani_cache *ani_cache_open(const char *dir);
+
+// Close a cache handle (NULL is a no-op)
+void ani_cache_close(ani_cache *cache);
+
+// Cache directory of an open cache
+const char *ani_cache_dir(const ani_cache *cache);
 
 // Get cached data if valid
-char *ani_cache_get(const char *provider, const char *key, time_t max_age);
+char *ani_cache_get(ani_cache *cache, const char *provider, const char *key,
+                    time_t max_age);
 
-// Store data in cache
-bool ani_cache_set(const char *provider, const char *key, const char *data);
+// Store data in cache (atomically replaces any previous entry)
+bool ani_cache_set(ani_cache *cache, const char *provider, const char *key,
+                   const char *data);
 
 // Clear all cache
-void ani_cache_clear(void);
+void ani_cache_clear(ani_cache *cache);
 
 #endif // ANI_CACHE_H
@@ -0,0 +1,62 @@
+/*
+ * Routine: ani — Anime/Manga scheduling information CLI
+ * Author: DannyBimma
+ * Copyright: (c) 2025 Technomancer Pirate Captain. All Rights Reserved.
+ */
+
+#ifndef ANI_CADENCE_H
+#define ANI_CADENCE_H
+
+#include "ani/cache.h"
+#include "ani/models.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+// Release cadence of a series that publishes no schedule (manga), estimated
+// from the publish times of its recent chapters.
+//
+// The history holds the last ANI_CADENCE_MAX chapters seen, oldest first,
+// and lives in the cache as a few lines of text per series, updated as new
+// chapters turn up. Chapters published within a day of each other count as
+// one release. The estimate is the median gap between releases, snapped to
+// weekly, biweekly or monthly when close; a series silent for more than
+// three gaps is taken to be on hiatus and gets no estimate.
+
+#define ANI_CADENCE_MAX 16       // Chapters kept per series
+#define ANI_CADENCE_MIN_GAPS 3   // Gaps between releases needed to estimate
+
+typedef struct {
+  int number;        // Chapter number
+  int64_t published; // Seconds since the epoch
+} ani_cadence_entry;
+
+typedef struct {
+  ani_cadence_entry entries[ANI_CADENCE_MAX]; // Oldest first
+  size_t count;
+  bool seeded; // Backfilled from the provider once; not asked again
+} ani_cadence;
+
+// Load the history of provider's series id (empty if none is cached)
+void ani_cadence_load(ani_cache *cache, const char *provider, const char *id,
+                      ani_cadence *history);
+
+// Store the history of provider's series id
+bool ani_cadence_save(ani_cache *cache, const char *provider, const char *id,
+                      const ani_cadence *history);
+
+// Add a chapter, dropping the oldest when full. Returns false if it was
+// already known (or is too old to keep).
+bool ani_cadence_add(ani_cadence *history, int number, int64_t published);
+
+// Whether the history has enough releases to estimate from
+bool ani_cadence_ready(const ani_cadence *history);
+
+// Fill release's next chapter and date from the history as of now, unless
+// it already has a next release. Returns false when there is too little
+// history or the series looks to be on hiatus.
+bool ani_cadence_estimate(const ani_cadence *history, time_t now,
+                          ani_release_info *release);
+
+#endif // ANI_CADENCE_H
@@ -0,0 +1,77 @@
+/*
+ * Routine: ani — Anime/Manga scheduling information CLI
+ * Author: DannyBimma
+ * Copyright: (c) 2025 Technomancer Pirate Captain. All Rights Reserved.
+ */
+
+#ifndef ANI_CALENDAR_H
+#define ANI_CALENDAR_H
+
+#include "ani/arena.h"
+#include "ani/cache.h"
+#include "ani/models.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Airing calendar: every episode AniList has scheduled in a window of time,
+// fetched a page at a time and kept in the cache as one snapshot (a line of
+// text per episode). Per-title lookups that find their series in the
+// snapshot need no request of their own.
+
+#define ANI_CALENDAR_DAYS_MAX 14 // Longest window that can be synced
+
+// One scheduled episode
+typedef struct {
+  int64_t airing_at; // Seconds since the epoch
+  int episode;
+  long mal_id; // 0 if AniList has none
+  long anilist_id;
+  int episodes;      // Total episodes, -1 if unknown
+  const char *title; // Held by the calendar's arena
+} ani_airing;
+
+typedef struct {
+  int64_t fetched; // When the window was fetched
+  int64_t from;    // Window, seconds since the epoch
+  int64_t to;
+  ani_airing *entries; // Sorted by airing time once complete
+  size_t count;
+  size_t capacity;
+  ani_arena *arena;
+} ani_calendar;
+
+// Empty calendar for the window [from, to), NULL on allocation failure
+ani_calendar *ani_calendar_new(int64_t from, int64_t to);
+
+// Deep copy of calendar, NULL on allocation failure (or for NULL)
+ani_calendar *ani_calendar_copy(const ani_calendar *calendar);
+
+// Free a calendar (NULL is a no-op)
+void ani_calendar_free(ani_calendar *calendar);
+
+// Add an episode (title is copied)
+bool ani_calendar_add(ani_calendar *calendar, int64_t airing_at, int episode,
+                      long mal_id, long anilist_id, int episodes,
+                      const char *title);
+
+// Sort the entries by airing time
+void ani_calendar_sort(ani_calendar *calendar);
+
+// Load the cached snapshot, NULL if there is none
+ani_calendar *ani_calendar_load(ani_cache *cache);
+
+// Store calendar as the snapshot
+bool ani_calendar_save(ani_cache *cache, const ani_calendar *calendar);
+
+// First episode of the series with this MAL ID airing after now, or NULL
+const ani_airing *ani_calendar_next(const ani_calendar *calendar,
+                                    const char *mal_id, int64_t now);
+
+// Fill release's next episode (and the one before it) for the series with
+// this MAL ID from the calendar, as AniList would. False if the calendar
+// has no episode of it airing after now.
+bool ani_calendar_fill(const ani_calendar *calendar, const char *mal_id,
+                       int64_t now, ani_release_info *release);
+
+#endif // ANI_CALENDAR_H
@@ -18,8 +18,22 @@ typedef struct {
   bool refresh_cache;
   bool official_only;
   bool scrape_ok;
+  bool show_timings; // Report per-request network timings
+  bool suggest; // Print matching titles from the local index
+  bool parallel; // Search AniList beside Jikan instead of after it
+  bool broadcast; // Next episode from the broadcast slot, not AniList
+  bool calendar; // "calendar" mode: list what airs in the coming days
+  const char *trace_path; // Chrome trace-event output file, NULL if off
+  const char *metrics_path; // Prometheus textfile written on exit, or NULL
+  const char *mal_id; // --mal, or NULL
+  const char *anilist_id; // --anilist, or NULL
+  const char *mangadex_id; // --mangadex, or NULL
+  const char *batch_path; // File of queries and IDs, one per line, or NULL
   int verbose_level; // 0=default, 1=info, 2=debug
   long timeout_ms;
+  long hedge_ms; // --hedge budget, 0 if off
+  long deadline_ms; // --deadline for AniList, 0 if off
+  int calendar_days; // --days listed in calendar mode
   char *query; // Joined query string
 } ani_cli_options;
 
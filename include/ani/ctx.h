@@ -0,0 +1,59 @@
+/*
+ * Routine: ani — Anime/Manga scheduling information CLI
+ * Author: DannyBimma
+ * Copyright: (c) 2025 Technomancer Pirate Captain. All Rights Reserved.
+ */
+
+#ifndef ANI_CTX_H
+#define ANI_CTX_H
+
+#include "ani/ani.h"
+#include "ani/breaker.h"
+#include "ani/cache.h"
+#include "ani/calendar.h"
+#include "ani/http.h"
+#include "ani/index.h"
+#include "ani/limiter.h"
+#include "ani/log.h"
+#include "ani/thread.h"
+#include <stddef.h>
+#include <time.h>
+
+// Context internals shared by the providers and subsystems. Embedders use
+// ani/ani.h and treat ani_ctx as opaque.
+
+struct ani_ctx {
+  ani_http_config http;    // Base request config (pool, limiter, timeouts)
+  ani_http_client *pool;   // Owned connection pool
+  ani_limiter *limiter;    // Owned rate limiter, NULL when disabled
+  ani_breaker *breaker;    // Owned circuit breaker, NULL when disabled
+  ani_cache *cache;        // Owned cache, NULL when unavailable
+  ani_index *index;        // Owned title index, NULL when unavailable
+  ani_logger logger;       // Bound to the calling thread during a lookup
+  unsigned long lookups;   // Updated atomically
+  long hedge_ms;           // Hedge budget when too few latencies are known
+  double hedge_quantile;   // Latency quantile used as the budget, 0 for fixed
+  bool estimates;          // Estimate schedules no provider publishes
+  long deadline_ms;        // Lookup time after which schedules are estimated
+  ani_calendar *calendar;  // Airing snapshot, loaded on first use
+  bool calendar_loaded;    // Whether the cache was read for it yet
+  ani_mutex calendar_lock; // Guards calendar and calendar_loaded
+  ani_mutex hedge_lock;    // Guards stragglers
+  // Lost hedged races still winding down, joined by ani_ctx_free
+  struct ani_hedge *stragglers;
+};
+
+// Request config for one provider call made under ctx
+ani_http_config ani_ctx_http_config(const ani_ctx *ctx, const char *provider);
+
+// Fetch url for provider (POST post_body as JSON when non-NULL) through the
+// context's cache: a cache_key entry younger than max_age is returned
+// without a request, and a 200 response is stored under cache_key. max_age
+// 0 (a refresh) skips the read but still stores. While provider's circuit
+// is open, an entry up to ANI_CACHE_TTL_STALE old is returned instead of
+// failing. Returns the body (free with ani_free) or NULL.
+char *ani_ctx_fetch(ani_ctx *ctx, const char *provider, const char *url,
+                    const char *post_body, const char *cache_key,
+                    time_t max_age, size_t *len_out);
+
+#endif // ANI_CTX_H
@@ -8,6 +8,7 @@
 #define ANI_FS_H
 
 #include <stdbool.h>
+#include <stddef.h>
 
 // Get platform-specific cache directory
 char *ani_get_cache_dir(void);
@@ -18,4 +19,10 @@ bool ani_mkdir_p(const char *path);
 // Join path components
 char *ani_path_join(const char *base, const char *name);
 
+// Read whole file into a NUL-terminated buffer (len_out may be NULL)
+char *ani_read_file(const char *path, size_t *len_out);
+
+// Write file atomically via a temp file and rename
+bool ani_write_file_atomic(const char *path, const void *data, size_t len);
+
 #endif // ANI_FS_H
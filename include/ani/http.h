@@ -10,21 +10,54 @@
 #include <stdbool.h>
 #include <stddef.h>
 
+// Per-request network timing breakdown (milliseconds since request start)
+typedef struct {
+  double namelookup_ms;    // DNS resolution done
+  double connect_ms;       // TCP connect done
+  double appconnect_ms;    // TLS handshake done (0 for plain HTTP)
+  double pretransfer_ms;   // About to send the request
+  double starttransfer_ms; // First response byte received
+  double total_ms;         // Transfer complete
+  size_t bytes_downloaded; // Bytes received for the final attempt
+  int retries;             // Retries before the final attempt
+  bool reused_connection;  // Final attempt reused an open connection
+} ani_http_timings;
+
 // HTTP response structure
 typedef struct {
   long status_code;
   char *body;
   size_t body_len;
+  char *headers; // Raw response header block of the final attempt
+  size_t headers_len;
   char *error;
+  ani_http_timings timings;
 } ani_http_response;
 
+// Completed request kept for the --timings report
+typedef struct {
+  char *provider; // Provider label, "unknown" if none given
+  char *method;
+  char *url;
+  long status_code;
+  ani_http_timings timings;
+} ani_http_timing_record;
+
+// Shared connection pool (connections, DNS and TLS sessions), safe to use
+// from several threads at once
+typedef struct ani_http_client ani_http_client;
+
 // HTTP client configuration
 typedef struct {
-  long connect_timeout_ms; // Connect timeout (default: 5000)
-  long timeout_ms;         // Overall timeout (default: 15000)
-  int max_retries;         // Max retries on 429/5xx (default: 3)
-  const char *user_agent;  // User-Agent string
-  bool verify_ssl;         // Verify SSL certificates (default: true)
+  long connect_timeout_ms;     // Connect timeout (default: 5000)
+  long timeout_ms;             // Overall timeout (default: 15000)
+  int max_retries;             // Max retries on 429/5xx (default: 3)
+  const char *user_agent;      // User-Agent string
+  bool verify_ssl;             // Verify SSL certificates (default: true)
+  const char *provider;        // Provider label for timings (default: NULL)
+  ani_http_client *client;     // Connection pool, NULL for a one-off handle
+  struct ani_limiter *limiter; // Paces live requests (ani/limiter.h), or NULL
+  struct ani_breaker *breaker; // Fails fast when down (ani/breaker.h), or NULL
 } ani_http_config;
 
 // Initialize HTTP subsystem (call once at startup)
@@ -36,6 +69,12 @@ void ani_http_cleanup(void);
 // Get default HTTP configuration
 ani_http_config ani_http_default_config(void);
 
+// Create a connection pool (call after ani_http_init)
+ani_http_client *ani_http_client_new(void);
+
+// Free a connection pool (NULL is a no-op)
+void ani_http_client_free(ani_http_client *client);
+
 // Perform HTTP GET request
 ani_http_response *ani_http_get(const char *url, const ani_http_config *config);
 
@@ -44,7 +83,27 @@ ani_http_response *ani_http_post(const char *url, const char *body,
                                  const char *content_type,
                                  const ani_http_config *config);
 
+// Bind a cancel flag to requests made on the calling thread (NULL unbinds)
+// and return the previous one. Once another thread sets *cancel, transfers
+// abort and no further retries are made. Used to drop the losing side of a
+// hedged request.
+const bool *ani_http_bind_cancel(const bool *cancel);
+
 // Free HTTP response
 void ani_http_response_free(ani_http_response *resp);
 
+// Enable recording of per-request timings (off by default, process-wide)
+void ani_http_timings_enable(bool enable);
+
+// Whether timings are being recorded
+bool ani_http_timings_enabled(void);
+
+// Number of recorded requests
+size_t ani_http_timings_count(void);
+
+// Copy the recorded request at index into out (false if out of range). The
+// log may grow on other threads meanwhile; the strings stay valid until
+// ani_http_cleanup.
+bool ani_http_timings_get(size_t index, ani_http_timing_record *out);
+
 #endif // ANI_HTTP_H
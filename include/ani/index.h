@@ -0,0 +1,79 @@
+/*
+ * Routine: ani — Anime/Manga scheduling information CLI
+ * Author: DannyBimma
+ * Copyright: (c) 2025 Technomancer Pirate Captain. All Rights Reserved.
+ */
+
+#ifndef ANI_INDEX_H
+#define ANI_INDEX_H
+
+#include "ani/models.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+// Local title index: normalized titles (English, Japanese, romaji) and past
+// queries mapped to provider IDs, so repeated lookups skip the search
+// request. Lives in titles.idx in the cache directory, is mmap'd for
+// lookups and rewritten atomically on every update. Safe to share between
+// threads; between processes the last writer wins.
+//
+// Near misses ("demon slyer") go through a trigram index over the same
+// keys, built in memory on first use: Dice similarity of the trigram sets,
+// with series that more queries resolved to ranked slightly higher.
+
+// Longest normalized key kept in the index (longer titles are truncated)
+#define ANI_INDEX_KEY_MAX 256
+
+// Longest provider ID reported by ani_index_suggest
+#define ANI_INDEX_ID_MAX 64
+
+// Media type masks for ani_index_suggest
+#define ANI_INDEX_ANIME (1u << ANI_MEDIA_ANIME)
+#define ANI_INDEX_MANGA (1u << ANI_MEDIA_MANGA)
+#define ANI_INDEX_ALL (ANI_INDEX_ANIME | ANI_INDEX_MANGA)
+
+// One suggestion
+typedef struct {
+  char id[ANI_INDEX_ID_MAX];
+  char title[ANI_INDEX_KEY_MAX]; // The series title that matched best
+  ani_media_type media_type;
+  double similarity; // Dice coefficient of the trigram sets, 0..1
+  double score;      // Ranking: similarity plus prefix and popularity boosts
+} ani_index_match;
+
+// Opaque index handle
+typedef struct ani_index ani_index;
+
+// Open the index in dir (the file need not exist yet), NULL on failure
+ani_index *ani_index_open(const char *dir);
+
+// Close an index handle (NULL is a no-op)
+void ani_index_close(ani_index *index);
+
+// Normalize a title or query into dst: ASCII case folded, punctuation
+// turned into spaces (apostrophes dropped), whitespace collapsed.
+// Returns the key length.
+size_t ani_index_normalize(const char *src, char *dst, size_t size);
+
+// Resolve query for one media type: an exact key first, then a trigram
+// match that is both close and clearly ahead of any other series. On a hit
+// fills the ID, titles and the details the search would have returned,
+// and returns true.
+bool ani_index_lookup(ani_index *index, const char *query,
+                      ani_media_type media_type, ani_series *series);
+
+// Record a successful search: query and every title of series now resolve
+// to series->id. Returns false if the index could not be written.
+bool ani_index_add(ani_index *index, const char *query,
+                   const ani_series *series);
+
+// Series whose titles or past queries resemble query (a prefix is enough),
+// best first, for completion. Returns the number written to out.
+size_t ani_index_suggest(ani_index *index, const char *query,
+                         unsigned int media_mask, ani_index_match *out,
+                         size_t max);
+
+// Number of series in the index
+size_t ani_index_count(ani_index *index);
+
+#endif // ANI_INDEX_H
@@ -14,6 +14,11 @@
 typedef struct ani_json_doc ani_json_doc;
 typedef struct ani_json_val ani_json_val;
 
+// yyjson allocator that routes through ani_malloc/ani_free; pass it to
+// every yyjson call that allocates (read, mut_doc_new, write)
+struct yyjson_alc;
+const struct yyjson_alc *ani_json_alc(void);
+
 // Parse JSON string into document
 ani_json_doc *ani_json_parse(const char *json_str, size_t len);
 
@@ -40,6 +45,10 @@ long ani_json_object_get_int(const ani_json_val *obj, const char *key,
 bool ani_json_object_get_bool(const ani_json_val *obj, const char *key,
                               bool default_val);
 
+// Object members by position, for objects keyed by data (e.g., volumes)
+size_t ani_json_object_size(const ani_json_val *obj);
+ani_json_val *ani_json_object_value_at(const ani_json_val *obj, size_t index);
+
 // Array accessors
 size_t ani_json_array_size(const ani_json_val *arr);
 ani_json_val *ani_json_array_get(const ani_json_val *arr, size_t index);
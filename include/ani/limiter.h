@@ -0,0 +1,32 @@
+/*
+ * Routine: ani — Anime/Manga scheduling information CLI
+ * Author: DannyBimma
+ * Copyright: (c) 2025 Technomancer Pirate Captain. All Rights Reserved.
+ */
+
+#ifndef ANI_LIMITER_H
+#define ANI_LIMITER_H
+
+#include <stdbool.h>
+
+// Per-provider token-bucket rate limiter, shared by every thread using a
+// context so concurrent lookups stay inside each API's published limits.
+
+typedef struct ani_limiter ani_limiter;
+
+// Create a limiter with the default provider rates:
+//   jikan 3/s (burst 3), anilist 1.5/s (burst 5), mangadex 5/s (burst 5)
+ani_limiter *ani_limiter_new(void);
+
+// Free a limiter (NULL is a no-op)
+void ani_limiter_free(ani_limiter *limiter);
+
+// Set or add a provider's rate; per_second <= 0 removes the limit
+bool ani_limiter_set_rate(ani_limiter *limiter, const char *provider,
+                          double per_second, double burst);
+
+// Block until provider may send another request (unknown providers and a
+// NULL limiter never wait)
+void ani_limiter_acquire(ani_limiter *limiter, const char *provider);
+
+#endif // ANI_LIMITER_H
@@ -17,12 +17,27 @@ typedef enum {
   ANI_LOG_DEBUG = 3
 } ani_log_level;
 
-// Global log level
+// Log sink: receives the formatted message without timestamp or newline
+typedef void (*ani_log_fn)(ani_log_level level, const char *message,
+                           void *userdata);
+
+// Per-context logger
+typedef struct {
+  ani_log_level level;
+  ani_log_fn fn; // NULL writes to stderr
+  void *userdata;
+} ani_logger;
+
+// Process default log level, used when no logger is bound to the thread
 extern ani_log_level ani_log_current_level;
 
 // Set log level (0=error, 1=warn, 2=info, 3=debug)
 void ani_log_set_level(ani_log_level level);
 
+// Route this thread's LOG_* calls through logger (NULL restores the
+// process default). Returns the previously bound logger.
+const ani_logger *ani_log_bind(const ani_logger *logger);
+
 // Log functions
 void ani_log_error(const char *fmt, ...);
 void ani_log_warn(const char *fmt, ...);
@@ -0,0 +1,60 @@
+/*
+ * Routine: ani — Anime/Manga scheduling information CLI
+ * Author: DannyBimma
+ * Copyright: (c) 2025 Technomancer Pirate Captain. All Rights Reserved.
+ */
+
+#ifndef ANI_METRICS_H
+#define ANI_METRICS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Process-wide metrics registry. Recording is a few relaxed atomic adds into
+// fixed arrays, so the hooks are safe to leave on in hot paths.
+
+// Record a finished HTTP request (provider label may be NULL)
+void ani_metrics_http_request(const char *provider, long status_code,
+                              int retries, double seconds);
+
+// Record a single 429 response (counted per attempt, before any retry)
+void ani_metrics_http_rate_limited(const char *provider);
+
+// A request to provider refused by its open circuit (ani/breaker.h)
+void ani_metrics_http_short_circuit(const char *provider);
+
+// A hedge fired because provider had not answered within its budget
+void ani_metrics_hedge_fired(const char *provider);
+
+// provider answered first in a hedged race
+void ani_metrics_hedge_won(const char *provider);
+
+// Hedges fired against provider and races it won (either may be NULL)
+void ani_metrics_hedge_stats(const char *provider, unsigned long *fired,
+                             unsigned long *won);
+
+// Estimated latency quantile q (0..1) of provider's HTTP requests in
+// seconds, interpolated within the histogram bucket; samples receives the
+// number of requests it is based on. -1 when there are none.
+double ani_metrics_http_quantile(const char *provider, double q,
+                                 unsigned long *samples);
+
+// Cache outcomes
+void ani_metrics_cache_hit(void);
+void ani_metrics_cache_miss(void);
+void ani_metrics_cache_eviction(void);
+
+// Duration of a JSON parse
+void ani_metrics_observe_parse(double seconds);
+
+// End-to-end duration of one query
+void ani_metrics_observe_query(double seconds);
+
+// Render all metrics in Prometheus text exposition format (caller frees)
+char *ani_metrics_render(void);
+
+// Write rendered metrics atomically (temp file + rename), e.g. for the
+// node_exporter textfile collector
+bool ani_metrics_write_file(const char *path);
+
+#endif // ANI_METRICS_H
@@ -7,8 +7,10 @@
 #ifndef ANI_MODELS_H
 #define ANI_MODELS_H
 
+#include "ani/arena.h"
 #include "ani/time.h"
 #include <stdbool.h>
+#include <stdint.h>
 
 // Media type
 typedef enum { ANI_MEDIA_ANIME, ANI_MEDIA_MANGA } ani_media_type;
@@ -38,6 +40,14 @@ typedef struct {
   char *canonical;
 } ani_title;
 
+// Weekly broadcast slot of an airing anime
+typedef struct {
+  int weekday;      // 0 = Sunday ... 6 = Saturday in Japan, -1 if unknown
+  int minute;       // Minutes after midnight, Japan time (UTC+9)
+  int64_t premiere; // First broadcast, seconds since the epoch (0: unknown)
+  bool airing;
+} ani_broadcast;
+
 // Release information
 typedef struct {
   ani_date latest_date;
@@ -47,7 +57,10 @@ typedef struct {
   int total_count;   // Total episodes/chapters, -1 if unknown
   ani_schedule_source next_source;
   ani_confidence next_confidence;
-  char *provider_name; // e.g., "ANILIST", "MANGAPLUS"
+  const char *provider_name; // Static label, e.g., "AniList" (not freed)
+  char latest_id[40]; // Provider ID of the latest release when known ahead
+                      // of its details (a MangaDex chapter UUID), else ""
+  ani_broadcast broadcast; // Anime only, from the series details
 } ani_release_info;
 
 // Series information
@@ -56,7 +69,8 @@ typedef struct {
   ani_title title;
   ani_media_type media_type;
   ani_release_info release;
-  char *provider; // Provider name (e.g., "jikan", "mangadex")
+  const char *provider; // Static provider name, e.g., "jikan" (not freed)
+  ani_arena *arena;     // Arena holding the strings, NULL if heap-allocated
 } ani_series;
 
 // Query result (holds both anime and manga)
@@ -66,6 +80,8 @@ typedef struct {
   ani_series *manga;
   bool has_anime;
   bool has_manga;
+  ani_arena *arena; // Arena holding result, series and strings, or NULL
+  bool owns_arena;  // Freed with the result
 } ani_result;
 
 // Allocate and free functions
@@ -75,7 +91,20 @@ void ani_series_free(ani_series *series);
 ani_result *ani_result_new(void);
 void ani_result_free(ani_result *result);
 
-// Helper to set title
+// Arena-backed variants: everything lives in the arena and is released at
+// once. ani_result_new_arena(NULL) creates an arena owned by the result;
+// a caller-supplied arena is left for the caller to free.
+ani_series *ani_series_new_in(ani_arena *arena);
+ani_result *ani_result_new_arena(ani_arena *arena);
+
+// Copy a string with the same ownership as series (arena or heap)
+char *ani_series_strdup(ani_series *series, const char *s);
+
+// Set series titles with the same ownership as series
+void ani_series_set_title(ani_series *series, const char *english,
+                          const char *japanese, const char *canonical);
+
+// Helper to set title (heap strings)
 void ani_title_set(ani_title *title, const char *english, const char *japanese,
                    const char *canonical);
 
@@ -7,6 +7,8 @@
 #ifndef ANI_OUTPUT_H
 #define ANI_OUTPUT_H
 
+#include "ani/calendar.h"
+#include "ani/index.h"
 #include "ani/models.h"
 #include <stdbool.h>
 
@@ -16,7 +18,19 @@ void ani_output_print_series(const ani_series *series);
 // Print result (anime and/or manga) in human-readable format
 void ani_output_print_result(const ani_result *result);
 
-// Print result in JSON format
+// Print result in JSON format (includes "timings" when recording is enabled)
 void ani_output_print_json(const ani_result *result);
 
+// Print per-provider table of recorded HTTP timings
+void ani_output_print_timings(void);
+
+// Print title suggestions, one per line (shell completion) or as JSON
+void ani_output_print_suggestions(const ani_index_match *matches, size_t count,
+                                  bool json);
+
+// Print the episodes of calendar airing in [from, to), grouped by local day
+// or as JSON
+void ani_output_print_calendar(const ani_calendar *calendar, int64_t from,
+                               int64_t to, bool json);
+
 #endif // ANI_OUTPUT_H
@@ -7,10 +7,35 @@
 #ifndef ANI_ANILIST_H
 #define ANI_ANILIST_H
 
+#include "ani/ani.h"
+#include "ani/calendar.h"
 #include "ani/models.h"
 #include <stdbool.h>
+#include <stddef.h>
 
 // Get next airing episode info using MAL ID
-bool ani_anilist_get_next_episode(const char *mal_id, ani_series *series);
+bool ani_anilist_get_next_episode(ani_ctx *ctx, const char *mal_id,
+                                  ani_series *series);
+
+// Next airing episode for many series (by their MAL IDs) with one request
+// per 50; results are matched back on idMal. False if any request failed.
+bool ani_anilist_get_next_episodes(ani_ctx *ctx, ani_series **series,
+                                   size_t count);
+
+// Populate series (details and next episode) by AniList media ID in one
+// request, cached for ANI_CACHE_TTL_SCHEDULE unless refresh
+bool ani_anilist_get_anime(ani_ctx *ctx, const char *anilist_id, bool refresh,
+                           ani_series *series);
+
+// Search anime by title and populate series (details and schedule, ID is the
+// AniList one) in one request. mal_id receives the match's MAL ID, empty if
+// it has none, so the result can be checked against a Jikan search.
+bool ani_anilist_search_anime(ani_ctx *ctx, const char *query,
+                              ani_series *series, char *mal_id,
+                              size_t mal_id_size);
+
+// Fill calendar with every episode airing in its window, 50 per request
+// (sorted by airing time). False if any page failed.
+bool ani_anilist_get_airing(ani_ctx *ctx, ani_calendar *calendar);
 
 #endif // ANI_ANILIST_H
@@ -7,10 +7,17 @@
 #ifndef ANI_JIKAN_H
 #define ANI_JIKAN_H
 
+#include "ani/ani.h"
 #include "ani/models.h"
 #include <stdbool.h>
 
 // Search for anime by query and populate series info
-bool ani_jikan_search_anime(const char *query, ani_series *series);
+bool ani_jikan_search_anime(ani_ctx *ctx, const char *query,
+                            ani_series *series);
+
+// Populate series from the anime's details by MAL ID (cached for
+// ANI_CACHE_TTL_DETAILS unless refresh)
+bool ani_jikan_get_anime(ani_ctx *ctx, const char *mal_id, bool refresh,
+                         ani_series *series);
 
 #endif // ANI_JIKAN_H
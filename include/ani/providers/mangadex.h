@@ -7,13 +7,49 @@
 #ifndef ANI_MANGADEX_H
 #define ANI_MANGADEX_H
 
+#include "ani/ani.h"
+#include "ani/cadence.h"
 #include "ani/models.h"
 #include <stdbool.h>
+#include <stddef.h>
 
-// Search for manga by query and populate series info
-bool ani_mangadex_search_manga(const char *query, ani_series *series);
+// Search for manga by query and populate series info, including the ID of
+// its latest upload
+bool ani_mangadex_search_manga(ani_ctx *ctx, const char *query,
+                               ani_series *series);
 
-// Get latest chapter for a manga ID
-bool ani_mangadex_get_latest_chapter(const char *manga_id, ani_series *series);
+// Populate series from the manga's details by UUID (cached for
+// ANI_CACHE_TTL_DETAILS unless refresh)
+bool ani_mangadex_get_manga(ani_ctx *ctx, const char *manga_id, bool refresh,
+                            ani_series *series);
+
+// Get the latest English chapter for a manga ID. A series from a search
+// knows its latest upload, which is resolved (and cached) by chapter ID;
+// otherwise, or if that upload is not in English, the chapter feed is asked.
+bool ani_mangadex_get_latest_chapter(ani_ctx *ctx, const char *manga_id,
+                                     ani_series *series);
+
+// Refresh many series by their UUIDs (series->id) at once, one request per
+// 100: titles, finished chapter count and latest upload. Series MangaDex
+// does not return are left as they were. Returns false if a request failed.
+bool ani_mangadex_get_mangas(ani_ctx *ctx, ani_series **series, size_t count);
+
+// Latest chapters for many series at once: one request per 100 series that
+// need their latest upload named (see ani_mangadex_get_mangas) and one per
+// 100 latest uploads, falling back to the feed per series as above.
+// Returns false if any chapter request failed (those series keep no
+// chapter).
+bool ani_mangadex_get_latest_chapters(ani_ctx *ctx, ani_series **series,
+                                      size_t count);
+
+// Backfill history with the publish times of the manga's last
+// ANI_CADENCE_MAX English chapters (one uncached request)
+bool ani_mangadex_get_chapter_history(ani_ctx *ctx, const char *manga_id,
+                                      ani_cadence *history);
+
+// Set total_count to the highest English chapter number (cached for
+// ANI_CACHE_TTL_DETAILS unless refresh)
+bool ani_mangadex_get_chapter_count(ani_ctx *ctx, const char *manga_id,
+                                    bool refresh, ani_series *series);
 
 #endif // ANI_MANGADEX_H
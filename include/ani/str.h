@@ -19,10 +19,25 @@ size_t ani_strlcat(char *dst, const char *src, size_t size);
 // Trim whitespace from start and end
 char *ani_str_trim(char *str);
 
+// Trim and collapse whitespace runs to one space, in place; returns length
+size_t ani_str_collapse_ws(char *str);
+
 // Case-insensitive ASCII comparison
 int ani_strcasecmp(const char *s1, const char *s2);
 int ani_strncasecmp(const char *s1, const char *s2, size_t n);
 
+// ASCII lowercase copy of n bytes (dst may equal src; other bytes as-is)
+void ani_str_fold(char *dst, const char *src, size_t n);
+
+// Whether s[0..len) is well-formed UTF-8
+bool ani_utf8_valid(const char *s, size_t len);
+
+// Whether s is a MAL or AniList ID: 1 to 10 decimal digits
+bool ani_str_is_decimal_id(const char *s);
+
+// Whether s is a MangaDex UUID: lowercase hex in 8-4-4-4-12 groups
+bool ani_str_is_uuid(const char *s);
+
 // Safe string duplication
 char *ani_strdup(const char *s);
 
@@ -32,4 +47,23 @@ char *ani_str_join(const char **parts, size_t count, const char *sep);
 // Safe line reader (grows buffer as needed)
 char *ani_readline(void);
 
+// URL encode for query strings (space becomes '+'); caller frees
+char *ani_url_encode(const char *str);
+
+// The kernels above use the widest SIMD the CPU supports, picked at first
+// use. Forcing a narrower one is for benchmarks and testing.
+typedef enum {
+  ANI_STR_ISA_SCALAR,
+  ANI_STR_ISA_SSE2,
+  ANI_STR_ISA_AVX2,
+  ANI_STR_ISA_NEON
+} ani_str_isa;
+
+ani_str_isa ani_str_get_isa(void);
+
+// Switch kernels; false if this build or CPU lacks isa
+bool ani_str_set_isa(ani_str_isa isa);
+
+const char *ani_str_isa_name(ani_str_isa isa);
+
 #endif // ANI_STR_H
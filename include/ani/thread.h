@@ -0,0 +1,61 @@
+/*
+ * Routine: ani — Anime/Manga scheduling information CLI
+ * Author: DannyBimma
+ * Copyright: (c) 2025 Technomancer Pirate Captain. All Rights Reserved.
+ */
+
+#ifndef ANI_THREAD_H
+#define ANI_THREAD_H
+
+#include <stdbool.h>
+
+#ifdef _WIN32
+#include <windows.h>
+typedef CRITICAL_SECTION ani_mutex;
+typedef CONDITION_VARIABLE ani_cond;
+#else
+#include <pthread.h>
+typedef pthread_mutex_t ani_mutex;
+typedef pthread_cond_t ani_cond;
+#endif
+
+// Thread-local storage class (C99 has no _Thread_local)
+#if defined(_MSC_VER)
+#define ANI_THREAD_LOCAL __declspec(thread)
+#else
+#define ANI_THREAD_LOCAL __thread
+#endif
+
+// Joinable thread running fn(arg); the struct must outlive the thread
+typedef struct {
+#ifdef _WIN32
+  HANDLE handle;
+#else
+  pthread_t handle;
+#endif
+  void (*fn)(void *arg);
+  void *arg;
+} ani_thread;
+
+// Plain (non-recursive) mutex
+void ani_mutex_init(ani_mutex *mutex);
+void ani_mutex_destroy(ani_mutex *mutex);
+void ani_mutex_lock(ani_mutex *mutex);
+void ani_mutex_unlock(ani_mutex *mutex);
+
+// Condition variable used with an ani_mutex
+void ani_cond_init(ani_cond *cond);
+void ani_cond_destroy(ani_cond *cond);
+void ani_cond_broadcast(ani_cond *cond);
+
+// Wait on cond with mutex held, at most timeout_ms (< 0 waits without a
+// limit). False on timeout; spurious wakeups return true, so callers loop.
+bool ani_cond_wait_ms(ani_cond *cond, ani_mutex *mutex, long timeout_ms);
+
+// Start fn(arg) on a new thread, false if it could not be created
+bool ani_thread_start(ani_thread *thread, void (*fn)(void *arg), void *arg);
+
+// Wait for a started thread to finish
+void ani_thread_join(ani_thread *thread);
+
+#endif // ANI_THREAD_H
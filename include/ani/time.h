@@ -8,6 +8,8 @@
 #define ANI_TIME_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <time.h>
 
 // Parsed date/time structure
@@ -22,9 +24,24 @@ typedef struct {
   bool has_time;
 } ani_date;
 
-// Parse ISO-8601 date: YYYY-MM-DD or YYYY-MM-DDThh:mm:ss[Z|±hh:mm]
+// Compact timestamp: 16 bytes instead of ani_date's 32
+typedef struct {
+  int64_t epoch;          // Seconds since 1970-01-01T00:00:00Z
+  int16_t offset_minutes; // Offset the value was written in (for display)
+  bool has_time;          // false for dates (epoch is 00:00 UTC that day)
+} ani_instant;
+
+// Parse ISO-8601 date: YYYY-MM-DD or YYYY-MM-DDThh:mm[:ss[.f]][Z|±hh:mm].
+// Fields are fixed-position and zero-padded.
 bool ani_parse_iso8601(const char *str, ani_date *out);
 
+// Parse ISO-8601 straight into an instant
+bool ani_parse_instant(const char *str, ani_instant *out);
+
+// Convert between the broken-down and compact forms
+bool ani_date_to_instant(const ani_date *date, ani_instant *out);
+void ani_instant_to_date(const ani_instant *instant, ani_date *out);
+
 // Parse Unix timestamp (seconds since epoch)
 bool ani_parse_unix_timestamp(long timestamp, ani_date *out);
 
@@ -34,4 +51,13 @@ void ani_format_date(const ani_date *date, char *buf, size_t size);
 // Format date with time as ISO-8601 string
 void ani_format_datetime(const ani_date *date, char *buf, size_t size);
 
+// Format an instant like ani_format_datetime, in its original offset
+void ani_format_instant(const ani_instant *instant, char *buf, size_t size);
+
+// Monotonic clock in microseconds (for durations only)
+int64_t ani_monotonic_us(void);
+
+// Sleep the calling thread (no-op for ms <= 0)
+void ani_sleep_ms(long ms);
+
 #endif // ANI_TIME_H
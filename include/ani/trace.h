@@ -0,0 +1,62 @@
+/*
+ * Routine: ani — Anime/Manga scheduling information CLI
+ * Author: DannyBimma
+ * Copyright: (c) 2025 Technomancer Pirate Captain. All Rights Reserved.
+ */
+
+#ifndef ANI_TRACE_H
+#define ANI_TRACE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Span in progress (see ANI_TRACE_BEGIN/ANI_TRACE_END)
+typedef struct {
+  const char *name;     // Static string, e.g. "http.request"
+  const char *category; // Static string, e.g. "net"
+  const char *detail;   // Optional, copied when the span ends
+  int64_t start_us;     // 0 when the span is not being recorded
+  int64_t cpu_user_us;  // getrusage snapshot at begin
+  int64_t cpu_sys_us;
+  long max_rss_kb;
+  long minor_faults;
+  long major_faults;
+} ani_trace_span;
+
+// Tracing switch (read on every hook, so keep it a plain flag)
+extern bool ani_trace_active;
+
+// Start recording spans; written to path in Chrome trace-event format
+bool ani_trace_start(const char *path);
+
+// Write recorded spans to the trace file and stop recording
+bool ani_trace_stop(void);
+
+// Begin a span unconditionally (used before tracing is switched on)
+void ani_trace_span_begin(ani_trace_span *span, const char *name,
+                          const char *category);
+
+// End a span; recorded only while tracing is active
+void ani_trace_span_end(ani_trace_span *span);
+
+// Hooks: a single flag test when tracing is off
+#define ANI_TRACE_BEGIN(span, name, category)                                 \
+  do {                                                                         \
+    (span).start_us = 0;                                                       \
+    (span).detail = NULL;                                                      \
+    if (ani_trace_active) {                                                    \
+      ani_trace_span_begin(&(span), (name), (category));                       \
+    }                                                                          \
+  } while (0)
+
+#define ANI_TRACE_DETAIL(span, str) ((span).detail = (str))
+
+#define ANI_TRACE_END(span)                                                    \
+  do {                                                                         \
+    if ((span).start_us != 0) {                                                \
+      ani_trace_span_end(&(span));                                             \
+    }                                                                          \
+  } while (0)
+
+#endif // ANI_TRACE_H
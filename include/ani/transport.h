@@ -0,0 +1,50 @@
+/*
+ * Routine: ani — Anime/Manga scheduling information CLI
+ * Author: DannyBimma
+ * Copyright: (c) 2025 Technomancer Pirate Captain. All Rights Reserved.
+ */
+
+#ifndef ANI_TRANSPORT_H
+#define ANI_TRANSPORT_H
+
+#include "ani/http.h"
+#include <stdbool.h>
+
+// Record/replay transport under ani_http_get/ani_http_post.
+//
+// Environment:
+//   ANI_HTTP_RECORD=dir          Save every request/response pair to dir
+//   ANI_HTTP_REPLAY=dir          Serve responses from dir, never the network
+//   ANI_HTTP_REPLAY_LATENCY=ms   Simulated latency per replayed request, or
+//                                "recorded" to reuse the captured total time
+//   ANI_HTTP_REPLAY_JITTER=ms    Uniform +/- jitter added to the latency
+//   ANI_HTTP_REPLAY_SEED=n       Jitter seed (default: 1, deterministic)
+
+typedef enum {
+  ANI_TRANSPORT_LIVE,
+  ANI_TRANSPORT_RECORD,
+  ANI_TRANSPORT_REPLAY
+} ani_transport_mode;
+
+// Read transport settings from the environment (called by ani_http_init)
+void ani_transport_init(void);
+
+// Release transport settings (called by ani_http_cleanup)
+void ani_transport_cleanup(void);
+
+// Current transport mode
+ani_transport_mode ani_transport_get_mode(void);
+
+// Replay a recorded response; a miss returns status 0 with an error set
+ani_http_response *ani_transport_replay(const char *method, const char *url,
+                                        const char *body);
+
+// Save a live response
+bool ani_transport_record(const char *method, const char *url,
+                          const char *body, const ani_http_response *resp);
+
+// Recording file name for a request ("<16 hex digits>.json")
+void ani_transport_key(const char *method, const char *url, const char *body,
+                       char *buf, size_t size);
+
+#endif // ANI_TRANSPORT_H
@@ -5,6 +5,7 @@
  */
 
 #include "ani/cli.h"
+#include "ani/alloc.h"
 #include "ani/log.h"
 #include "ani/str.h"
 #include "ani/version.h"
@@ -15,7 +16,8 @@
 void ani_cli_print_version(void) { printf("%s\n", ani_build_info()); }
 
 void ani_cli_print_usage(const char *prog) {
-  printf("Usage: %s [options] <query...>\n\n", prog);
+  printf("Usage: %s [options] <query...>\n", prog);
+  printf("       %s calendar [--days <n>] [options]\n\n", prog);
   printf("Options:\n");
   printf("  -m, --manga          Query manga only\n");
   printf("  -a, --anime          Query anime only\n");
@@ -24,18 +26,35 @@ void ani_cli_print_usage(const char *prog) {
   printf("  -r, --refresh        Bypass cache\n");
   printf("  -t, --timeout <ms>   HTTP timeout override\n");
   printf("  -v, --verbose        Verbose logs (repeat for debug: -vv)\n");
-  printf("  --official-only      Only official schedule sources\n");
+  printf("  --hedge <ms>         Race a backup search when one is slower\n");
+  printf("  --deadline <ms>      Past this, estimate episodes locally\n");
+  printf("  --broadcast          Estimate episodes from the broadcast slot\n");
+  printf("  --official-only      Official schedules only, no estimates\n");
   printf("  --scrape-ok          Allow HTML parsing for official sites\n");
+  printf("  --timings            Report per-request network timings\n");
+  printf("  --suggest            List known titles matching the query\n");
+  printf("  --parallel           Search AniList alongside Jikan for anime\n");
+  printf("  --mal <id>           Look up an anime by MyAnimeList ID\n");
+  printf("  --anilist <id>       Look up an anime by AniList ID\n");
+  printf("  --mangadex <uuid>    Look up a manga by MangaDex ID\n");
+  printf("  --batch <file>       Look up each line (- for stdin): a title,\n");
+  printf("                       mal:<id>, anilist:<id> or mangadex:<uuid>\n");
+  printf("  --days <n>           Days listed by calendar (default: 7)\n");
+  printf("  --trace <file>       Write Chrome trace events to file\n");
+  printf("  --metrics <file>     Write Prometheus metrics to file on exit\n");
   printf("  -V, --version        Print version and build info\n");
   printf("  -h, --help           Show this help\n\n");
   printf("Examples:\n");
   printf("  %s One Piece\n", prog);
   printf("  %s \"Demon Slayer\" -a\n", prog);
   printf("  %s Berserk -m --json\n", prog);
+  printf("  %s --mal 52991\n", prog);
+  printf("  %s calendar --days 3\n", prog);
 }
 
 bool ani_cli_parse_args(int argc, char **argv, ani_cli_options *opts) {
   int i;
+  int first;
   int query_start;
   int query_count;
   const char **query_parts;
@@ -48,10 +67,18 @@ bool ani_cli_parse_args(int argc, char **argv, ani_cli_options *opts) {
   memset(opts, 0, sizeof(*opts));
   opts->query_both = true;
   opts->timeout_ms = -1;
+  opts->calendar_days = 7;
+
+  // "calendar" is a mode, not a title, only as the first argument
+  first = 1;
+  if (argc > 1 && strcmp(argv[1], "calendar") == 0) {
+    opts->calendar = true;
+    first = 2;
+  }
 
   // Parse flags
   query_start = -1;
-  for (i = 1; i < argc; i++) {
+  for (i = first; i < argc; i++) {
     if (strcmp(argv[i], "-m") == 0 || strcmp(argv[i], "--manga") == 0) {
       opts->query_manga = true;
       opts->query_both = false;
@@ -74,6 +101,47 @@ bool ani_cli_parse_args(int argc, char **argv, ani_cli_options *opts) {
       opts->official_only = true;
     } else if (strcmp(argv[i], "--scrape-ok") == 0) {
       opts->scrape_ok = true;
+    } else if (strcmp(argv[i], "--timings") == 0) {
+      opts->show_timings = true;
+    } else if (strcmp(argv[i], "--suggest") == 0) {
+      opts->suggest = true;
+    } else if (strcmp(argv[i], "--parallel") == 0) {
+      opts->parallel = true;
+    } else if (strcmp(argv[i], "--broadcast") == 0) {
+      opts->broadcast = true;
+    } else if (strcmp(argv[i], "--trace") == 0) {
+      if (i + 1 >= argc) {
+        fprintf(stderr, "Error: --trace requires an argument\n");
+
+        return false;
+      }
+      opts->trace_path = argv[++i];
+    } else if (strcmp(argv[i], "--metrics") == 0) {
+      if (i + 1 >= argc) {
+        fprintf(stderr, "Error: --metrics requires an argument\n");
+
+        return false;
+      }
+      opts->metrics_path = argv[++i];
+    } else if (strcmp(argv[i], "--mal") == 0 ||
+               strcmp(argv[i], "--anilist") == 0 ||
+               strcmp(argv[i], "--mangadex") == 0 ||
+               strcmp(argv[i], "--batch") == 0) {
+      if (i + 1 >= argc) {
+        fprintf(stderr, "Error: %s requires an argument\n", argv[i]);
+
+        return false;
+      }
+      if (strcmp(argv[i], "--mal") == 0) {
+        opts->mal_id = argv[i + 1];
+      } else if (strcmp(argv[i], "--anilist") == 0) {
+        opts->anilist_id = argv[i + 1];
+      } else if (strcmp(argv[i], "--mangadex") == 0) {
+        opts->mangadex_id = argv[i + 1];
+      } else {
+        opts->batch_path = argv[i + 1];
+      }
+      i++;
     } else if (strcmp(argv[i], "-t") == 0 ||
                strcmp(argv[i], "--timeout") == 0) {
       if (i + 1 >= argc) {
@@ -82,6 +150,27 @@ bool ani_cli_parse_args(int argc, char **argv, ani_cli_options *opts) {
         return false;
       }
       opts->timeout_ms = atol(argv[++i]);
+    } else if (strcmp(argv[i], "--hedge") == 0) {
+      if (i + 1 >= argc) {
+        fprintf(stderr, "Error: --hedge requires an argument\n");
+
+        return false;
+      }
+      opts->hedge_ms = atol(argv[++i]);
+    } else if (strcmp(argv[i], "--deadline") == 0) {
+      if (i + 1 >= argc) {
+        fprintf(stderr, "Error: --deadline requires an argument\n");
+
+        return false;
+      }
+      opts->deadline_ms = atol(argv[++i]);
+    } else if (strcmp(argv[i], "--days") == 0) {
+      if (i + 1 >= argc) {
+        fprintf(stderr, "Error: --days requires an argument\n");
+
+        return false;
+      }
+      opts->calendar_days = atoi(argv[++i]);
     } else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
       return false; // Let caller handle help
     } else if (strcmp(argv[i], "-V") == 0 ||
@@ -100,7 +189,7 @@ bool ani_cli_parse_args(int argc, char **argv, ani_cli_options *opts) {
   // Join query parts
   if (query_start >= 0) {
     query_count = argc - query_start;
-    query_parts = malloc(sizeof(char *) * (size_t)query_count);
+    query_parts = ani_malloc(sizeof(char *) * (size_t)query_count);
     if (query_parts == NULL) {
       return false;
     }
@@ -110,11 +199,19 @@ bool ani_cli_parse_args(int argc, char **argv, ani_cli_options *opts) {
     }
 
     opts->query = ani_str_join(query_parts, (size_t)query_count, " ");
-    free(query_parts);
+    ani_free(query_parts);
 
     if (opts->query == NULL) {
       return false;
     }
+
+    // "  One   Piece " and "One Piece" are the same lookup (and cache key)
+    if (ani_str_collapse_ws(opts->query) == 0) {
+      ani_free(opts->query);
+      opts->query = NULL;
+    } else if (!ani_utf8_valid(opts->query, strlen(opts->query))) {
+      LOG_WARN("Query is not valid UTF-8; providers may not match it");
+    }
   }
 
   return true;
@@ -125,6 +222,6 @@ void ani_cli_options_free(ani_cli_options *opts) {
     return;
   }
 
-  free(opts->query);
+  ani_free(opts->query);
   opts->query = NULL;
 }
@@ -5,9 +5,13 @@
  */
 
 #include "ani/output.h"
+#include "ani/alloc.h"
+#include "ani/http.h"
+#include "ani/json.h"
 #include "ani/time.h"
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 #include <yyjson.h>
 
 void ani_output_print_series(const ani_series *series) {
@@ -111,7 +115,7 @@ void ani_output_print_json(const ani_result *result) {
     return;
   }
 
-  yyjson_mut_doc *doc = yyjson_mut_doc_new(NULL);
+  yyjson_mut_doc *doc = yyjson_mut_doc_new(ani_json_alc());
   if (doc == NULL) {
     return;
   }
@@ -163,6 +167,9 @@ void ani_output_print_json(const ani_result *result) {
       yyjson_mut_val *next = yyjson_mut_obj(doc);
       yyjson_mut_obj_add_int(doc, next, "number", a->release.next_number);
       yyjson_mut_obj_add_str(doc, next, "date", buf);
+      yyjson_mut_obj_add_bool(doc, next, "estimated",
+                              a->release.next_confidence !=
+                                  ANI_CONFIDENCE_OFFICIAL);
       yyjson_mut_obj_add(obj, yyjson_mut_str(doc, "next"), next);
     } else {
       yyjson_mut_obj_add_null(doc, obj, "next");
@@ -209,6 +216,9 @@ void ani_output_print_json(const ani_result *result) {
       yyjson_mut_val *next = yyjson_mut_obj(doc);
       yyjson_mut_obj_add_int(doc, next, "number", m->release.next_number);
       yyjson_mut_obj_add_str(doc, next, "date", buf);
+      yyjson_mut_obj_add_bool(doc, next, "estimated",
+                              m->release.next_confidence !=
+                                  ANI_CONFIDENCE_OFFICIAL);
       yyjson_mut_obj_add(obj, yyjson_mut_str(doc, "next"), next);
     } else {
       yyjson_mut_obj_add_null(doc, obj, "next");
@@ -217,13 +227,271 @@ void ani_output_print_json(const ani_result *result) {
     yyjson_mut_obj_add(root, yyjson_mut_str(doc, "manga"), obj);
   }
 
+  // Timings section
+  if (ani_http_timings_enabled()) {
+    yyjson_mut_val *arr = yyjson_mut_arr(doc);
+    ani_http_timing_record record;
+    const ani_http_timing_record *rec = &record;
+    for (size_t i = 0; ani_http_timings_get(i, &record); i++) {
+      yyjson_mut_val *t = yyjson_mut_obj(doc);
+      yyjson_mut_obj_add_str(doc, t, "provider", rec->provider);
+      yyjson_mut_obj_add_str(doc, t, "method", rec->method);
+      yyjson_mut_obj_add_str(doc, t, "url", rec->url);
+      yyjson_mut_obj_add_int(doc, t, "status", rec->status_code);
+      yyjson_mut_obj_add_real(doc, t, "namelookup_ms",
+                              rec->timings.namelookup_ms);
+      yyjson_mut_obj_add_real(doc, t, "connect_ms", rec->timings.connect_ms);
+      yyjson_mut_obj_add_real(doc, t, "appconnect_ms",
+                              rec->timings.appconnect_ms);
+      yyjson_mut_obj_add_real(doc, t, "pretransfer_ms",
+                              rec->timings.pretransfer_ms);
+      yyjson_mut_obj_add_real(doc, t, "starttransfer_ms",
+                              rec->timings.starttransfer_ms);
+      yyjson_mut_obj_add_real(doc, t, "total_ms", rec->timings.total_ms);
+      yyjson_mut_obj_add_uint(doc, t, "bytes", rec->timings.bytes_downloaded);
+      yyjson_mut_obj_add_int(doc, t, "retries", rec->timings.retries);
+      yyjson_mut_obj_add_bool(doc, t, "reused",
+                              rec->timings.reused_connection);
+      yyjson_mut_arr_append(arr, t);
+    }
+    yyjson_mut_obj_add(root, yyjson_mut_str(doc, "timings"), arr);
+  }
+
   // Write and print
   yyjson_write_err werr;
   char *json =
-      yyjson_mut_write_opts(doc, YYJSON_WRITE_PRETTY, NULL, NULL, &werr);
+      yyjson_mut_write_opts(doc, YYJSON_WRITE_PRETTY, ani_json_alc(), NULL,
+                            &werr);
   if (json) {
     printf("%s\n", json);
-    free(json);
+    ani_free(json);
+  }
+  yyjson_mut_doc_free(doc);
+}
+
+void ani_output_print_timings(void) {
+  ani_http_timing_record *records;
+  size_t count;
+  size_t i;
+  size_t j;
+
+  // Copied once, so the report adds up even if more requests are logged
+  count = ani_http_timings_count();
+  records = count > 0 ? ani_malloc(count * sizeof(*records)) : NULL;
+  for (i = 0; records != NULL && i < count; i++) {
+    if (!ani_http_timings_get(i, &records[i])) {
+      break;
+    }
+  }
+  count = records != NULL ? i : 0;
+  if (count == 0) {
+    printf("Timings: no HTTP requests made\n");
+    ani_free(records);
+
+    return;
+  }
+
+  printf("Timings (ms)\n");
+  printf("  %-10s %6s %8s %8s %8s %8s %8s %9s %7s %6s\n", "Provider",
+         "Status", "DNS", "Connect", "TLS", "TTFB", "Total", "Bytes",
+         "Retries", "Reused");
+
+  for (i = 0; i < count; i++) {
+    const ani_http_timing_record *rec = &records[i];
+    const ani_http_timings *t = &rec->timings;
+    printf("  %-10s %6ld %8.1f %8.1f %8.1f %8.1f %8.1f %9zu %7d %6s\n",
+           rec->provider, rec->status_code, t->namelookup_ms, t->connect_ms,
+           t->appconnect_ms, t->starttransfer_ms, t->total_ms,
+           t->bytes_downloaded, t->retries,
+           t->reused_connection ? "yes" : "no");
+  }
+
+  // Per-provider totals, in order of first appearance
+  printf("\n");
+  for (i = 0; i < count; i++) {
+    const char *provider = records[i].provider;
+    size_t requests;
+    double total_ms;
+    size_t bytes;
+    bool seen;
+
+    seen = false;
+    for (j = 0; j < i; j++) {
+      if (strcmp(records[j].provider, provider) == 0) {
+        seen = true;
+        break;
+      }
+    }
+    if (seen) {
+      continue;
+    }
+
+    requests = 0;
+    total_ms = 0.0;
+    bytes = 0;
+    for (j = i; j < count; j++) {
+      const ani_http_timing_record *rec = &records[j];
+      if (strcmp(rec->provider, provider) == 0) {
+        requests++;
+        total_ms += rec->timings.total_ms;
+        bytes += rec->timings.bytes_downloaded;
+      }
+    }
+
+    printf("  %-10s %zu request%s, %.1f ms, %zu bytes\n", provider, requests,
+           requests == 1 ? "" : "s", total_ms, bytes);
+  }
+
+  ani_free(records);
+}
+
+void ani_output_print_suggestions(const ani_index_match *matches, size_t count,
+                                  bool json) {
+  yyjson_mut_doc *doc;
+  yyjson_mut_val *arr;
+  yyjson_mut_val *obj;
+  yyjson_write_err werr;
+  char *out;
+  size_t i;
+
+  if (!json) {
+    for (i = 0; i < count; i++) {
+      printf("%s\n", matches[i].title);
+    }
+
+    return;
+  }
+
+  doc = yyjson_mut_doc_new(ani_json_alc());
+  if (doc == NULL) {
+    return;
+  }
+  arr = yyjson_mut_arr(doc);
+  yyjson_mut_doc_set_root(doc, arr);
+
+  for (i = 0; i < count; i++) {
+    obj = yyjson_mut_obj(doc);
+    yyjson_mut_obj_add_str(doc, obj, "title", matches[i].title);
+    yyjson_mut_obj_add_str(doc, obj, "id", matches[i].id);
+    yyjson_mut_obj_add_str(doc, obj, "type",
+                           matches[i].media_type == ANI_MEDIA_ANIME ? "anime"
+                                                                    : "manga");
+    yyjson_mut_obj_add_real(doc, obj, "similarity", matches[i].similarity);
+    yyjson_mut_arr_append(arr, obj);
+  }
+
+  out = yyjson_mut_write_opts(doc, YYJSON_WRITE_PRETTY, ani_json_alc(), NULL,
+                              &werr);
+  if (out != NULL) {
+    printf("%s\n", out);
+    ani_free(out);
   }
   yyjson_mut_doc_free(doc);
 }
+
+static void local_time(int64_t epoch, struct tm *out) {
+  time_t t;
+
+  t = (time_t)epoch;
+#ifdef _WIN32
+  localtime_s(out, &t);
+#else
+  localtime_r(&t, out);
+#endif
+}
+
+static void print_calendar_json(const ani_calendar *calendar, int64_t from,
+                                int64_t to) {
+  yyjson_mut_doc *doc;
+  yyjson_mut_val *arr;
+  yyjson_mut_val *obj;
+  yyjson_write_err werr;
+  const ani_airing *entry;
+  ani_date date;
+  char buf[64];
+  char *out;
+  size_t i;
+
+  doc = yyjson_mut_doc_new(ani_json_alc());
+  if (doc == NULL) {
+    return;
+  }
+  arr = yyjson_mut_arr(doc);
+  yyjson_mut_doc_set_root(doc, arr);
+
+  for (i = 0; i < calendar->count; i++) {
+    entry = &calendar->entries[i];
+    if (entry->airing_at < from || entry->airing_at >= to) {
+      continue;
+    }
+
+    ani_parse_unix_timestamp((long)entry->airing_at, &date);
+    ani_format_datetime(&date, buf, sizeof(buf));
+
+    obj = yyjson_mut_obj(doc);
+    yyjson_mut_obj_add_str(doc, obj, "title", entry->title);
+    yyjson_mut_obj_add_int(doc, obj, "episode", entry->episode);
+    if (entry->episodes > 0) {
+      yyjson_mut_obj_add_int(doc, obj, "total_episodes", entry->episodes);
+    } else {
+      yyjson_mut_obj_add_null(doc, obj, "total_episodes");
+    }
+    yyjson_mut_obj_add_strcpy(doc, obj, "date", buf);
+    if (entry->mal_id > 0) {
+      yyjson_mut_obj_add_int(doc, obj, "mal_id", entry->mal_id);
+    } else {
+      yyjson_mut_obj_add_null(doc, obj, "mal_id");
+    }
+    yyjson_mut_obj_add_int(doc, obj, "anilist_id", entry->anilist_id);
+    yyjson_mut_arr_append(arr, obj);
+  }
+
+  out = yyjson_mut_write_opts(doc, YYJSON_WRITE_PRETTY, ani_json_alc(), NULL,
+                              &werr);
+  if (out != NULL) {
+    printf("%s\n", out);
+    ani_free(out);
+  }
+  yyjson_mut_doc_free(doc);
+}
+
+void ani_output_print_calendar(const ani_calendar *calendar, int64_t from,
+                               int64_t to, bool json) {
+  const ani_airing *entry;
+  struct tm tm_info;
+  char day[32];
+  char last_day[32];
+  size_t i;
+
+  if (calendar == NULL) {
+    return;
+  }
+
+  if (json) {
+    print_calendar_json(calendar, from, to);
+
+    return;
+  }
+
+  last_day[0] = '\0';
+  for (i = 0; i < calendar->count; i++) {
+    entry = &calendar->entries[i];
+    if (entry->airing_at < from || entry->airing_at >= to) {
+      continue;
+    }
+
+    local_time(entry->airing_at, &tm_info);
+    strftime(day, sizeof(day), "%a %Y-%m-%d", &tm_info);
+    if (strcmp(day, last_day) != 0) {
+      printf("%s%s\n", last_day[0] != '\0' ? "\n" : "", day);
+      memcpy(last_day, day, sizeof(day));
+    }
+
+    printf("  %02d:%02d  Ep %-4d %s\n", tm_info.tm_hour, tm_info.tm_min,
+           entry->episode, entry->title);
+  }
+
+  if (last_day[0] == '\0') {
+    printf("Nothing airing\n");
+  }
+}
@@ -0,0 +1,79 @@
+/*
+ * Routine: ani — Anime/Manga scheduling information CLI
+ * Author: DannyBimma
+ * Copyright: (c) 2025 Technomancer Pirate Captain. All Rights Reserved.
+ */
+
+#include "ani/broadcast.h"
+#include "ani/log.h"
+#include "ani/time.h"
+#include <stdint.h>
+
+#define DAY 86400
+#define WEEK (7 * DAY)
+#define JST_OFFSET (9 * 3600) // Japan keeps no daylight saving time
+
+// First slot on or after the premiere: the premiere's day in Japan at the
+// slot's time, moved on to the slot's weekday
+static int64_t first_slot(const ani_broadcast *slot) {
+  int64_t local;
+  int64_t day;
+  int weekday;
+
+  local = slot->premiere + JST_OFFSET;
+  day = local / DAY - (local % DAY < 0 ? 1 : 0);
+
+  // 1970-01-01 was a Thursday
+  weekday = (int)(((day + 4) % 7 + 7) % 7);
+  day += (slot->weekday - weekday + 7) % 7;
+
+  return day * DAY + (int64_t)slot->minute * 60 - JST_OFFSET;
+}
+
+static void set_date(int64_t epoch, ani_date *out) {
+  ani_instant instant;
+
+  instant.epoch = epoch;
+  instant.offset_minutes = 0;
+  instant.has_time = true;
+  ani_instant_to_date(&instant, out);
+}
+
+bool ani_broadcast_estimate(time_t now, ani_release_info *release) {
+  const ani_broadcast *slot;
+  int64_t first;
+  int64_t aired;
+
+  if (release == NULL || release->next_number > 0) {
+    return false;
+  }
+
+  slot = &release->broadcast;
+  if (!slot->airing || slot->weekday < 0 || slot->premiere <= 0) {
+    return false;
+  }
+
+  first = first_slot(slot);
+  aired = (int64_t)now < first ? 0 : ((int64_t)now - first) / WEEK + 1;
+  if (release->total_count > 0 && aired >= release->total_count) {
+    LOG_DEBUG("All %d episodes have aired by the broadcast slot",
+              release->total_count);
+
+    return false;
+  }
+
+  if (aired > 0) {
+    release->latest_number = (int)aired;
+    set_date(first + (aired - 1) * WEEK, &release->latest_date);
+  }
+  release->next_number = (int)aired + 1;
+  set_date(first + aired * WEEK, &release->next_date);
+  release->next_source = ANI_SOURCE_BROADCAST;
+  release->next_confidence = ANI_CONFIDENCE_ESTIMATED;
+  release->provider_name = "broadcast estimate";
+
+  LOG_DEBUG("Broadcast: episode %d of a weekly slot since %lld",
+            release->next_number, (long long)first);
+
+  return true;
+}
@@ -5,57 +5,81 @@
  */
 
 #include "ani/cache.h"
+#include "ani/alloc.h"
 #include "ani/fs.h"
 #include "ani/log.h"
+#include "ani/metrics.h"
 #include "ani/str.h"
+#include "ani/trace.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
 
-static char *cache_dir = NULL;
+struct ani_cache {
+  char *dir;
+};
 
-bool ani_cache_init(void) {
-  if (cache_dir != NULL) {
-    return true; // Already initted
+ani_cache *ani_cache_open(const char *dir) {
+  ani_cache *cache;
+
+  cache = ani_calloc(1, sizeof(*cache));
+  if (cache == NULL) {
+    return NULL;
   }
 
-  cache_dir = ani_get_cache_dir();
-  if (cache_dir == NULL) {
+  cache->dir = dir != NULL ? ani_strdup(dir) : ani_get_cache_dir();
+  if (cache->dir == NULL) {
     LOG_WARN("Failed to get cache directory");
+    ani_free(cache);
 
-    return false;
+    return NULL;
   }
 
   // Create cache directory if it doesn't exist
-  if (!ani_mkdir_p(cache_dir)) {
-    LOG_WARN("Failed to create cache directory: %s", cache_dir);
-    free(cache_dir);
-    cache_dir = NULL;
+  if (!ani_mkdir_p(cache->dir)) {
+    LOG_WARN("Failed to create cache directory: %s", cache->dir);
+    ani_free(cache->dir);
+    ani_free(cache);
 
-    return false;
+    return NULL;
   }
 
-  LOG_DEBUG("Cache initialized: %s", cache_dir);
-  return true;
+  LOG_DEBUG("Cache initialized: %s", cache->dir);
+  return cache;
 }
 
-static char *get_cache_path(const char *provider, const char *key) {
+void ani_cache_close(ani_cache *cache) {
+  if (cache == NULL) {
+    return;
+  }
+
+  ani_free(cache->dir);
+  ani_free(cache);
+}
+
+const char *ani_cache_dir(const ani_cache *cache) {
+  return cache != NULL ? cache->dir : NULL;
+}
+
+static char *get_cache_path(const ani_cache *cache, const char *provider,
+                            const char *key) {
   char filename[512];
   char *path;
 
-  if (cache_dir == NULL || provider == NULL || key == NULL) {
+  if (cache == NULL || provider == NULL || key == NULL) {
     return NULL;
   }
 
   // Simple filename: provider_key.json
   snprintf(filename, sizeof(filename), "%s_%s.json", provider, key);
 
-  path = ani_path_join(cache_dir, filename);
+  path = ani_path_join(cache->dir, filename);
   return path;
 }
 
-char *ani_cache_get(const char *provider, const char *key, time_t max_age) {
+static char *cache_read(const ani_cache *cache, const char *provider,
+                        const char *key, time_t max_age) {
   char *path;
   struct stat st;
   FILE *f;
@@ -65,38 +89,44 @@ char *ani_cache_get(const char *provider, const char *key, time_t max_age) {
   time_t now;
   time_t age;
 
-  path = get_cache_path(provider, key);
+  path = get_cache_path(cache, provider, key);
   if (path == NULL) {
     return NULL;
   }
 
   // Check if file exists and get stats
   if (stat(path, &st) != 0) {
-    free(path);
+    ani_free(path);
+    ani_metrics_cache_miss();
 
     return NULL; // File doesn't exist
   }
 
-  // Check age
+  // Check age. Expired entries stay until too old even to stand in for a
+  // provider that is down (ani_ctx_fetch reads them then).
   now = time(NULL);
   age = now - st.st_mtime;
   if (age > max_age) {
     LOG_DEBUG("Cache expired for %s/%s (age: %ld sec)", provider, key, age);
-    free(path);
+    if (age > ANI_CACHE_TTL_STALE && remove(path) == 0) {
+      ani_metrics_cache_eviction();
+    }
+    ani_free(path);
+    ani_metrics_cache_miss();
 
     return NULL;
   }
 
   // Read file
   f = fopen(path, "r");
-  free(path);
+  ani_free(path);
 
   if (f == NULL) {
     return NULL;
   }
 
   file_size = (size_t)st.st_size;
-  data = malloc(file_size + 1);
+  data = ani_malloc(file_size + 1);
   if (data == NULL) {
     fclose(f);
 
@@ -107,44 +137,52 @@ char *ani_cache_get(const char *provider, const char *key, time_t max_age) {
   fclose(f);
 
   if (read_size != file_size) {
-    free(data);
+    ani_free(data);
 
     return NULL;
   }
 
   data[file_size] = '\0';
   LOG_DEBUG("Cache hit for %s/%s", provider, key);
+  ani_metrics_cache_hit();
 
   return data;
 }
 
-bool ani_cache_set(const char *provider, const char *key, const char *data) {
+char *ani_cache_get(ani_cache *cache, const char *provider, const char *key,
+                    time_t max_age) {
+  ani_trace_span span;
+  char *data;
+
+  ANI_TRACE_BEGIN(span, "cache.get", "cache");
+  ANI_TRACE_DETAIL(span, key);
+  data = cache_read(cache, provider, key, max_age);
+  ANI_TRACE_END(span);
+
+  return data;
+}
+
+bool ani_cache_set(ani_cache *cache, const char *provider, const char *key,
+                   const char *data) {
   char *path;
-  FILE *f;
   size_t data_len;
-  size_t written;
+  bool ok;
 
   if (data == NULL) {
     return false;
   }
 
-  path = get_cache_path(provider, key);
+  path = get_cache_path(cache, provider, key);
   if (path == NULL) {
     return false;
   }
 
-  f = fopen(path, "w");
-  free(path);
-
-  if (f == NULL) {
-    return false;
-  }
-
+  // Concurrent readers see either the old or the new entry, never a mix
   data_len = strlen(data);
-  written = fwrite(data, 1, data_len, f);
-  fclose(f);
+  ok = ani_write_file_atomic(path, data, data_len);
+  ani_free(path);
 
-  if (written != data_len) {
+  if (!ok) {
     return false;
   }
 
@@ -152,7 +190,9 @@ bool ani_cache_set(const char *provider, const char *key, const char *data) {
   return true;
 }
 
-void ani_cache_clear(void) {
+void ani_cache_clear(ani_cache *cache) {
+  (void)cache;
+
   // TODO: Implement cache clearing
   LOG_INFO("Still not yet implemented...");
 }
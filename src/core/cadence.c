@@ -0,0 +1,292 @@
+/*
+ * Routine: ani — Anime/Manga scheduling information CLI
+ * Author: DannyBimma
+ * Copyright: (c) 2025 Technomancer Pirate Captain. All Rights Reserved.
+ */
+
+#include "ani/cadence.h"
+#include "ani/alloc.h"
+#include "ani/log.h"
+#include "ani/time.h"
+#include <stdio.h>
+#include <string.h>
+
+#define CADENCE_MAGIC "ani-cadence 1"
+#define DAY 86400
+#define RELEASE_WINDOW DAY // Chapters this close together are one release
+#define HIATUS_GAPS 3      // Gaps of silence that mean a hiatus
+
+static void cache_key(const char *id, char *key, size_t size) {
+  snprintf(key, size, "history_%s", id);
+}
+
+void ani_cadence_load(ani_cache *cache, const char *provider, const char *id,
+                      ani_cadence *history) {
+  char key[128];
+  char *data;
+  char *line;
+  char *next;
+  int number;
+  long long published;
+  int seeded;
+
+  if (history == NULL) {
+    return;
+  }
+
+  memset(history, 0, sizeof(*history));
+  if (cache == NULL || id == NULL) {
+    return;
+  }
+
+  cache_key(id, key, sizeof(key));
+  data = ani_cache_get(cache, provider, key, ANI_CACHE_TTL_HISTORY);
+  if (data == NULL) {
+    return;
+  }
+
+  if (strncmp(data, CADENCE_MAGIC "\n", sizeof(CADENCE_MAGIC)) != 0) {
+    LOG_DEBUG("Ignoring unrecognized history for %s", id);
+    ani_free(data);
+
+    return;
+  }
+
+  // ani-cadence 1
+  // seeded <0|1>
+  // <chapter> <published>   (one per chapter)
+  for (line = data; line != NULL && *line != '\0'; line = next) {
+    next = strchr(line, '\n');
+    if (next != NULL) {
+      *next++ = '\0';
+    }
+
+    if (sscanf(line, "seeded %d", &seeded) == 1) {
+      history->seeded = seeded != 0;
+    } else if (sscanf(line, "%d %lld", &number, &published) == 2) {
+      ani_cadence_add(history, number, (int64_t)published);
+    }
+  }
+
+  ani_free(data);
+}
+
+bool ani_cadence_save(ani_cache *cache, const char *provider, const char *id,
+                      const ani_cadence *history) {
+  char key[128];
+  char text[64 + ANI_CADENCE_MAX * 40];
+  size_t used;
+  size_t i;
+
+  if (cache == NULL || id == NULL || history == NULL) {
+    return false;
+  }
+
+  used = (size_t)snprintf(text, sizeof(text), "%s\nseeded %d\n",
+                          CADENCE_MAGIC, history->seeded ? 1 : 0);
+  for (i = 0; i < history->count && used < sizeof(text); i++) {
+    used += (size_t)snprintf(text + used, sizeof(text) - used, "%d %lld\n",
+                             history->entries[i].number,
+                             (long long)history->entries[i].published);
+  }
+  if (used >= sizeof(text)) {
+    return false;
+  }
+
+  cache_key(id, key, sizeof(key));
+  return ani_cache_set(cache, provider, key, text);
+}
+
+bool ani_cadence_add(ani_cadence *history, int number, int64_t published) {
+  ani_cadence_entry *entries;
+  size_t pos;
+  size_t i;
+
+  if (history == NULL || number <= 0 || published <= 0) {
+    return false;
+  }
+
+  entries = history->entries;
+  for (i = 0; i < history->count; i++) {
+    if (entries[i].number == number) {
+      return false;
+    }
+  }
+
+  pos = history->count;
+  while (pos > 0 && entries[pos - 1].published > published) {
+    pos--;
+  }
+
+  // Full: the oldest chapter makes room, unless this one is older still
+  if (history->count == ANI_CADENCE_MAX) {
+    if (pos == 0) {
+      return false;
+    }
+
+    memmove(&entries[0], &entries[1], (pos - 1) * sizeof(*entries));
+    pos--;
+  } else {
+    memmove(&entries[pos + 1], &entries[pos],
+            (history->count - pos) * sizeof(*entries));
+    history->count++;
+  }
+
+  entries[pos].number = number;
+  entries[pos].published = published;
+
+  return true;
+}
+
+// Start times of releases (chapters within RELEASE_WINDOW merged), oldest
+// first; returns how many
+static size_t releases(const ani_cadence *history, int64_t *out) {
+  size_t count;
+  size_t i;
+
+  count = 0;
+  for (i = 0; i < history->count; i++) {
+    if (count == 0 ||
+        history->entries[i].published - out[count - 1] >= RELEASE_WINDOW) {
+      out[count++] = history->entries[i].published;
+    }
+  }
+
+  return count;
+}
+
+bool ani_cadence_ready(const ani_cadence *history) {
+  int64_t starts[ANI_CADENCE_MAX];
+
+  return history != NULL && releases(history, starts) > ANI_CADENCE_MIN_GAPS;
+}
+
+// Median of count gaps (sorted in place)
+static int64_t median(int64_t *gaps, size_t count) {
+  size_t i;
+  size_t j;
+  int64_t gap;
+
+  for (i = 1; i < count; i++) {
+    gap = gaps[i];
+    for (j = i; j > 0 && gaps[j - 1] > gap; j--) {
+      gaps[j] = gaps[j - 1];
+    }
+    gaps[j] = gap;
+  }
+
+  return count % 2 == 1 ? gaps[count / 2]
+                        : (gaps[count / 2 - 1] + gaps[count / 2]) / 2;
+}
+
+// The same day of the next month (clamped to its last day), at 00:00 UTC
+static int64_t next_month(int64_t epoch) {
+  static const int days_in_month[] = {31, 28, 31, 30, 31, 30,
+                                      31, 31, 30, 31, 30, 31};
+  ani_instant instant;
+  ani_date date;
+  int last;
+
+  instant.epoch = epoch;
+  instant.offset_minutes = 0;
+  instant.has_time = false;
+  ani_instant_to_date(&instant, &date);
+
+  if (++date.month > 12) {
+    date.month = 1;
+    date.year++;
+  }
+  last = days_in_month[date.month - 1];
+  if (date.month == 2 && date.year % 4 == 0 &&
+      (date.year % 100 != 0 || date.year % 400 == 0)) {
+    last = 29;
+  }
+  if (date.day > last) {
+    date.day = last;
+  }
+
+  if (!ani_date_to_instant(&date, &instant)) {
+    return epoch + 30 * DAY;
+  }
+
+  return instant.epoch;
+}
+
+bool ani_cadence_estimate(const ani_cadence *history, time_t now,
+                          ani_release_info *release) {
+  int64_t starts[ANI_CADENCE_MAX];
+  int64_t gaps[ANI_CADENCE_MAX];
+  size_t count;
+  size_t i;
+  int64_t gap;
+  int64_t step;
+  int64_t next;
+  bool monthly;
+  bool snapped;
+  int latest;
+  ani_instant instant;
+
+  if (history == NULL || release == NULL || release->next_number > 0) {
+    return false;
+  }
+
+  count = releases(history, starts);
+  if (count <= ANI_CADENCE_MIN_GAPS) {
+    return false;
+  }
+
+  for (i = 1; i < count; i++) {
+    gaps[i - 1] = starts[i] - starts[i - 1];
+  }
+  gap = median(gaps, count - 1);
+
+  if ((int64_t)now - starts[count - 1] > HIATUS_GAPS * gap) {
+    LOG_INFO("No chapter for %lld days (usually every %lld): on hiatus?",
+             (long long)(((int64_t)now - starts[count - 1]) / DAY),
+             (long long)(gap / DAY));
+
+    return false;
+  }
+
+  // Serialized manga keep to their magazine's schedule
+  monthly = false;
+  snapped = true;
+  if (gap >= 6 * DAY && gap <= 8 * DAY) {
+    step = 7 * DAY;
+  } else if (gap >= 12 * DAY && gap <= 16 * DAY) {
+    step = 14 * DAY;
+  } else if (gap >= 27 * DAY && gap <= 33 * DAY) {
+    step = 30 * DAY;
+    monthly = true;
+  } else {
+    step = gap > DAY ? gap : DAY;
+    snapped = false;
+  }
+
+  // Slots that passed without a chapter were skipped; the next is still
+  // the following chapter
+  next = starts[count - 1];
+  do {
+    next = monthly ? next_month(next) : next + step;
+  } while (next + DAY <= (int64_t)now);
+
+  latest = history->entries[history->count - 1].number;
+  if (release->latest_number > latest) {
+    latest = release->latest_number;
+  }
+
+  instant.epoch = next;
+  instant.offset_minutes = 0;
+  instant.has_time = false;
+  ani_instant_to_date(&instant, &release->next_date);
+  release->next_number = latest + 1;
+  release->next_source = ANI_SOURCE_CADENCE_HEURISTIC;
+  release->next_confidence =
+      snapped ? ANI_CONFIDENCE_ESTIMATED : ANI_CONFIDENCE_LOW;
+  release->provider_name = "cadence estimate";
+
+  LOG_DEBUG("Cadence: every %lld days%s from %zu releases",
+            (long long)(step / DAY), snapped ? " (snapped)" : "", count);
+
+  return true;
+}
@@ -0,0 +1,307 @@
+/*
+ * Routine: ani — Anime/Manga scheduling information CLI
+ * Author: DannyBimma
+ * Copyright: (c) 2025 Technomancer Pirate Captain. All Rights Reserved.
+ */
+
+#include "ani/calendar.h"
+#include "ani/alloc.h"
+#include "ani/log.h"
+#include "ani/str.h"
+#include "ani/time.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CALENDAR_PROVIDER "anilist"
+#define CALENDAR_KEY "calendar"
+#define CALENDAR_MAGIC "ani-calendar 1"
+#define CALENDAR_LINE_MAX 320 // Numbers plus a title, cut to fit
+
+ani_calendar *ani_calendar_new(int64_t from, int64_t to) {
+  ani_calendar *calendar;
+
+  calendar = ani_calloc(1, sizeof(*calendar));
+  if (calendar == NULL) {
+    return NULL;
+  }
+
+  calendar->arena = ani_arena_new(0);
+  if (calendar->arena == NULL) {
+    ani_free(calendar);
+
+    return NULL;
+  }
+
+  calendar->from = from;
+  calendar->to = to;
+
+  return calendar;
+}
+
+ani_calendar *ani_calendar_copy(const ani_calendar *calendar) {
+  ani_calendar *copy;
+  const ani_airing *entry;
+  size_t i;
+
+  if (calendar == NULL) {
+    return NULL;
+  }
+
+  copy = ani_calendar_new(calendar->from, calendar->to);
+  if (copy == NULL) {
+    return NULL;
+  }
+  copy->fetched = calendar->fetched;
+
+  for (i = 0; i < calendar->count; i++) {
+    entry = &calendar->entries[i];
+    if (!ani_calendar_add(copy, entry->airing_at, entry->episode,
+                          entry->mal_id, entry->anilist_id, entry->episodes,
+                          entry->title)) {
+      ani_calendar_free(copy);
+
+      return NULL;
+    }
+  }
+
+  return copy;
+}
+
+void ani_calendar_free(ani_calendar *calendar) {
+  if (calendar == NULL) {
+    return;
+  }
+
+  ani_arena_free(calendar->arena);
+  ani_free(calendar->entries);
+  ani_free(calendar);
+}
+
+bool ani_calendar_add(ani_calendar *calendar, int64_t airing_at, int episode,
+                      long mal_id, long anilist_id, int episodes,
+                      const char *title) {
+  ani_airing *entries;
+  ani_airing *entry;
+  size_t capacity;
+
+  if (calendar == NULL) {
+    return false;
+  }
+
+  if (calendar->count == calendar->capacity) {
+    capacity = calendar->capacity > 0 ? calendar->capacity * 2 : 64;
+    entries = ani_realloc(calendar->entries, capacity * sizeof(*entries));
+    if (entries == NULL) {
+      return false;
+    }
+
+    calendar->entries = entries;
+    calendar->capacity = capacity;
+  }
+
+  entry = &calendar->entries[calendar->count++];
+  entry->airing_at = airing_at;
+  entry->episode = episode;
+  entry->mal_id = mal_id;
+  entry->anilist_id = anilist_id;
+  entry->episodes = episodes;
+  entry->title = ani_arena_strdup(calendar->arena, title != NULL ? title : "");
+
+  return entry->title != NULL;
+}
+
+static int compare_airing(const void *a, const void *b) {
+  const ani_airing *x = a;
+  const ani_airing *y = b;
+
+  return (x->airing_at > y->airing_at) - (x->airing_at < y->airing_at);
+}
+
+void ani_calendar_sort(ani_calendar *calendar) {
+  if (calendar != NULL && calendar->count > 1) {
+    qsort(calendar->entries, calendar->count, sizeof(*calendar->entries),
+          compare_airing);
+  }
+}
+
+// Parse the snapshot:
+//   ani-calendar 1
+//   window <fetched> <from> <to>
+//   <airing at> <episode> <MAL ID> <AniList ID> <episodes> <title>
+ani_calendar *ani_calendar_load(ani_cache *cache) {
+  ani_calendar *calendar;
+  char *data;
+  char *line;
+  char *next;
+  long long fetched;
+  long long from;
+  long long to;
+  long long airing_at;
+  int episode;
+  long mal_id;
+  long anilist_id;
+  int episodes;
+  int title_at;
+
+  if (cache == NULL) {
+    return NULL;
+  }
+
+  data = ani_cache_get(cache, CALENDAR_PROVIDER, CALENDAR_KEY,
+                       (time_t)ANI_CALENDAR_DAYS_MAX * 86400);
+  if (data == NULL) {
+    return NULL;
+  }
+
+  line = data + sizeof(CALENDAR_MAGIC);
+  if (strncmp(data, CALENDAR_MAGIC "\n", sizeof(CALENDAR_MAGIC)) != 0 ||
+      sscanf(line, "window %lld %lld %lld", &fetched, &from, &to) != 3) {
+    LOG_DEBUG("Ignoring unrecognized calendar snapshot");
+    ani_free(data);
+
+    return NULL;
+  }
+
+  calendar = ani_calendar_new((int64_t)from, (int64_t)to);
+  if (calendar == NULL) {
+    ani_free(data);
+
+    return NULL;
+  }
+  calendar->fetched = (int64_t)fetched;
+
+  for (line = strchr(line, '\n'); line != NULL && *++line != '\0';
+       line = next) {
+    next = strchr(line, '\n');
+    if (next != NULL) {
+      *next = '\0';
+    }
+
+    if (sscanf(line, "%lld %d %ld %ld %d %n", &airing_at, &episode, &mal_id,
+               &anilist_id, &episodes, &title_at) == 5 &&
+        !ani_calendar_add(calendar, (int64_t)airing_at, episode, mal_id,
+                          anilist_id, episodes, line + title_at)) {
+      ani_calendar_free(calendar);
+      ani_free(data);
+
+      return NULL;
+    }
+  }
+
+  ani_free(data);
+  ani_calendar_sort(calendar);
+
+  return calendar;
+}
+
+bool ani_calendar_save(ani_cache *cache, const ani_calendar *calendar) {
+  char *text;
+  char title[CALENDAR_LINE_MAX - 64];
+  size_t size;
+  size_t used;
+  size_t i;
+  size_t j;
+  bool ok;
+
+  if (cache == NULL || calendar == NULL) {
+    return false;
+  }
+
+  size = 128 + calendar->count * CALENDAR_LINE_MAX;
+  text = ani_malloc(size);
+  if (text == NULL) {
+    return false;
+  }
+
+  used = (size_t)snprintf(text, size, "%s\nwindow %lld %lld %lld\n",
+                          CALENDAR_MAGIC, (long long)calendar->fetched,
+                          (long long)calendar->from, (long long)calendar->to);
+  for (i = 0; i < calendar->count && used < size; i++) {
+    // One line per episode, whatever the title holds
+    ani_strlcpy(title, calendar->entries[i].title, sizeof(title));
+    for (j = 0; title[j] != '\0'; j++) {
+      if (title[j] == '\n' || title[j] == '\r') {
+        title[j] = ' ';
+      }
+    }
+
+    used += (size_t)snprintf(
+        text + used, size - used, "%lld %d %ld %ld %d %s\n",
+        (long long)calendar->entries[i].airing_at,
+        calendar->entries[i].episode, calendar->entries[i].mal_id,
+        calendar->entries[i].anilist_id, calendar->entries[i].episodes, title);
+  }
+
+  ok = used < size && ani_cache_set(cache, CALENDAR_PROVIDER, CALENDAR_KEY,
+                                     text);
+  ani_free(text);
+
+  return ok;
+}
+
+const ani_airing *ani_calendar_next(const ani_calendar *calendar,
+                                    const char *mal_id, int64_t now) {
+  long id;
+  size_t i;
+
+  if (calendar == NULL || mal_id == NULL) {
+    return NULL;
+  }
+
+  id = atol(mal_id);
+  if (id <= 0) {
+    return NULL;
+  }
+
+  for (i = 0; i < calendar->count; i++) {
+    if (calendar->entries[i].mal_id == id &&
+        calendar->entries[i].airing_at > now) {
+      return &calendar->entries[i];
+    }
+  }
+
+  return NULL;
+}
+
+bool ani_calendar_fill(const ani_calendar *calendar, const char *mal_id,
+                       int64_t now, ani_release_info *release) {
+  const ani_airing *next;
+  const ani_airing *entry;
+
+  if (release == NULL) {
+    return false;
+  }
+
+  next = ani_calendar_next(calendar, mal_id, now);
+  if (next == NULL) {
+    return false;
+  }
+
+  release->next_number = next->episode;
+  ani_parse_unix_timestamp((long)next->airing_at, &release->next_date);
+  release->next_source = ANI_SOURCE_AGGREGATED_API;
+  release->next_confidence = ANI_CONFIDENCE_OFFICIAL;
+  release->provider_name = "AniList";
+  if (release->total_count <= 0 && next->episodes > 0) {
+    release->total_count = next->episodes;
+  }
+
+  // The episode before has a date only if it aired in the window. Any date
+  // the details gave (Jikan's is the premiere) belongs to another episode.
+  if (next->episode > 1) {
+    release->latest_number = next->episode - 1;
+    memset(&release->latest_date, 0, sizeof(release->latest_date));
+    for (entry = calendar->entries; entry < next; entry++) {
+      if (entry->mal_id == next->mal_id &&
+          entry->episode == release->latest_number) {
+        ani_parse_unix_timestamp((long)entry->airing_at,
+                                 &release->latest_date);
+      }
+    }
+  }
+
+  LOG_DEBUG("Calendar: episode %d of MAL ID %s", next->episode, mal_id);
+
+  return true;
+}
@@ -0,0 +1,1223 @@
+/*
+ * Routine: ani — Anime/Manga scheduling information CLI
+ * Author: DannyBimma
+ * Copyright: (c) 2025 Technomancer Pirate Captain. All Rights Reserved.
+ */
+
+#include "ani/index.h"
+#include "ani/alloc.h"
+#include "ani/fs.h"
+#include "ani/log.h"
+#include "ani/str.h"
+#include "ani/thread.h"
+#include "ani/time.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// File layout (native byte order; a foreign file fails the version check
+// and is rebuilt):
+//
+//   header | records[record_count] | keys[key_count] | pool[pool_size]
+//
+// Keys are sorted by (hash, key) so a lookup is a binary search on the
+// hash. Strings live NUL-terminated in the pool; offset 0 is the empty
+// string and means "absent".
+
+#define INDEX_FILE "titles.idx"
+#define INDEX_MAGIC "ANIIDX\r\n"
+#define INDEX_VERSION 1u
+#define INDEX_MAX_RECORDS 16384 // Least recently refreshed series go first
+#define INDEX_HAS_START 0x1u
+#define INDEX_HAS_TIME 0x2u
+
+// Fuzzy matching
+#define GRAMS_MAX ANI_INDEX_KEY_MAX // Distinct trigrams of one key, at most
+#define FUZZY_MIN_COVERAGE 0.5 // Share of the query's trigrams a match needs
+#define FUZZY_ACCEPT 0.7       // Similarity that resolves without a search
+#define FUZZY_MARGIN 0.1       // Required lead over the next series
+#define PREFIX_BOOST 0.25      // Suggestions: key starts with the query
+#define POPULARITY_BOOST 0.1   // Suggestions: many queries led to the series
+
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t record_count;
+  uint32_t key_count;
+  uint32_t pool_size;
+} index_header;
+
+typedef struct {
+  int64_t start_epoch; // Release start from the search, if INDEX_HAS_START
+  int64_t updated;     // Unix time of the last search that matched
+  uint32_t id;         // Pool offsets
+  uint32_t english;
+  uint32_t japanese;
+  uint32_t canonical;
+  int32_t total_count;
+  int16_t start_offset;
+  uint8_t media_type;
+  uint8_t flags;
+} index_record;
+
+typedef struct {
+  uint64_t hash; // FNV-1a of the normalized key
+  uint32_t key;  // Pool offset
+  uint32_t record;
+} index_key;
+
+struct ani_index {
+  char *path;
+  ani_mutex lock;
+  unsigned char *data; // Mapping (or heap copy), NULL when empty
+  size_t size;
+  bool mapped;
+  const index_record *records;
+  const index_key *keys;
+  const char *pool;
+  uint32_t record_count;
+  uint32_t key_count;
+  uint32_t pool_size;
+  // Identity of the loaded file, to notice rewrites by other processes
+  bool present;
+  long long mtime;
+  long long file_size;
+  unsigned long long inode;
+  // Trigram postings over the keys, built on first fuzzy use
+  bool grams_built;
+  uint32_t gram_count;
+  uint32_t *grams;         // Distinct trigrams, sorted
+  uint32_t *gram_offsets;  // gram_count + 1 offsets into postings
+  unsigned char *postings; // Key numbers per trigram as delta varints
+  uint8_t *key_grams;      // Distinct trigrams per key
+  uint16_t *record_keys;   // Keys per record (popularity)
+  uint16_t *hits;          // Scratch: shared trigrams per key
+  uint32_t *touched;       // Scratch: keys with hits
+};
+
+// Index contents while an update is assembled; strings point into the old
+// pool or the caller's series
+typedef struct {
+  index_record rec;
+  const char *id;
+  const char *english;
+  const char *japanese;
+  const char *canonical;
+} build_record;
+
+typedef struct {
+  uint64_t hash;
+  const char *key;
+  uint32_t record;
+} build_key;
+
+typedef struct {
+  uint32_t record;
+  uint32_t key;
+  double similarity;
+  double score;
+} fuzzy_candidate;
+
+static uint64_t key_hash(const char *key, size_t len) {
+  uint64_t hash;
+  size_t i;
+
+  hash = 14695981039346656037ULL;
+  for (i = 0; i < len; i++) {
+    hash ^= (unsigned char)key[i];
+    hash *= 1099511628211ULL;
+  }
+
+  return hash;
+}
+
+size_t ani_index_normalize(const char *src, char *dst, size_t size) {
+  size_t n;
+  unsigned char c;
+
+  if (dst == NULL || size == 0) {
+    return 0;
+  }
+  dst[0] = '\0';
+  if (src == NULL) {
+    return 0;
+  }
+
+  n = 0;
+  for (; *src != '\0' && n + 1 < size; src++) {
+    c = (unsigned char)*src;
+    if (c == '\'') {
+      continue;
+    }
+
+    if (c >= 'A' && c <= 'Z') {
+      dst[n++] = (char)(c + ('a' - 'A'));
+    } else if (c >= 0x80 || (c >= 'a' && c <= 'z') ||
+               (c >= '0' && c <= '9')) {
+      dst[n++] = (char)c;
+    } else {
+      dst[n++] = ' ';
+    }
+  }
+
+  // Never leave half a UTF-8 sequence behind when truncating
+  if (*src != '\0') {
+    while (n > 0 && ((unsigned char)dst[n - 1] & 0xC0) == 0x80) {
+      n--;
+    }
+    if (n > 0 && (unsigned char)dst[n - 1] >= 0xC0) {
+      n--;
+    }
+  }
+
+  dst[n] = '\0';
+  return ani_str_collapse_ws(dst);
+}
+
+static const char *pool_str(const ani_index *index, uint32_t off) {
+  if (off == 0 || off >= index->pool_size) {
+    return NULL;
+  }
+
+  return index->pool + off;
+}
+
+static void grams_free(ani_index *index) {
+  ani_free(index->grams);
+  ani_free(index->gram_offsets);
+  ani_free(index->postings);
+  ani_free(index->key_grams);
+  ani_free(index->record_keys);
+  ani_free(index->hits);
+  ani_free(index->touched);
+  index->grams = NULL;
+  index->gram_offsets = NULL;
+  index->postings = NULL;
+  index->key_grams = NULL;
+  index->record_keys = NULL;
+  index->hits = NULL;
+  index->touched = NULL;
+  index->gram_count = 0;
+  index->grams_built = false;
+}
+
+static void index_unload(ani_index *index) {
+  grams_free(index);
+  if (index->data != NULL) {
+#ifndef _WIN32
+    if (index->mapped) {
+      munmap(index->data, index->size);
+    } else {
+      ani_free(index->data);
+    }
+#else
+    ani_free(index->data);
+#endif
+  }
+
+  index->data = NULL;
+  index->size = 0;
+  index->mapped = false;
+  index->records = NULL;
+  index->keys = NULL;
+  index->pool = NULL;
+  index->record_count = 0;
+  index->key_count = 0;
+  index->pool_size = 0;
+  index->present = false;
+}
+
+static bool index_validate(ani_index *index) {
+  index_header header;
+  size_t records_size;
+  size_t keys_size;
+  size_t offset;
+
+  if (index->size < sizeof(header)) {
+    return false;
+  }
+
+  memcpy(&header, index->data, sizeof(header));
+  if (memcmp(header.magic, INDEX_MAGIC, sizeof(header.magic)) != 0 ||
+      header.version != INDEX_VERSION || header.pool_size == 0) {
+    return false;
+  }
+
+  records_size = (size_t)header.record_count * sizeof(index_record);
+  keys_size = (size_t)header.key_count * sizeof(index_key);
+  if (index->size - sizeof(header) < records_size ||
+      index->size - sizeof(header) - records_size < keys_size ||
+      index->size - sizeof(header) - records_size - keys_size !=
+          header.pool_size) {
+    return false;
+  }
+
+  offset = sizeof(header);
+  index->records = (const index_record *)(const void *)(index->data + offset);
+  offset += records_size;
+  index->keys = (const index_key *)(const void *)(index->data + offset);
+  offset += keys_size;
+  index->pool = (const char *)index->data + offset;
+
+  // Every pool string must end inside the pool
+  if (index->pool[0] != '\0' || index->pool[header.pool_size - 1] != '\0') {
+    return false;
+  }
+
+  index->record_count = header.record_count;
+  index->key_count = header.key_count;
+  index->pool_size = header.pool_size;
+  return true;
+}
+
+static void index_load(ani_index *index) {
+  struct stat st;
+#ifndef _WIN32
+  int fd;
+  void *map;
+#endif
+
+  index_unload(index);
+  if (stat(index->path, &st) != 0) {
+    return;
+  }
+
+  index->present = true;
+  index->mtime = (long long)st.st_mtime;
+  index->file_size = (long long)st.st_size;
+  index->inode = (unsigned long long)st.st_ino;
+  if (st.st_size <= 0) {
+    return;
+  }
+
+#ifndef _WIN32
+  fd = open(index->path, O_RDONLY);
+  if (fd < 0) {
+    return;
+  }
+  map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    return;
+  }
+  index->data = map;
+  index->size = (size_t)st.st_size;
+  index->mapped = true;
+#else
+  index->data = (unsigned char *)ani_read_file(index->path, &index->size);
+  if (index->data == NULL) {
+    return;
+  }
+#endif
+
+  if (!index_validate(index)) {
+    LOG_WARN("Ignoring unreadable title index: %s", index->path);
+    index_unload(index);
+    // Keep the identity so a bad file is not reloaded on every lookup
+    index->present = true;
+    index->mtime = (long long)st.st_mtime;
+    index->file_size = (long long)st.st_size;
+    index->inode = (unsigned long long)st.st_ino;
+
+    return;
+  }
+
+  LOG_DEBUG("Title index loaded: %u series, %u keys", index->record_count,
+            index->key_count);
+}
+
+// Reload if another process replaced the file since it was loaded
+static void index_refresh(ani_index *index) {
+  struct stat st;
+
+  if (stat(index->path, &st) != 0) {
+    if (index->present) {
+      index_unload(index);
+    }
+
+    return;
+  }
+
+  if (index->present && index->mtime == (long long)st.st_mtime &&
+      index->file_size == (long long)st.st_size &&
+      index->inode == (unsigned long long)st.st_ino) {
+    return;
+  }
+
+  index_load(index);
+}
+
+ani_index *ani_index_open(const char *dir) {
+  ani_index *index;
+
+  if (dir == NULL) {
+    return NULL;
+  }
+
+  index = ani_calloc(1, sizeof(*index));
+  if (index == NULL) {
+    return NULL;
+  }
+
+  index->path = ani_path_join(dir, INDEX_FILE);
+  if (index->path == NULL) {
+    ani_free(index);
+
+    return NULL;
+  }
+
+  ani_mutex_init(&index->lock);
+  index_load(index);
+  return index;
+}
+
+void ani_index_close(ani_index *index) {
+  if (index == NULL) {
+    return;
+  }
+
+  index_unload(index);
+  ani_mutex_destroy(&index->lock);
+  ani_free(index->path);
+  ani_free(index);
+}
+
+size_t ani_index_count(ani_index *index) {
+  size_t count;
+
+  if (index == NULL) {
+    return 0;
+  }
+
+  ani_mutex_lock(&index->lock);
+  index_refresh(index);
+  count = index->record_count;
+  ani_mutex_unlock(&index->lock);
+
+  return count;
+}
+
+static const index_record *find_record(const ani_index *index,
+                                       const char *key, uint64_t hash,
+                                       uint8_t media_type) {
+  uint32_t lo;
+  uint32_t hi;
+  uint32_t mid;
+  const index_key *entry;
+  const char *stored;
+
+  lo = 0;
+  hi = index->key_count;
+  while (lo < hi) {
+    mid = lo + (hi - lo) / 2;
+    if (index->keys[mid].hash < hash) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  for (; lo < index->key_count && index->keys[lo].hash == hash; lo++) {
+    entry = &index->keys[lo];
+    stored = pool_str(index, entry->key);
+    if (stored == NULL || strcmp(stored, key) != 0 ||
+        entry->record >= index->record_count) {
+      continue;
+    }
+    if (index->records[entry->record].media_type == media_type) {
+      return &index->records[entry->record];
+    }
+  }
+
+  return NULL;
+}
+
+// --- trigram matching ---
+
+static int u32_cmp(const void *a, const void *b) {
+  uint32_t x = *(const uint32_t *)a;
+  uint32_t y = *(const uint32_t *)b;
+
+  return x < y ? -1 : x > y;
+}
+
+static int u64_cmp(const void *a, const void *b) {
+  uint64_t x = *(const uint64_t *)a;
+  uint64_t y = *(const uint64_t *)b;
+
+  return x < y ? -1 : x > y;
+}
+
+// Distinct byte trigrams of " key ", sorted; out holds GRAMS_MAX
+static size_t key_trigrams(const char *key, size_t len, uint32_t *out) {
+  size_t i;
+  size_t n;
+  size_t w;
+  uint32_t a;
+  uint32_t b;
+  uint32_t c;
+
+  if (len > GRAMS_MAX) {
+    len = GRAMS_MAX;
+  }
+
+  for (i = 0; i < len; i++) {
+    a = i > 0 ? (unsigned char)key[i - 1] : ' ';
+    b = (unsigned char)key[i];
+    c = i + 1 < len ? (unsigned char)key[i + 1] : ' ';
+    out[i] = a << 16 | b << 8 | c;
+  }
+  n = len;
+
+  qsort(out, n, sizeof(*out), u32_cmp);
+  for (i = 0, w = 0; i < n; i++) {
+    if (w == 0 || out[w - 1] != out[i]) {
+      out[w++] = out[i];
+    }
+  }
+
+  return w;
+}
+
+static size_t varint_put(unsigned char *p, uint32_t v) {
+  size_t n;
+
+  n = 0;
+  while (v >= 0x80) {
+    p[n++] = (unsigned char)(v | 0x80);
+    v >>= 7;
+  }
+  p[n++] = (unsigned char)v;
+
+  return n;
+}
+
+static uint32_t varint_get(const unsigned char **p) {
+  uint32_t v;
+  unsigned int shift;
+
+  v = 0;
+  shift = 0;
+  while (**p & 0x80) {
+    v |= (uint32_t)(**p & 0x7F) << shift;
+    shift += 7;
+    (*p)++;
+  }
+  v |= (uint32_t)**p << shift;
+  (*p)++;
+
+  return v;
+}
+
+// Invert the loaded keys into trigram -> key postings
+static bool grams_build(ani_index *index) {
+  uint32_t grams[GRAMS_MAX];
+  uint64_t *pairs;
+  const char *key;
+  size_t pair_count;
+  size_t used;
+  size_t n;
+  size_t i;
+  size_t j;
+  uint32_t k;
+  uint32_t prev;
+  uint32_t gram;
+  uint32_t record;
+
+  if (index->grams_built) {
+    return true;
+  }
+
+  pairs = NULL;
+  index->key_grams = ani_calloc((size_t)index->key_count + 1, 1);
+  index->record_keys =
+      ani_calloc((size_t)index->record_count + 1, sizeof(uint16_t));
+  index->hits = ani_calloc((size_t)index->key_count + 1, sizeof(uint16_t));
+  index->touched =
+      ani_malloc(((size_t)index->key_count + 1) * sizeof(uint32_t));
+  if (index->key_grams == NULL || index->record_keys == NULL ||
+      index->hits == NULL || index->touched == NULL) {
+    goto fail;
+  }
+
+  // Count first so the pair array is allocated once
+  pair_count = 0;
+  for (k = 0; k < index->key_count; k++) {
+    key = pool_str(index, index->keys[k].key);
+    record = index->keys[k].record;
+    if (key == NULL || record >= index->record_count) {
+      continue;
+    }
+    n = key_trigrams(key, strlen(key), grams);
+    index->key_grams[k] = (uint8_t)(n < UINT8_MAX ? n : UINT8_MAX);
+    if (index->record_keys[record] < UINT16_MAX) {
+      index->record_keys[record]++;
+    }
+    pair_count += n;
+  }
+
+  pairs = ani_malloc((pair_count + 1) * sizeof(*pairs));
+  index->postings = ani_malloc(pair_count * 5 + 1);
+  if (pairs == NULL || index->postings == NULL) {
+    goto fail;
+  }
+
+  pair_count = 0;
+  for (k = 0; k < index->key_count; k++) {
+    if (index->key_grams[k] == 0) {
+      continue;
+    }
+    key = pool_str(index, index->keys[k].key);
+    n = key_trigrams(key, strlen(key), grams);
+    for (i = 0; i < n; i++) {
+      pairs[pair_count++] = (uint64_t)grams[i] << 32 | k;
+    }
+  }
+  qsort(pairs, pair_count, sizeof(*pairs), u64_cmp);
+
+  n = 0;
+  for (i = 0; i < pair_count; i++) {
+    if (i == 0 || pairs[i] >> 32 != pairs[i - 1] >> 32) {
+      n++;
+    }
+  }
+  index->grams = ani_malloc((n + 1) * sizeof(uint32_t));
+  index->gram_offsets = ani_malloc((n + 1) * sizeof(uint32_t));
+  if (index->grams == NULL || index->gram_offsets == NULL) {
+    goto fail;
+  }
+
+  // Keys ascend within a trigram, so the gaps stay small
+  used = 0;
+  j = 0;
+  prev = 0;
+  for (i = 0; i < pair_count; i++) {
+    gram = (uint32_t)(pairs[i] >> 32);
+    k = (uint32_t)pairs[i];
+    if (i == 0 || gram != index->grams[j - 1]) {
+      index->grams[j] = gram;
+      index->gram_offsets[j] = (uint32_t)used;
+      j++;
+      prev = 0;
+    }
+    used += varint_put(index->postings + used, k - prev);
+    prev = k;
+  }
+  index->gram_offsets[j] = (uint32_t)used;
+  index->gram_count = (uint32_t)j;
+
+  ani_free(pairs);
+  index->grams_built = true;
+  LOG_DEBUG("Title trigrams built: %u grams, %zu posting bytes",
+            index->gram_count, used);
+
+  return true;
+
+fail:
+  ani_free(pairs);
+  grams_free(index);
+
+  return false;
+}
+
+static const unsigned char *gram_postings(const ani_index *index,
+                                          uint32_t gram,
+                                          const unsigned char **end) {
+  uint32_t lo;
+  uint32_t hi;
+  uint32_t mid;
+
+  lo = 0;
+  hi = index->gram_count;
+  while (lo < hi) {
+    mid = lo + (hi - lo) / 2;
+    if (index->grams[mid] < gram) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (lo == index->gram_count || index->grams[lo] != gram) {
+    return NULL;
+  }
+
+  *end = index->postings + index->gram_offsets[lo + 1];
+  return index->postings + index->gram_offsets[lo];
+}
+
+// Keep out sorted by score with one entry per series
+static void candidate_offer(fuzzy_candidate *out, size_t *count, size_t max,
+                            const fuzzy_candidate *c) {
+  size_t i;
+
+  for (i = 0; i < *count; i++) {
+    if (out[i].record == c->record) {
+      if (c->score <= out[i].score) {
+        return;
+      }
+      memmove(&out[i], &out[i + 1], (*count - i - 1) * sizeof(*out));
+      (*count)--;
+      break;
+    }
+  }
+
+  if (*count == max) {
+    if (c->score <= out[max - 1].score) {
+      return;
+    }
+    (*count)--;
+  }
+
+  i = *count;
+  while (i > 0 && out[i - 1].score < c->score) {
+    out[i] = out[i - 1];
+    i--;
+  }
+  out[i] = *c;
+  (*count)++;
+}
+
+// Rank series against a normalized query. complete adds the prefix and
+// popularity boosts used for suggestions; resolution ranks on similarity.
+static size_t fuzzy_rank(ani_index *index, const char *key, size_t len,
+                         unsigned int media_mask, bool complete,
+                         fuzzy_candidate *out, size_t max) {
+  uint32_t grams[GRAMS_MAX];
+  const unsigned char *p;
+  const unsigned char *end;
+  fuzzy_candidate c;
+  const char *stored;
+  size_t gram_total;
+  size_t touched;
+  size_t count;
+  size_t i;
+  uint32_t k;
+  uint32_t record;
+  uint16_t n;
+
+  if (max == 0 || index->key_count == 0 || !grams_build(index)) {
+    return 0;
+  }
+
+  gram_total = key_trigrams(key, len, grams);
+  touched = 0;
+  for (i = 0; i < gram_total; i++) {
+    p = gram_postings(index, grams[i], &end);
+    if (p == NULL) {
+      continue;
+    }
+
+    k = 0;
+    while (p < end) {
+      k += varint_get(&p);
+      if (index->hits[k]++ == 0) {
+        index->touched[touched++] = k;
+      }
+    }
+  }
+
+  count = 0;
+  for (i = 0; i < touched; i++) {
+    k = index->touched[i];
+    n = index->hits[k];
+    index->hits[k] = 0;
+
+    record = index->keys[k].record;
+    if ((double)n < FUZZY_MIN_COVERAGE * (double)gram_total ||
+        !(media_mask & (1u << index->records[record].media_type)) ||
+        pool_str(index, index->records[record].id) == NULL) {
+      continue;
+    }
+
+    c.record = record;
+    c.key = k;
+    c.similarity =
+        2.0 * (double)n / (double)(gram_total + index->key_grams[k]);
+    c.score = c.similarity;
+    if (complete) {
+      stored = pool_str(index, index->keys[k].key);
+      if (strncmp(stored, key, len) == 0) {
+        c.score += PREFIX_BOOST;
+      }
+      c.score += POPULARITY_BOOST * (double)(index->record_keys[record] - 1) /
+                 (double)(index->record_keys[record] + 3);
+    }
+    candidate_offer(out, &count, max, &c);
+  }
+
+  return count;
+}
+
+// Copy a record into series while the mapping is pinned by the lock
+static bool fill_series(const ani_index *index, const index_record *rec,
+                        ani_media_type media_type, ani_series *series) {
+  ani_instant start;
+
+  if (pool_str(index, rec->id) == NULL) {
+    return false;
+  }
+
+  series->id = ani_series_strdup(series, pool_str(index, rec->id));
+  ani_series_set_title(series, pool_str(index, rec->english),
+                       pool_str(index, rec->japanese),
+                       pool_str(index, rec->canonical));
+  series->media_type = media_type;
+  series->provider = media_type == ANI_MEDIA_ANIME ? "jikan" : "mangadex";
+  series->release.total_count = rec->total_count;
+  if (rec->flags & INDEX_HAS_START) {
+    start.epoch = rec->start_epoch;
+    start.offset_minutes = rec->start_offset;
+    start.has_time = (rec->flags & INDEX_HAS_TIME) != 0;
+    ani_instant_to_date(&start, &series->release.latest_date);
+  }
+
+  return series->id != NULL;
+}
+
+// Whether the space-separated token [tok, tok + len) is one of key's words
+static bool has_token(const char *key, const char *tok, size_t len) {
+  const char *p;
+
+  for (p = key; p != NULL; p = strchr(p, ' ')) {
+    if (*p == ' ') {
+      p++;
+    }
+    if (strncmp(p, tok, len) == 0 && (p[len] == ' ' || p[len] == '\0')) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// Tokens that pick out one season, part or sequel of a series
+static bool is_sequel_token(const char *tok, size_t len) {
+  static const char *const words[] = {"season", "part", "final", "ii",
+                                      "iii",    "iv",   "v",     "vi"};
+  size_t i;
+
+  for (i = 0; i < len; i++) {
+    if (tok[i] >= '0' && tok[i] <= '9') {
+      return true;
+    }
+  }
+  for (i = 0; i < sizeof(words) / sizeof(words[0]); i++) {
+    if (strlen(words[i]) == len && strncmp(tok, words[i], len) == 0) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// A near match may drop words but never the season or sequel number:
+// "one piece 2" is not "one piece"
+static bool sequel_tokens_match(const char *query, const char *key) {
+  const char *p;
+  size_t len;
+
+  if (key == NULL) {
+    return false;
+  }
+
+  for (p = query; *p != '\0'; p += len) {
+    while (*p == ' ') {
+      p++;
+    }
+    len = strcspn(p, " ");
+    if (len > 0 && is_sequel_token(p, len) && !has_token(key, p, len)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool ani_index_lookup(ani_index *index, const char *query,
+                      ani_media_type media_type, ani_series *series) {
+  char key[ANI_INDEX_KEY_MAX];
+  fuzzy_candidate best[2];
+  size_t len;
+  size_t count;
+  const index_record *rec;
+  const char *matched;
+  bool found;
+
+  if (index == NULL || query == NULL || series == NULL) {
+    return false;
+  }
+
+  len = ani_index_normalize(query, key, sizeof(key));
+  if (len == 0) {
+    return false;
+  }
+
+  ani_mutex_lock(&index->lock);
+  index_refresh(index);
+
+  rec = find_record(index, key, key_hash(key, len), (uint8_t)media_type);
+  if (rec == NULL) {
+    // A close match counts only when no other series comes near it
+    count = fuzzy_rank(index, key, len, 1u << media_type, false, best, 2);
+    if (count > 0 && best[0].similarity >= FUZZY_ACCEPT &&
+        (count == 1 || best[0].score - best[1].score >= FUZZY_MARGIN)) {
+      matched = pool_str(index, index->keys[best[0].key].key);
+      if (sequel_tokens_match(key, matched)) {
+        rec = &index->records[best[0].record];
+        LOG_DEBUG("Title index: '%s' matched '%s' (%.2f)", key, matched,
+                  best[0].similarity);
+      } else {
+        LOG_DEBUG("Title index: '%s' only resembles '%s', searching", key,
+                  matched);
+      }
+    }
+  }
+  found = rec != NULL && fill_series(index, rec, media_type, series);
+
+  ani_mutex_unlock(&index->lock);
+  return found;
+}
+
+// Title to show for a match: the one whose key matched, else the first set
+static const char *match_title(const ani_index *index,
+                               const fuzzy_candidate *c) {
+  char norm[ANI_INDEX_KEY_MAX];
+  const index_record *rec;
+  const char *titles[3];
+  const char *key;
+  size_t i;
+
+  rec = &index->records[c->record];
+  key = pool_str(index, index->keys[c->key].key);
+  titles[0] = pool_str(index, rec->english);
+  titles[1] = pool_str(index, rec->canonical);
+  titles[2] = pool_str(index, rec->japanese);
+
+  for (i = 0; i < 3; i++) {
+    if (titles[i] != NULL) {
+      ani_index_normalize(titles[i], norm, sizeof(norm));
+      if (strcmp(norm, key) == 0) {
+        return titles[i];
+      }
+    }
+  }
+
+  // Matched a past query: show the series' own title
+  for (i = 0; i < 3; i++) {
+    if (titles[i] != NULL) {
+      return titles[i];
+    }
+  }
+
+  return key;
+}
+
+size_t ani_index_suggest(ani_index *index, const char *query,
+                         unsigned int media_mask, ani_index_match *out,
+                         size_t max) {
+  char key[ANI_INDEX_KEY_MAX];
+  fuzzy_candidate *candidates;
+  const index_record *rec;
+  size_t len;
+  size_t count;
+  size_t i;
+
+  if (index == NULL || query == NULL || out == NULL || max == 0) {
+    return 0;
+  }
+
+  len = ani_index_normalize(query, key, sizeof(key));
+  if (len == 0) {
+    return 0;
+  }
+
+  candidates = ani_malloc(max * sizeof(*candidates));
+  if (candidates == NULL) {
+    return 0;
+  }
+
+  ani_mutex_lock(&index->lock);
+  index_refresh(index);
+
+  count = fuzzy_rank(index, key, len, media_mask, true, candidates, max);
+  for (i = 0; i < count; i++) {
+    rec = &index->records[candidates[i].record];
+    snprintf(out[i].id, sizeof(out[i].id), "%s", pool_str(index, rec->id));
+    snprintf(out[i].title, sizeof(out[i].title), "%s",
+             match_title(index, &candidates[i]));
+    out[i].media_type = (ani_media_type)rec->media_type;
+    out[i].similarity = candidates[i].similarity;
+    out[i].score = candidates[i].score;
+  }
+
+  ani_mutex_unlock(&index->lock);
+  ani_free(candidates);
+
+  return count;
+}
+
+static int build_key_cmp(const void *a, const void *b) {
+  const build_key *ka = a;
+  const build_key *kb = b;
+
+  if (ka->hash != kb->hash) {
+    return ka->hash < kb->hash ? -1 : 1;
+  }
+
+  return strcmp(ka->key, kb->key);
+}
+
+// Pool offset of s after appending it (0 for absent or empty strings)
+static uint32_t pool_put(char *pool, size_t *used, const char *s) {
+  size_t len;
+  uint32_t off;
+
+  if (s == NULL || s[0] == '\0') {
+    return 0;
+  }
+
+  len = strlen(s) + 1;
+  off = (uint32_t)*used;
+  memcpy(pool + *used, s, len);
+  *used += len;
+
+  return off;
+}
+
+static size_t pool_need(const char *s) {
+  return s != NULL && s[0] != '\0' ? strlen(s) + 1 : 0;
+}
+
+static bool index_write(ani_index *index, const build_record *records,
+                        uint32_t record_count, const build_key *keys,
+                        uint32_t key_count) {
+  index_header header;
+  index_record *out_records;
+  index_key *out_keys;
+  unsigned char *buf;
+  char *pool;
+  size_t pool_size;
+  size_t used;
+  size_t total;
+  uint32_t i;
+  bool ok;
+
+  pool_size = 1;
+  for (i = 0; i < record_count; i++) {
+    pool_size += pool_need(records[i].id) + pool_need(records[i].english) +
+                 pool_need(records[i].japanese) +
+                 pool_need(records[i].canonical);
+  }
+  for (i = 0; i < key_count; i++) {
+    pool_size += pool_need(keys[i].key);
+  }
+  if (pool_size > UINT32_MAX) {
+    LOG_WARN("Title index too large, not updated");
+
+    return false;
+  }
+
+  total = sizeof(header) + (size_t)record_count * sizeof(index_record) +
+          (size_t)key_count * sizeof(index_key) + pool_size;
+  buf = ani_calloc(1, total);
+  if (buf == NULL) {
+    return false;
+  }
+
+  memcpy(header.magic, INDEX_MAGIC, sizeof(header.magic));
+  header.version = INDEX_VERSION;
+  header.record_count = record_count;
+  header.key_count = key_count;
+  header.pool_size = (uint32_t)pool_size;
+  memcpy(buf, &header, sizeof(header));
+
+  out_records = (index_record *)(void *)(buf + sizeof(header));
+  out_keys = (index_key *)(void *)(out_records + record_count);
+  pool = (char *)(out_keys + key_count);
+
+  used = 1;
+  for (i = 0; i < record_count; i++) {
+    out_records[i] = records[i].rec;
+    out_records[i].id = pool_put(pool, &used, records[i].id);
+    out_records[i].english = pool_put(pool, &used, records[i].english);
+    out_records[i].japanese = pool_put(pool, &used, records[i].japanese);
+    out_records[i].canonical = pool_put(pool, &used, records[i].canonical);
+  }
+  for (i = 0; i < key_count; i++) {
+    out_keys[i].hash = keys[i].hash;
+    out_keys[i].key = pool_put(pool, &used, keys[i].key);
+    out_keys[i].record = keys[i].record;
+  }
+
+  ok = ani_write_file_atomic(index->path, buf, total);
+  ani_free(buf);
+  if (!ok) {
+    LOG_WARN("Failed to write title index: %s", index->path);
+  }
+
+  return ok;
+}
+
+bool ani_index_add(ani_index *index, const char *query,
+                   const ani_series *series) {
+  char norm[4][ANI_INDEX_KEY_MAX];
+  const char *sources[4];
+  build_record *records;
+  build_key *keys;
+  uint32_t record_count;
+  uint32_t key_count;
+  uint32_t slot;
+  uint32_t i;
+  uint32_t j;
+  uint32_t k;
+  uint8_t media_type;
+  size_t len;
+  ani_instant start;
+  bool ok;
+
+  if (index == NULL || series == NULL || series->id == NULL ||
+      series->id[0] == '\0') {
+    return false;
+  }
+
+  media_type = (uint8_t)series->media_type;
+  sources[0] = query;
+  sources[1] = series->title.english;
+  sources[2] = series->title.japanese;
+  sources[3] = series->title.canonical;
+
+  ani_mutex_lock(&index->lock);
+
+  // Start from whatever is on disk now, including other processes' updates
+  index_refresh(index);
+
+  records = ani_malloc(((size_t)index->record_count + 1) * sizeof(*records));
+  keys = ani_malloc(((size_t)index->key_count + 4) * sizeof(*keys));
+  if (records == NULL || keys == NULL) {
+    ani_free(records);
+    ani_free(keys);
+    ani_mutex_unlock(&index->lock);
+
+    return false;
+  }
+
+  record_count = index->record_count;
+  for (i = 0; i < record_count; i++) {
+    records[i].rec = index->records[i];
+    records[i].id = pool_str(index, index->records[i].id);
+    records[i].english = pool_str(index, index->records[i].english);
+    records[i].japanese = pool_str(index, index->records[i].japanese);
+    records[i].canonical = pool_str(index, index->records[i].canonical);
+  }
+
+  key_count = 0;
+  for (i = 0; i < index->key_count; i++) {
+    keys[key_count].hash = index->keys[i].hash;
+    keys[key_count].key = pool_str(index, index->keys[i].key);
+    keys[key_count].record = index->keys[i].record;
+    if (keys[key_count].key != NULL && keys[key_count].record < record_count) {
+      key_count++;
+    }
+  }
+
+  // Same series refreshes its record; a new one appends or evicts the
+  // least recently refreshed
+  slot = record_count;
+  for (i = 0; i < record_count; i++) {
+    if (records[i].rec.media_type == media_type && records[i].id != NULL &&
+        strcmp(records[i].id, series->id) == 0) {
+      slot = i;
+      break;
+    }
+  }
+  if (slot == record_count && record_count >= INDEX_MAX_RECORDS) {
+    slot = 0;
+    for (i = 1; i < record_count; i++) {
+      if (records[i].rec.updated < records[slot].rec.updated) {
+        slot = i;
+      }
+    }
+    for (i = 0, j = 0; i < key_count; i++) {
+      if (keys[i].record != slot) {
+        keys[j++] = keys[i];
+      }
+    }
+    key_count = j;
+  }
+  if (slot == record_count) {
+    record_count++;
+  }
+
+  memset(&records[slot].rec, 0, sizeof(records[slot].rec));
+  records[slot].rec.media_type = media_type;
+  records[slot].rec.updated = (int64_t)time(NULL);
+  records[slot].rec.total_count = series->release.total_count;
+  if (series->release.latest_date.year > 0 &&
+      ani_date_to_instant(&series->release.latest_date, &start)) {
+    records[slot].rec.start_epoch = start.epoch;
+    records[slot].rec.start_offset = start.offset_minutes;
+    records[slot].rec.flags = INDEX_HAS_START;
+    if (start.has_time) {
+      records[slot].rec.flags |= INDEX_HAS_TIME;
+    }
+  }
+  records[slot].id = series->id;
+  records[slot].english = series->title.english;
+  records[slot].japanese = series->title.japanese;
+  records[slot].canonical = series->title.canonical;
+
+  // Point the query and every title at the record
+  for (i = 0; i < 4; i++) {
+    len = ani_index_normalize(sources[i], norm[i], sizeof(norm[i]));
+    if (len == 0) {
+      continue;
+    }
+
+    for (j = 0; j < i; j++) {
+      if (strcmp(norm[j], norm[i]) == 0) {
+        break;
+      }
+    }
+    if (j < i) {
+      continue;
+    }
+
+    keys[key_count].hash = key_hash(norm[i], len);
+    keys[key_count].key = norm[i];
+    keys[key_count].record = slot;
+    for (k = 0; k < key_count; k++) {
+      if (keys[k].hash == keys[key_count].hash &&
+          records[keys[k].record].rec.media_type == media_type &&
+          strcmp(keys[k].key, norm[i]) == 0) {
+        keys[k].record = slot;
+        break;
+      }
+    }
+    if (k == key_count) {
+      key_count++;
+    }
+  }
+
+  qsort(keys, key_count, sizeof(*keys), build_key_cmp);
+  ok = index_write(index, records, record_count, keys, key_count);
+
+  ani_free(records);
+  ani_free(keys);
+
+  // Old strings were referenced until the write; now pick up the new file
+  if (ok) {
+    index_load(index);
+  }
+
+  ani_mutex_unlock(&index->lock);
+  return ok;
+}
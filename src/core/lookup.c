@@ -0,0 +1,1146 @@
+/*
+ * Routine: ani — Anime/Manga scheduling information CLI
+ * Author: DannyBimma
+ * Copyright: (c) 2025 Technomancer Pirate Captain. All Rights Reserved.
+ */
+
+#include "ani/alloc.h"
+#include "ani/ani.h"
+#include "ani/breaker.h"
+#include "ani/broadcast.h"
+#include "ani/cache.h"
+#include "ani/cadence.h"
+#include "ani/calendar.h"
+#include "ani/ctx.h"
+#include "ani/http.h"
+#include "ani/index.h"
+#include "ani/limiter.h"
+#include "ani/log.h"
+#include "ani/metrics.h"
+#include "ani/providers/anilist.h"
+#include "ani/providers/jikan.h"
+#include "ani/providers/mangadex.h"
+#include "ani/str.h"
+#include "ani/thread.h"
+#include "ani/time.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Live contexts; the first one brings up libcurl and the last one tears it
+// down (both are process-global in libcurl, hence single-threaded here)
+static unsigned int live_contexts = 0;
+
+// Latencies needed before the quantile replaces the fixed hedge budget
+#define HEDGE_MIN_SAMPLES 20
+
+// Copy a heap series filled on another thread into series
+static bool series_adopt(ani_series *series, const ani_series *src) {
+  series->id = ani_series_strdup(series, src->id);
+  ani_series_set_title(series, src->title.english, src->title.japanese,
+                       src->title.canonical);
+  series->media_type = src->media_type;
+  series->release = src->release;
+  series->provider = src->provider;
+
+  return series->id != NULL;
+}
+
+// A title search that can run on its own thread
+typedef bool (*search_fn)(ani_ctx *ctx, const char *query,
+                          ani_series *series);
+
+static bool search_anilist(ani_ctx *ctx, const char *query,
+                           ani_series *series) {
+  return ani_anilist_search_anime(ctx, query, series, NULL, 0);
+}
+
+// One side of a hedged race
+typedef struct {
+  ani_thread thread;
+  struct ani_hedge *race;
+  search_fn search;
+  const char *provider;
+  ani_series *series; // Heap series: the result arena is not thread-safe
+  bool started;
+  bool cancel; // Set once the race is decided (ani_http_bind_cancel)
+  bool done;   // Guarded by the race lock, like found
+  bool found;
+} hedge_side;
+
+// A primary search and its backup. Freed once both threads are joined,
+// which for a lost race may be after the lookup has returned.
+typedef struct ani_hedge {
+  ani_ctx *ctx;
+  char *query;
+  ani_mutex lock;
+  ani_cond cond;
+  hedge_side sides[2];
+  struct ani_hedge *next; // In ctx->stragglers
+} ani_hedge;
+
+static void hedge_side_main(void *arg) {
+  hedge_side *side = arg;
+  ani_hedge *race = side->race;
+  const ani_logger *prev_logger;
+  const bool *prev_cancel;
+  bool found;
+
+  prev_logger = ani_log_bind(&race->ctx->logger);
+  prev_cancel = ani_http_bind_cancel(&side->cancel);
+  found = side->search(race->ctx, race->query, side->series);
+  ani_http_bind_cancel(prev_cancel);
+  ani_log_bind(prev_logger);
+
+  ani_mutex_lock(&race->lock);
+  side->found = found;
+  side->done = true;
+  ani_cond_broadcast(&race->cond);
+  ani_mutex_unlock(&race->lock);
+}
+
+static bool hedge_side_start(ani_hedge *race, int i) {
+  hedge_side *side = &race->sides[i];
+
+  side->series = ani_series_new();
+  side->started = side->series != NULL &&
+                  ani_thread_start(&side->thread, hedge_side_main, side);
+
+  return side->started;
+}
+
+// Whether every started side has finished
+static bool hedge_settled(ani_hedge *race) {
+  bool settled;
+  int i;
+
+  settled = true;
+  ani_mutex_lock(&race->lock);
+  for (i = 0; i < 2; i++) {
+    if (race->sides[i].started && !race->sides[i].done) {
+      settled = false;
+    }
+  }
+  ani_mutex_unlock(&race->lock);
+
+  return settled;
+}
+
+static void hedge_cancel(ani_hedge *race) {
+  int i;
+
+  for (i = 0; i < 2; i++) {
+#if defined(__GNUC__) || defined(__clang__)
+    __atomic_store_n(&race->sides[i].cancel, true, __ATOMIC_RELAXED);
+#else
+    race->sides[i].cancel = true;
+#endif
+  }
+}
+
+static void hedge_free(ani_hedge *race) {
+  int i;
+
+  for (i = 0; i < 2; i++) {
+    if (race->sides[i].started) {
+      ani_thread_join(&race->sides[i].thread);
+    }
+    ani_series_free(race->sides[i].series);
+  }
+
+  ani_cond_destroy(&race->cond);
+  ani_mutex_destroy(&race->lock);
+  ani_free(race->query);
+  ani_free(race);
+}
+
+// Join and free lost races that have wound down (all: every one, waiting)
+static void hedge_reap(ani_ctx *ctx, bool all) {
+  ani_hedge **link;
+  ani_hedge *race;
+  ani_hedge *finished;
+
+  finished = NULL;
+  ani_mutex_lock(&ctx->hedge_lock);
+  link = &ctx->stragglers;
+  while ((race = *link) != NULL) {
+    if (all || hedge_settled(race)) {
+      *link = race->next;
+      race->next = finished;
+      finished = race;
+    } else {
+      link = &race->next;
+    }
+  }
+  ani_mutex_unlock(&ctx->hedge_lock);
+
+  while (finished != NULL) {
+    race = finished;
+    finished = race->next;
+    hedge_free(race);
+  }
+}
+
+// How long the primary may take before the backup is sent: the configured
+// latency quantile of the provider once enough requests have been seen,
+// the fixed budget until then
+static long hedge_budget_ms(const ani_ctx *ctx, const char *provider) {
+  unsigned long samples;
+  double seconds;
+
+  if (ctx->hedge_quantile > 0.0) {
+    seconds =
+        ani_metrics_http_quantile(provider, ctx->hedge_quantile, &samples);
+    if (samples >= HEDGE_MIN_SAMPLES) {
+      return (long)(seconds * 1000.0);
+    }
+  }
+
+  return ctx->hedge_ms;
+}
+
+// Search with primary, and with backup as well once primary has been silent
+// for its hedge budget. The first side to find the series wins and is
+// copied into series; the other is cancelled and left to wind down in the
+// background. Returns the winning provider, NULL if neither found one.
+static const char *search_hedged(ani_ctx *ctx, const char *query,
+                                 search_fn primary,
+                                 const char *primary_provider,
+                                 search_fn backup, const char *backup_provider,
+                                 ani_series *series) {
+  ani_hedge *race;
+  hedge_side *winner;
+  const char *provider;
+  long budget_ms;
+  int64_t deadline_us;
+  int64_t left_us;
+  bool hedged;
+  bool pending;
+  int i;
+
+  hedge_reap(ctx, false);
+
+  race = ani_calloc(1, sizeof(*race));
+  if (race == NULL) {
+    return primary(ctx, query, series) ? primary_provider : NULL;
+  }
+
+  race->ctx = ctx;
+  race->query = ani_strdup(query);
+  ani_mutex_init(&race->lock);
+  ani_cond_init(&race->cond);
+  race->sides[0].race = race;
+  race->sides[0].search = primary;
+  race->sides[0].provider = primary_provider;
+  race->sides[1].race = race;
+  race->sides[1].search = backup;
+  race->sides[1].provider = backup_provider;
+
+  // Without a thread there is nothing to race
+  if (race->query == NULL || !hedge_side_start(race, 0)) {
+    hedge_free(race);
+
+    return primary(ctx, query, series) ? primary_provider : NULL;
+  }
+
+  budget_ms = hedge_budget_ms(ctx, primary_provider);
+  deadline_us = ani_monotonic_us() + (int64_t)budget_ms * 1000;
+  ani_mutex_lock(&race->lock);
+  while (!race->sides[0].done &&
+         (left_us = deadline_us - ani_monotonic_us()) > 0) {
+    ani_cond_wait_ms(&race->cond, &race->lock, (long)((left_us + 999) / 1000));
+  }
+  hedged = !race->sides[0].done;
+  ani_mutex_unlock(&race->lock);
+
+  if (hedged) {
+    LOG_INFO("No answer from %s within the hedge budget, asking %s",
+             primary_provider, backup_provider);
+    ani_metrics_hedge_fired(primary_provider);
+    hedge_side_start(race, 1);
+  }
+
+  // The first side to find the series wins
+  winner = NULL;
+  ani_mutex_lock(&race->lock);
+  for (;;) {
+    pending = false;
+    for (i = 0; i < 2 && winner == NULL; i++) {
+      if (race->sides[i].done && race->sides[i].found) {
+        winner = &race->sides[i];
+      } else if (race->sides[i].started && !race->sides[i].done) {
+        pending = true;
+      }
+    }
+    if (winner != NULL || !pending) {
+      break;
+    }
+    ani_cond_wait_ms(&race->cond, &race->lock, -1);
+  }
+  ani_mutex_unlock(&race->lock);
+
+  provider = NULL;
+  if (winner != NULL && series_adopt(series, winner->series)) {
+    provider = winner->provider;
+    if (hedged) {
+      ani_metrics_hedge_won(provider);
+    }
+  }
+
+  hedge_cancel(race);
+  if (hedge_settled(race)) {
+    hedge_free(race);
+  } else {
+    ani_mutex_lock(&ctx->hedge_lock);
+    race->next = ctx->stragglers;
+    ctx->stragglers = race;
+    ani_mutex_unlock(&ctx->hedge_lock);
+  }
+
+  return provider;
+}
+
+void ani_ctx_options_init(ani_ctx_options *options) {
+  if (options == NULL) {
+    return;
+  }
+
+  options->timeout_ms = 0;
+  options->connect_timeout_ms = 0;
+  options->max_retries = -1;
+  options->cache_dir = NULL;
+  options->rate_limit = true;
+  options->title_index = true;
+  options->circuit_breaker = true;
+  options->hedge_ms = 0;
+  options->hedge_quantile = 0.95;
+  options->estimates = true;
+  options->deadline_ms = 0;
+  options->log_level = ani_log_current_level;
+  options->log_fn = NULL;
+  options->log_userdata = NULL;
+}
+
+ani_ctx *ani_ctx_new(const ani_ctx_options *options) {
+  ani_ctx_options defaults;
+  ani_ctx *ctx;
+  const ani_logger *prev;
+
+  if (options == NULL) {
+    ani_ctx_options_init(&defaults);
+    options = &defaults;
+  }
+
+  ctx = ani_calloc(1, sizeof(*ctx));
+  if (ctx == NULL) {
+    return NULL;
+  }
+
+  if (live_contexts++ == 0) {
+    ani_http_init();
+  }
+
+  ctx->logger.level = options->log_level;
+  ctx->logger.fn = options->log_fn;
+  ctx->logger.userdata = options->log_userdata;
+  prev = ani_log_bind(&ctx->logger);
+
+  ctx->http = ani_http_default_config();
+  if (options->timeout_ms > 0) {
+    ctx->http.timeout_ms = options->timeout_ms;
+  }
+  if (options->connect_timeout_ms > 0) {
+    ctx->http.connect_timeout_ms = options->connect_timeout_ms;
+  }
+  if (options->max_retries >= 0) {
+    ctx->http.max_retries = options->max_retries;
+  }
+
+  ctx->pool = ani_http_client_new();
+  if (ctx->pool == NULL) {
+    LOG_WARN("Failed to create HTTP connection pool");
+  }
+  ctx->http.client = ctx->pool;
+
+  if (options->rate_limit) {
+    ctx->limiter = ani_limiter_new();
+  }
+  ctx->http.limiter = ctx->limiter;
+
+  ctx->hedge_ms = options->hedge_ms;
+  ctx->hedge_quantile = options->hedge_quantile;
+  ctx->estimates = options->estimates;
+  ctx->deadline_ms = options->deadline_ms;
+  ani_mutex_init(&ctx->calendar_lock);
+  ani_mutex_init(&ctx->hedge_lock);
+
+  // Lookups still work without a cache
+  ctx->cache = ani_cache_open(options->cache_dir);
+
+  // Its state lives next to the cache so every process shares it
+  if (options->circuit_breaker) {
+    ctx->breaker = ani_breaker_new(ani_cache_dir(ctx->cache));
+  }
+  ctx->http.breaker = ctx->breaker;
+  if (ctx->cache != NULL && options->title_index) {
+    ctx->index = ani_index_open(ani_cache_dir(ctx->cache));
+  }
+
+  ani_log_bind(prev);
+  return ctx;
+}
+
+void ani_ctx_drain(ani_ctx *ctx) {
+  if (ctx != NULL) {
+    hedge_reap(ctx, true);
+  }
+}
+
+void ani_ctx_free(ani_ctx *ctx) {
+  if (ctx == NULL) {
+    return;
+  }
+
+  LOG_DEBUG("Freeing context after %lu lookups", ctx->lookups);
+  hedge_reap(ctx, true);
+  ani_mutex_destroy(&ctx->hedge_lock);
+  ani_mutex_destroy(&ctx->calendar_lock);
+  ani_calendar_free(ctx->calendar);
+  ani_breaker_free(ctx->breaker);
+  ani_index_close(ctx->index);
+  ani_cache_close(ctx->cache);
+  ani_limiter_free(ctx->limiter);
+  ani_http_client_free(ctx->pool);
+  ani_free(ctx);
+
+  if (--live_contexts == 0) {
+    ani_http_cleanup();
+  }
+}
+
+ani_http_config ani_ctx_http_config(const ani_ctx *ctx, const char *provider) {
+  ani_http_config config;
+
+  config = ctx != NULL ? ctx->http : ani_http_default_config();
+  config.provider = provider;
+
+  return config;
+}
+
+// Resolve query from the title index unless refreshing
+static bool resolve_local(ani_ctx *ctx, const char *query,
+                          ani_media_type media_type, unsigned int flags,
+                          ani_series *series) {
+  if (ctx->index == NULL || (flags & ANI_LOOKUP_REFRESH)) {
+    return false;
+  }
+
+  if (!ani_index_lookup(ctx->index, query, media_type, series)) {
+    return false;
+  }
+
+  LOG_INFO("Resolved from title index: %s", series->id);
+  return true;
+}
+
+// The context's airing snapshot, read from the cache on first use; call
+// with calendar_lock held
+static ani_calendar *calendar_locked(ani_ctx *ctx) {
+  if (!ctx->calendar_loaded) {
+    ctx->calendar = ani_calendar_load(ctx->cache);
+    ctx->calendar_loaded = true;
+  }
+
+  return ctx->calendar;
+}
+
+// Next episode of series from the synced airing calendar, if it has one
+static bool calendar_schedule(ani_ctx *ctx, ani_series *series) {
+  ani_calendar *calendar;
+  int64_t now;
+  bool found;
+
+  now = (int64_t)time(NULL);
+  ani_mutex_lock(&ctx->calendar_lock);
+  calendar = calendar_locked(ctx);
+  found = calendar != NULL && now < calendar->to &&
+          ani_calendar_fill(calendar, series->id, now, &series->release);
+  ani_mutex_unlock(&ctx->calendar_lock);
+
+  return found;
+}
+
+// Next episode from the airing calendar (unless refreshing) or AniList, or
+// from the broadcast slot when AniList is down, the lookup is past its
+// deadline or the slot was asked for
+static void anime_schedule(ani_ctx *ctx, ani_series *series,
+                           unsigned int flags, int64_t start_us) {
+  bool local;
+
+  local = (flags & ANI_LOOKUP_BROADCAST) != 0;
+  if (!local && (flags & ANI_LOOKUP_REFRESH) == 0 &&
+      calendar_schedule(ctx, series)) {
+    return;
+  }
+  if (!local && ani_breaker_is_open(ctx->breaker, "anilist")) {
+    LOG_INFO("AniList is down, estimating from the broadcast slot");
+    local = true;
+  }
+  if (!local && ctx->deadline_ms > 0 &&
+      ani_monotonic_us() - start_us > (int64_t)ctx->deadline_ms * 1000) {
+    LOG_INFO("Past the %ld ms deadline, estimating from the broadcast slot",
+             ctx->deadline_ms);
+    local = true;
+  }
+
+  if (!local) {
+    ani_anilist_get_next_episode(ctx, series->id, series);
+  }
+
+  // Also covers an AniList request that failed
+  if (ctx->estimates && series->release.provider_name == NULL) {
+    ani_broadcast_estimate(time(NULL), &series->release);
+  }
+}
+
+// AniList title search run beside the Jikan one (ANI_LOOKUP_PARALLEL)
+typedef struct {
+  ani_ctx *ctx;
+  const char *query;
+  ani_series *series; // Heap series: the result arena is not thread-safe
+  char mal_id[32];
+  bool found;
+} anilist_search;
+
+static void anilist_search_main(void *arg) {
+  anilist_search *search = arg;
+  const ani_logger *prev;
+
+  prev = ani_log_bind(&search->ctx->logger);
+  search->found =
+      ani_anilist_search_anime(search->ctx, search->query, search->series,
+                               search->mal_id, sizeof(search->mal_id));
+  ani_log_bind(prev);
+}
+
+// Copy the schedule AniList found for the same series
+static void take_schedule(ani_series *series, const ani_series *src) {
+  if (src->release.latest_number > 0) {
+    series->release.latest_number = src->release.latest_number;
+    series->release.latest_date = src->release.latest_date;
+  }
+
+  if (src->release.provider_name != NULL) {
+    series->release.next_date = src->release.next_date;
+    series->release.next_number = src->release.next_number;
+    series->release.next_source = src->release.next_source;
+    series->release.next_confidence = src->release.next_confidence;
+    series->release.provider_name = src->release.provider_name;
+  }
+}
+
+// Jikan and AniList searched at once and reconciled on the MAL ID: the
+// Jikan match keeps its details and takes AniList's schedule. When the two
+// disagree the schedule is looked up by MAL ID as in a serial lookup; when
+// Jikan finds nothing the AniList match stands in. Returns whether series
+// was filled.
+static bool search_anime_parallel(ani_ctx *ctx, const char *query,
+                                  unsigned int flags, int64_t start_us,
+                                  ani_series *series) {
+  anilist_search search;
+  ani_thread thread;
+  bool threaded;
+  bool found;
+
+  memset(&search, 0, sizeof(search));
+  search.ctx = ctx;
+  search.query = query;
+  search.series = ani_series_new();
+  threaded = search.series != NULL &&
+             ani_thread_start(&thread, anilist_search_main, &search);
+
+  found = ani_jikan_search_anime(ctx, query, series);
+  if (threaded) {
+    ani_thread_join(&thread);
+  }
+
+  if (found) {
+    ani_index_add(ctx->index, query, series);
+
+    if (search.found && strcmp(search.mal_id, series->id) == 0) {
+      take_schedule(series, search.series);
+    } else {
+      LOG_DEBUG("AniList matched MAL ID '%s', Jikan %s", search.mal_id,
+                series->id);
+      anime_schedule(ctx, series, flags, start_us);
+    }
+  } else if (search.found) {
+    LOG_INFO("Using the AniList match (AniList ID: %s)", search.series->id);
+    found = series_adopt(series, search.series);
+  }
+
+  ani_series_free(search.series);
+  return found;
+}
+
+static ani_series *lookup_anime(ani_ctx *ctx, ani_arena *arena,
+                                const char *query, unsigned int flags,
+                                int64_t start_us) {
+  ani_series *series;
+  const char *provider;
+
+  series = ani_series_new_in(arena);
+  if (series == NULL) {
+    return NULL;
+  }
+
+  if (!resolve_local(ctx, query, ANI_MEDIA_ANIME, flags, series)) {
+    LOG_INFO("Searching for anime: %s", query);
+
+    // The schedule arrives with the AniList search
+    if ((flags & ANI_LOOKUP_PARALLEL) &&
+        !(flags & ANI_LOOKUP_DEFER_SCHEDULE)) {
+      if (!search_anime_parallel(ctx, query, flags, start_us, series)) {
+        LOG_WARN("Anime search failed or no results");
+        ani_series_free(series);
+
+        return NULL;
+      }
+
+      // AniList may have missed; Jikan brought the broadcast slot
+      if (ctx->estimates && series->release.provider_name == NULL) {
+        ani_broadcast_estimate(time(NULL), &series->release);
+      }
+
+      return series;
+    }
+
+    if (ctx->hedge_ms > 0) {
+      provider = search_hedged(ctx, query, ani_jikan_search_anime, "jikan",
+                               search_anilist, "anilist", series);
+    } else {
+      provider = ani_jikan_search_anime(ctx, query, series) ? "jikan" : NULL;
+    }
+    if (provider == NULL) {
+      LOG_WARN("Anime search failed or no results");
+      ani_series_free(series);
+
+      return NULL;
+    }
+
+    // An AniList answer brings its schedule and has no MAL ID to index
+    if (strcmp(provider, "anilist") == 0) {
+      return series;
+    }
+
+    ani_index_add(ctx->index, query, series);
+  }
+
+  // Get next episode schedule (a local estimate is never deferred)
+  if (series->id != NULL && (!(flags & ANI_LOOKUP_DEFER_SCHEDULE) ||
+                             (flags & ANI_LOOKUP_BROADCAST))) {
+    anime_schedule(ctx, series, flags, start_us);
+  }
+
+  return series;
+}
+
+// Estimate the next chapter from the series' chapter history in the cache,
+// adding the latest chapter to it. With seed, a new history is backfilled
+// from MangaDex once; after that it grows chapter by chapter.
+static void manga_estimate(ani_ctx *ctx, ani_series *series, bool seed) {
+  ani_cadence history;
+  ani_instant latest;
+  bool changed;
+
+  if (!ctx->estimates || ctx->cache == NULL || series->id == NULL) {
+    return;
+  }
+
+  ani_cadence_load(ctx->cache, "mangadex", series->id, &history);
+  changed = series->release.latest_number > 0 &&
+            ani_date_to_instant(&series->release.latest_date, &latest) &&
+            ani_cadence_add(&history, series->release.latest_number,
+                            latest.epoch);
+
+  if (seed && !history.seeded && !ani_cadence_ready(&history) &&
+      ani_mangadex_get_chapter_history(ctx, series->id, &history)) {
+    history.seeded = true;
+    changed = true;
+  }
+  if (changed && !ani_cadence_save(ctx->cache, "mangadex", series->id,
+                                   &history)) {
+    LOG_WARN("Failed to save chapter history for %s", series->id);
+  }
+
+  ani_cadence_estimate(&history, time(NULL), &series->release);
+}
+
+// Latest chapter, the chapter count while the series runs, and the next
+// chapter's estimate
+static void manga_chapters(ani_ctx *ctx, ani_series *series, bool refresh) {
+  ani_mangadex_get_latest_chapter(ctx, series->id, series);
+  if (series->release.total_count < 0) {
+    ani_mangadex_get_chapter_count(ctx, series->id, refresh, series);
+  }
+  manga_estimate(ctx, series, true);
+}
+
+static ani_series *lookup_manga(ani_ctx *ctx, ani_arena *arena,
+                                const char *query, unsigned int flags) {
+  ani_series *series;
+  bool found;
+
+  series = ani_series_new_in(arena);
+  if (series == NULL) {
+    return NULL;
+  }
+
+  if (!resolve_local(ctx, query, ANI_MEDIA_MANGA, flags, series)) {
+    LOG_INFO("Searching for manga: %s", query);
+
+    // The hedge for a slow MangaDex search is a second one
+    if (ctx->hedge_ms > 0) {
+      found = search_hedged(ctx, query, ani_mangadex_search_manga,
+                            "mangadex", ani_mangadex_search_manga, "mangadex",
+                            series) != NULL;
+    } else {
+      found = ani_mangadex_search_manga(ctx, query, series);
+    }
+    if (!found) {
+      LOG_WARN("Manga search failed or no results");
+      ani_series_free(series);
+
+      return NULL;
+    }
+
+    ani_index_add(ctx->index, query, series);
+  }
+
+  // Get latest chapter info
+  if (series->id != NULL && !(flags & ANI_LOOKUP_DEFER_SCHEDULE)) {
+    manga_chapters(ctx, series, (flags & ANI_LOOKUP_REFRESH) != 0);
+  }
+
+  return series;
+}
+
+// Empty result carrying query, in its own arena with ANI_LOOKUP_ARENA
+static ani_result *result_begin(const char *query, unsigned int flags) {
+  ani_result *result;
+
+  if (flags & ANI_LOOKUP_ARENA) {
+    result = ani_result_new_arena(NULL);
+  } else {
+    result = ani_result_new();
+  }
+  if (result == NULL) {
+    return NULL;
+  }
+
+  result->query = result->arena != NULL
+                      ? ani_arena_strdup(result->arena, query)
+                      : ani_strdup(query);
+  if (result->query == NULL) {
+    ani_result_free(result);
+
+    return NULL;
+  }
+
+  return result;
+}
+
+static void lookup_done(ani_ctx *ctx, int64_t start_us) {
+  ani_metrics_observe_query((double)(ani_monotonic_us() - start_us) / 1e6);
+
+#if defined(__GNUC__) || defined(__clang__)
+  __atomic_fetch_add(&ctx->lookups, 1, __ATOMIC_RELAXED);
+#else
+  ctx->lookups++;
+#endif
+}
+
+bool ani_lookup(ani_ctx *ctx, const char *query, unsigned int flags,
+                ani_result **result_out) {
+  ani_result *result;
+  const ani_logger *prev;
+  int64_t start_us;
+
+  if (result_out != NULL) {
+    *result_out = NULL;
+  }
+  if (ctx == NULL || query == NULL || result_out == NULL) {
+    return false;
+  }
+
+  if ((flags & ANI_LOOKUP_ALL) == 0) {
+    flags |= ANI_LOOKUP_ALL;
+  }
+
+  result = result_begin(query, flags);
+  if (result == NULL) {
+    return false;
+  }
+
+  // Everything logged below goes through this context's logger
+  prev = ani_log_bind(&ctx->logger);
+
+  start_us = ani_monotonic_us();
+  if (flags & ANI_LOOKUP_ANIME) {
+    result->anime = lookup_anime(ctx, result->arena, query, flags, start_us);
+    result->has_anime = result->anime != NULL;
+  }
+  if (flags & ANI_LOOKUP_MANGA) {
+    result->manga = lookup_manga(ctx, result->arena, query, flags);
+    result->has_manga = result->manga != NULL;
+  }
+  lookup_done(ctx, start_us);
+
+  ani_log_bind(prev);
+
+  *result_out = result;
+  return true;
+}
+
+// MAL and AniList IDs are decimal, MangaDex IDs are lowercase UUIDs
+static bool id_valid(ani_id_type type, const char *id) {
+  return type == ANI_ID_MANGADEX ? ani_str_is_uuid(id)
+                                 : ani_str_is_decimal_id(id);
+}
+
+static ani_series *lookup_by_id(ani_ctx *ctx, ani_arena *arena,
+                                ani_id_type type, const char *id,
+                                unsigned int flags, int64_t start_us) {
+  ani_series *series;
+  bool refresh;
+  bool found;
+
+  series = ani_series_new_in(arena);
+  if (series == NULL) {
+    return NULL;
+  }
+
+  refresh = (flags & ANI_LOOKUP_REFRESH) != 0;
+  switch (type) {
+  case ANI_ID_MAL:
+    found = ani_jikan_get_anime(ctx, id, refresh, series);
+    if (found && (!(flags & ANI_LOOKUP_DEFER_SCHEDULE) ||
+                  (flags & ANI_LOOKUP_BROADCAST))) {
+      anime_schedule(ctx, series, flags, start_us);
+    }
+    break;
+  case ANI_ID_ANILIST:
+    // One request brings details and schedule
+    found = ani_anilist_get_anime(ctx, id, refresh, series);
+    break;
+  case ANI_ID_MANGADEX:
+    found = ani_mangadex_get_manga(ctx, id, refresh, series);
+    if (found && !(flags & ANI_LOOKUP_DEFER_SCHEDULE)) {
+      manga_chapters(ctx, series, refresh);
+    }
+    break;
+  default:
+    found = false;
+    break;
+  }
+
+  if (!found) {
+    LOG_WARN("No series found for ID %s", id);
+    ani_series_free(series);
+
+    return NULL;
+  }
+
+  // Titles learned here resolve later title queries too (the index holds
+  // MAL IDs, so AniList IDs stay out)
+  if (type != ANI_ID_ANILIST) {
+    ani_index_add(ctx->index, NULL, series);
+  }
+
+  return series;
+}
+
+bool ani_lookup_id(ani_ctx *ctx, ani_id_type type, const char *id,
+                   unsigned int flags, ani_result **result_out) {
+  static const char *const prefixes[] = {"mal", "anilist", "mangadex"};
+  char query[64];
+  ani_result *result;
+  ani_series *series;
+  const ani_logger *prev;
+  int64_t start_us;
+
+  if (result_out != NULL) {
+    *result_out = NULL;
+  }
+  if (ctx == NULL || id == NULL || result_out == NULL ||
+      (unsigned int)type > ANI_ID_MANGADEX) {
+    return false;
+  }
+
+  prev = ani_log_bind(&ctx->logger);
+  if (!id_valid(type, id)) {
+    LOG_ERROR("Malformed %s ID: %s", prefixes[type], id);
+    ani_log_bind(prev);
+
+    return false;
+  }
+
+  snprintf(query, sizeof(query), "%s:%s", prefixes[type], id);
+  result = result_begin(query, flags);
+  if (result == NULL) {
+    ani_log_bind(prev);
+
+    return false;
+  }
+
+  start_us = ani_monotonic_us();
+  series = lookup_by_id(ctx, result->arena, type, id, flags, start_us);
+  if (type == ANI_ID_MANGADEX) {
+    result->manga = series;
+    result->has_manga = series != NULL;
+  } else {
+    result->anime = series;
+    result->has_anime = series != NULL;
+  }
+  lookup_done(ctx, start_us);
+
+  ani_log_bind(prev);
+
+  *result_out = result;
+  return true;
+}
+
+char *ani_ctx_fetch(ani_ctx *ctx, const char *provider, const char *url,
+                    const char *post_body, const char *cache_key,
+                    time_t max_age, size_t *len_out) {
+  ani_http_config config;
+  ani_http_response *resp;
+  char *body;
+  bool stale;
+
+  if (ctx == NULL || url == NULL) {
+    return NULL;
+  }
+
+  // While the provider is down an old entry beats no answer
+  stale = ani_breaker_is_open(ctx->breaker, provider);
+  if (ctx->cache != NULL && cache_key != NULL && (max_age > 0 || stale)) {
+    body = ani_cache_get(ctx->cache, provider, cache_key,
+                         stale ? ANI_CACHE_TTL_STALE : max_age);
+    if (body != NULL) {
+      if (stale) {
+        LOG_WARN("%s is unavailable, using cached %s", provider, cache_key);
+      }
+      if (len_out != NULL) {
+        *len_out = strlen(body);
+      }
+
+      return body;
+    }
+  }
+
+  config = ani_ctx_http_config(ctx, provider);
+  if (post_body != NULL) {
+    resp = ani_http_post(url, post_body, "application/json", &config);
+  } else {
+    resp = ani_http_get(url, &config);
+  }
+  if (resp == NULL || resp->status_code != 200 || resp->body == NULL) {
+    LOG_WARN("%s request failed: HTTP %ld", provider != NULL ? provider : "",
+             resp ? resp->status_code : 0);
+    ani_http_response_free(resp);
+
+    return NULL;
+  }
+
+  // Keep the body, drop the rest of the response
+  body = resp->body;
+  if (len_out != NULL) {
+    *len_out = resp->body_len;
+  }
+  resp->body = NULL;
+  ani_http_response_free(resp);
+
+  if (ctx->cache != NULL && cache_key != NULL) {
+    ani_cache_set(ctx->cache, provider, cache_key, body);
+  }
+
+  return body;
+}
+
+// Anime still waiting for their schedule: searched or looked up by MAL ID
+static bool schedule_pending(const ani_series *series) {
+  return series != NULL && series->id != NULL &&
+         series->media_type == ANI_MEDIA_ANIME &&
+         series->release.provider_name == NULL && series->provider != NULL &&
+         strcmp(series->provider, "jikan") == 0;
+}
+
+// Manga still waiting for their latest chapter
+static bool chapter_pending(const ani_series *series) {
+  return series != NULL && series->id != NULL &&
+         series->media_type == ANI_MEDIA_MANGA &&
+         series->release.latest_number < 0 && series->provider != NULL &&
+         strcmp(series->provider, "mangadex") == 0;
+}
+
+bool ani_fill_schedules(ani_ctx *ctx, ani_result **results, size_t count) {
+  ani_series **pending;
+  ani_series **manga;
+  size_t pending_count;
+  size_t manga_count;
+  size_t i;
+  const ani_logger *prev;
+  bool ok;
+
+  if (ctx == NULL || (results == NULL && count > 0)) {
+    return false;
+  }
+
+  pending = ani_malloc((count + 1) * 2 * sizeof(*pending));
+  if (pending == NULL) {
+    return false;
+  }
+  manga = pending + count + 1;
+
+  pending_count = 0;
+  manga_count = 0;
+  for (i = 0; i < count; i++) {
+    if (results[i] != NULL && results[i]->has_anime &&
+        schedule_pending(results[i]->anime)) {
+      pending[pending_count++] = results[i]->anime;
+    }
+    if (results[i] != NULL && results[i]->has_manga &&
+        chapter_pending(results[i]->manga)) {
+      manga[manga_count++] = results[i]->manga;
+    }
+  }
+
+  prev = ani_log_bind(&ctx->logger);
+
+  // The airing calendar answers what it can without a request
+  for (i = 0; i < pending_count;) {
+    if (calendar_schedule(ctx, pending[i])) {
+      pending[i] = pending[--pending_count];
+    } else {
+      i++;
+    }
+  }
+
+  if (pending_count > 0 && ani_breaker_is_open(ctx->breaker, "anilist")) {
+    LOG_INFO("AniList is down, estimating from broadcast slots");
+    ok = true;
+  } else {
+    ok = pending_count == 0 ||
+         ani_anilist_get_next_episodes(ctx, pending, pending_count);
+  }
+  for (i = 0; ctx->estimates && i < pending_count; i++) {
+    if (pending[i]->release.provider_name == NULL) {
+      ani_broadcast_estimate(time(NULL), &pending[i]->release);
+    }
+  }
+  if (manga_count > 0 &&
+      !ani_mangadex_get_latest_chapters(ctx, manga, manga_count)) {
+    ok = false;
+  }
+
+  // Histories only grow here: a backfill would be one request per series
+  for (i = 0; i < manga_count; i++) {
+    manga_estimate(ctx, manga[i], false);
+  }
+  ani_log_bind(prev);
+
+  ani_free(pending);
+  return ok;
+}
+
+ani_calendar *ani_sync_calendar(ani_ctx *ctx, int days, bool refresh) {
+  ani_calendar *calendar;
+  ani_calendar *fetched;
+  ani_calendar *kept;
+  const ani_logger *prev;
+  int64_t now;
+  bool fresh;
+
+  if (ctx == NULL) {
+    return NULL;
+  }
+
+  if (days < 1) {
+    days = 1;
+  } else if (days > ANI_CALENDAR_DAYS_MAX) {
+    days = ANI_CALENDAR_DAYS_MAX;
+  }
+
+  prev = ani_log_bind(&ctx->logger);
+  now = (int64_t)time(NULL);
+
+  // The caller gets a copy, so the snapshot is only touched under the lock
+  ani_mutex_lock(&ctx->calendar_lock);
+  calendar = calendar_locked(ctx);
+  fresh = !refresh && calendar != NULL &&
+          calendar->to >= now + (int64_t)days * 86400 &&
+          now - calendar->fetched < ANI_CACHE_TTL_SCHEDULE;
+  calendar = fresh ? ani_calendar_copy(calendar) : NULL;
+  ani_mutex_unlock(&ctx->calendar_lock);
+  if (fresh) {
+    LOG_DEBUG("Airing calendar is fresh");
+    ani_log_bind(prev);
+
+    return calendar;
+  }
+
+  fetched = ani_calendar_new(now, now + (int64_t)days * 86400);
+  if (fetched == NULL || !ani_anilist_get_airing(ctx, fetched)) {
+    ani_calendar_free(fetched);
+    ani_mutex_lock(&ctx->calendar_lock);
+    calendar = ani_calendar_copy(ctx->calendar);
+    ani_mutex_unlock(&ctx->calendar_lock);
+    LOG_WARN("Could not sync the airing calendar%s",
+             calendar != NULL ? ", keeping the last one" : "");
+    ani_log_bind(prev);
+
+    return calendar;
+  }
+
+  fetched->fetched = now;
+  if (!ani_calendar_save(ctx->cache, fetched)) {
+    LOG_DEBUG("Airing calendar not cached");
+  }
+  LOG_INFO("Synced %zu episodes airing in the next %d days", fetched->count,
+           days);
+
+  // Lookups keep the old snapshot if there is no memory for a second copy
+  kept = ani_calendar_copy(fetched);
+  if (kept != NULL) {
+    ani_mutex_lock(&ctx->calendar_lock);
+    ani_calendar_free(ctx->calendar);
+    ctx->calendar = kept;
+    ctx->calendar_loaded = true;
+    ani_mutex_unlock(&ctx->calendar_lock);
+  }
+
+  ani_log_bind(prev);
+  return fetched;
+}
+
+size_t ani_suggest(ani_ctx *ctx, const char *query, unsigned int flags,
+                   ani_index_match *out, size_t max) {
+  unsigned int mask;
+
+  if (ctx == NULL || query == NULL || out == NULL) {
+    return 0;
+  }
+
+  mask = 0;
+  if (flags & ANI_LOOKUP_ANIME) {
+    mask |= ANI_INDEX_ANIME;
+  }
+  if (flags & ANI_LOOKUP_MANGA) {
+    mask |= ANI_INDEX_MANGA;
+  }
+
+  return ani_index_suggest(ctx->index, query, mask != 0 ? mask : ANI_INDEX_ALL,
+                           out, max);
+}
@@ -0,0 +1,426 @@
+/*
+ * Routine: ani — Anime/Manga scheduling information CLI
+ * Author: DannyBimma
+ * Copyright: (c) 2025 Technomancer Pirate Captain. All Rights Reserved.
+ */
+
+#include "ani/metrics.h"
+#include "ani/alloc.h"
+#include "ani/fs.h"
+#include "ani/log.h"
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Relaxed atomic add where the compiler offers it
+#if defined(__GNUC__) || defined(__clang__)
+#define METRIC_ADD(var, n) __atomic_fetch_add(&(var), (n), __ATOMIC_RELAXED)
+#define METRIC_LOAD(var) __atomic_load_n(&(var), __ATOMIC_RELAXED)
+#else
+#define METRIC_ADD(var, n) ((var) += (n))
+#define METRIC_LOAD(var) (var)
+#endif
+
+// Provider label slots
+enum { PROV_JIKAN, PROV_ANILIST, PROV_MANGADEX, PROV_OTHER, PROV_COUNT };
+static const char *const provider_names[PROV_COUNT] = {"jikan", "anilist",
+                                                       "mangadex", "other"};
+
+// Status class slots (status 0 means transport error)
+enum { CODE_2XX, CODE_3XX, CODE_4XX, CODE_5XX, CODE_ERROR, CODE_COUNT };
+static const char *const code_names[CODE_COUNT] = {"2xx", "3xx", "4xx", "5xx",
+                                                   "error"};
+
+// Histogram bucket upper bounds in seconds (+Inf is implicit)
+#define BUCKET_COUNT 14
+static const double bucket_bounds[BUCKET_COUNT] = {
+    0.0001, 0.0005, 0.001, 0.005, 0.01, 0.025, 0.05,
+    0.1,    0.25,   0.5,   1.0,   2.5,  5.0,   10.0};
+
+typedef struct {
+  uint64_t buckets[BUCKET_COUNT + 1]; // Non-cumulative, last is +Inf
+  uint64_t count;
+  uint64_t sum_us; // Sum kept in microseconds so it can be added atomically
+} ani_histogram;
+
+static uint64_t http_requests[PROV_COUNT][CODE_COUNT];
+static uint64_t http_retries[PROV_COUNT];
+static uint64_t http_rate_limited[PROV_COUNT];
+static ani_histogram http_duration[PROV_COUNT];
+static uint64_t http_short_circuited[PROV_COUNT];
+static uint64_t hedges_fired[PROV_COUNT];
+static uint64_t hedges_won[PROV_COUNT];
+static uint64_t cache_hits;
+static uint64_t cache_misses;
+static uint64_t cache_evictions;
+static ani_histogram parse_duration;
+static ani_histogram query_duration;
+
+static int provider_slot(const char *provider) {
+  int i;
+
+  if (provider == NULL) {
+    return PROV_OTHER;
+  }
+
+  for (i = 0; i < PROV_OTHER; i++) {
+    if (strcmp(provider, provider_names[i]) == 0) {
+      return i;
+    }
+  }
+
+  return PROV_OTHER;
+}
+
+static int code_slot(long status_code) {
+  if (status_code >= 200 && status_code < 300) {
+    return CODE_2XX;
+  }
+  if (status_code >= 300 && status_code < 400) {
+    return CODE_3XX;
+  }
+  if (status_code >= 400 && status_code < 500) {
+    return CODE_4XX;
+  }
+  if (status_code >= 500 && status_code < 600) {
+    return CODE_5XX;
+  }
+
+  return CODE_ERROR;
+}
+
+static void histogram_observe(ani_histogram *h, double seconds) {
+  int i;
+
+  if (seconds < 0.0) {
+    seconds = 0.0;
+  }
+
+  for (i = 0; i < BUCKET_COUNT; i++) {
+    if (seconds <= bucket_bounds[i]) {
+      break;
+    }
+  }
+
+  METRIC_ADD(h->buckets[i], 1);
+  METRIC_ADD(h->count, 1);
+  METRIC_ADD(h->sum_us, (uint64_t)(seconds * 1e6));
+}
+
+void ani_metrics_http_request(const char *provider, long status_code,
+                              int retries, double seconds) {
+  int p;
+
+  p = provider_slot(provider);
+  METRIC_ADD(http_requests[p][code_slot(status_code)], 1);
+  if (retries > 0) {
+    METRIC_ADD(http_retries[p], (uint64_t)retries);
+  }
+  histogram_observe(&http_duration[p], seconds);
+}
+
+void ani_metrics_http_rate_limited(const char *provider) {
+  METRIC_ADD(http_rate_limited[provider_slot(provider)], 1);
+}
+
+void ani_metrics_http_short_circuit(const char *provider) {
+  METRIC_ADD(http_short_circuited[provider_slot(provider)], 1);
+}
+
+void ani_metrics_hedge_fired(const char *provider) {
+  METRIC_ADD(hedges_fired[provider_slot(provider)], 1);
+}
+
+void ani_metrics_hedge_won(const char *provider) {
+  METRIC_ADD(hedges_won[provider_slot(provider)], 1);
+}
+
+void ani_metrics_hedge_stats(const char *provider, unsigned long *fired,
+                             unsigned long *won) {
+  int p;
+
+  p = provider_slot(provider);
+  if (fired != NULL) {
+    *fired = (unsigned long)METRIC_LOAD(hedges_fired[p]);
+  }
+  if (won != NULL) {
+    *won = (unsigned long)METRIC_LOAD(hedges_won[p]);
+  }
+}
+
+double ani_metrics_http_quantile(const char *provider, double q,
+                                 unsigned long *samples) {
+  const ani_histogram *h;
+  uint64_t counts[BUCKET_COUNT + 1];
+  uint64_t total;
+  double rank;
+  double seen;
+  double lower;
+  int i;
+
+  h = &http_duration[provider_slot(provider)];
+  total = 0;
+  for (i = 0; i <= BUCKET_COUNT; i++) {
+    counts[i] = METRIC_LOAD(h->buckets[i]);
+    total += counts[i];
+  }
+  if (samples != NULL) {
+    *samples = (unsigned long)total;
+  }
+  if (total == 0) {
+    return -1.0;
+  }
+
+  q = q < 0.0 ? 0.0 : (q > 1.0 ? 1.0 : q);
+  rank = q * (double)total;
+  seen = 0.0;
+  lower = 0.0;
+  for (i = 0; i < BUCKET_COUNT; i++) {
+    if (counts[i] > 0 && seen + (double)counts[i] >= rank) {
+      return lower + (bucket_bounds[i] - lower) * (rank - seen) /
+                         (double)counts[i];
+    }
+    seen += (double)counts[i];
+    lower = bucket_bounds[i];
+  }
+
+  // In the +Inf bucket: the largest finite bound is all that is known
+  return bucket_bounds[BUCKET_COUNT - 1];
+}
+
+void ani_metrics_cache_hit(void) { METRIC_ADD(cache_hits, 1); }
+
+void ani_metrics_cache_miss(void) { METRIC_ADD(cache_misses, 1); }
+
+void ani_metrics_cache_eviction(void) { METRIC_ADD(cache_evictions, 1); }
+
+void ani_metrics_observe_parse(double seconds) {
+  histogram_observe(&parse_duration, seconds);
+}
+
+void ani_metrics_observe_query(double seconds) {
+  histogram_observe(&query_duration, seconds);
+}
+
+// Growable text buffer for rendering
+typedef struct {
+  char *data;
+  size_t size;
+  size_t capacity;
+  bool failed;
+} ani_metrics_buf;
+
+static void buf_printf(ani_metrics_buf *buf, const char *fmt, ...) {
+  va_list args;
+  int n;
+
+  if (buf->failed) {
+    return;
+  }
+
+  for (;;) {
+    size_t avail = buf->capacity - buf->size;
+
+    va_start(args, fmt);
+    n = vsnprintf(buf->data + buf->size, avail, fmt, args);
+    va_end(args);
+
+    if (n < 0) {
+      buf->failed = true;
+
+      return;
+    }
+    if ((size_t)n < avail) {
+      buf->size += (size_t)n;
+
+      return;
+    }
+
+    char *new_data = ani_realloc(buf->data, buf->capacity * 2 + (size_t)n);
+    if (new_data == NULL) {
+      buf->failed = true;
+
+      return;
+    }
+    buf->data = new_data;
+    buf->capacity = buf->capacity * 2 + (size_t)n;
+  }
+}
+
+static void render_histogram(ani_metrics_buf *buf, const char *name,
+                             const char *labels, const ani_histogram *h) {
+  uint64_t cumulative;
+  int i;
+
+  cumulative = 0;
+  for (i = 0; i < BUCKET_COUNT; i++) {
+    cumulative += METRIC_LOAD(h->buckets[i]);
+    buf_printf(buf, "%s_bucket{%s%sle=\"%g\"} %llu\n", name, labels,
+               labels[0] != '\0' ? "," : "", bucket_bounds[i],
+               (unsigned long long)cumulative);
+  }
+  cumulative += METRIC_LOAD(h->buckets[BUCKET_COUNT]);
+  buf_printf(buf, "%s_bucket{%s%sle=\"+Inf\"} %llu\n", name, labels,
+             labels[0] != '\0' ? "," : "", (unsigned long long)cumulative);
+
+  if (labels[0] != '\0') {
+    buf_printf(buf, "%s_sum{%s} %.6f\n", name, labels,
+               (double)METRIC_LOAD(h->sum_us) / 1e6);
+    buf_printf(buf, "%s_count{%s} %llu\n", name, labels,
+               (unsigned long long)METRIC_LOAD(h->count));
+  } else {
+    buf_printf(buf, "%s_sum %.6f\n", name,
+               (double)METRIC_LOAD(h->sum_us) / 1e6);
+    buf_printf(buf, "%s_count %llu\n", name,
+               (unsigned long long)METRIC_LOAD(h->count));
+  }
+}
+
+char *ani_metrics_render(void) {
+  ani_metrics_buf buf;
+  char labels[64];
+  int p;
+  int c;
+
+  buf.capacity = 4096;
+  buf.size = 0;
+  buf.failed = false;
+  buf.data = ani_malloc(buf.capacity);
+  if (buf.data == NULL) {
+    return NULL;
+  }
+  buf.data[0] = '\0';
+
+  buf_printf(&buf, "# HELP ani_http_requests_total HTTP requests by provider "
+                   "and status class.\n");
+  buf_printf(&buf, "# TYPE ani_http_requests_total counter\n");
+  for (p = 0; p < PROV_COUNT; p++) {
+    for (c = 0; c < CODE_COUNT; c++) {
+      uint64_t v = METRIC_LOAD(http_requests[p][c]);
+      if (v > 0) {
+        buf_printf(&buf,
+                   "ani_http_requests_total{provider=\"%s\",code=\"%s\"} "
+                   "%llu\n",
+                   provider_names[p], code_names[c], (unsigned long long)v);
+      }
+    }
+  }
+
+  buf_printf(&buf, "# HELP ani_http_retries_total HTTP retries by "
+                   "provider.\n");
+  buf_printf(&buf, "# TYPE ani_http_retries_total counter\n");
+  for (p = 0; p < PROV_COUNT; p++) {
+    buf_printf(&buf, "ani_http_retries_total{provider=\"%s\"} %llu\n",
+               provider_names[p],
+               (unsigned long long)METRIC_LOAD(http_retries[p]));
+  }
+
+  buf_printf(&buf, "# HELP ani_http_rate_limited_total HTTP 429 responses "
+                   "by provider.\n");
+  buf_printf(&buf, "# TYPE ani_http_rate_limited_total counter\n");
+  for (p = 0; p < PROV_COUNT; p++) {
+    buf_printf(&buf, "ani_http_rate_limited_total{provider=\"%s\"} %llu\n",
+               provider_names[p],
+               (unsigned long long)METRIC_LOAD(http_rate_limited[p]));
+  }
+
+  buf_printf(&buf, "# HELP ani_http_short_circuited_total Requests refused "
+                   "by an open circuit, by provider.\n");
+  buf_printf(&buf, "# TYPE ani_http_short_circuited_total counter\n");
+  for (p = 0; p < PROV_COUNT; p++) {
+    buf_printf(&buf,
+               "ani_http_short_circuited_total{provider=\"%s\"} %llu\n",
+               provider_names[p],
+               (unsigned long long)METRIC_LOAD(http_short_circuited[p]));
+  }
+
+  buf_printf(&buf, "# HELP ani_hedges_total Hedged requests fired because "
+                   "the provider was slow.\n");
+  buf_printf(&buf, "# TYPE ani_hedges_total counter\n");
+  for (p = 0; p < PROV_COUNT; p++) {
+    buf_printf(&buf, "ani_hedges_total{provider=\"%s\"} %llu\n",
+               provider_names[p],
+               (unsigned long long)METRIC_LOAD(hedges_fired[p]));
+  }
+
+  buf_printf(&buf, "# HELP ani_hedge_wins_total Hedged races won by "
+                   "provider.\n");
+  buf_printf(&buf, "# TYPE ani_hedge_wins_total counter\n");
+  for (p = 0; p < PROV_COUNT; p++) {
+    buf_printf(&buf, "ani_hedge_wins_total{provider=\"%s\"} %llu\n",
+               provider_names[p],
+               (unsigned long long)METRIC_LOAD(hedges_won[p]));
+  }
+
+  buf_printf(&buf, "# HELP ani_http_request_duration_seconds HTTP request "
+                   "latency including retries.\n");
+  buf_printf(&buf, "# TYPE ani_http_request_duration_seconds histogram\n");
+  for (p = 0; p < PROV_COUNT; p++) {
+    if (METRIC_LOAD(http_duration[p].count) == 0) {
+      continue;
+    }
+    snprintf(labels, sizeof(labels), "provider=\"%s\"", provider_names[p]);
+    render_histogram(&buf, "ani_http_request_duration_seconds", labels,
+                     &http_duration[p]);
+  }
+
+  buf_printf(&buf, "# HELP ani_cache_hits_total Cache lookups served.\n");
+  buf_printf(&buf, "# TYPE ani_cache_hits_total counter\n");
+  buf_printf(&buf, "ani_cache_hits_total %llu\n",
+             (unsigned long long)METRIC_LOAD(cache_hits));
+  buf_printf(&buf, "# HELP ani_cache_misses_total Cache lookups missed.\n");
+  buf_printf(&buf, "# TYPE ani_cache_misses_total counter\n");
+  buf_printf(&buf, "ani_cache_misses_total %llu\n",
+             (unsigned long long)METRIC_LOAD(cache_misses));
+  buf_printf(&buf, "# HELP ani_cache_evictions_total Expired cache entries "
+                   "removed.\n");
+  buf_printf(&buf, "# TYPE ani_cache_evictions_total counter\n");
+  buf_printf(&buf, "ani_cache_evictions_total %llu\n",
+             (unsigned long long)METRIC_LOAD(cache_evictions));
+
+  buf_printf(&buf, "# HELP ani_json_parse_duration_seconds JSON parse "
+                   "time.\n");
+  buf_printf(&buf, "# TYPE ani_json_parse_duration_seconds histogram\n");
+  render_histogram(&buf, "ani_json_parse_duration_seconds", "",
+                   &parse_duration);
+
+  buf_printf(&buf, "# HELP ani_query_duration_seconds End-to-end query "
+                   "latency.\n");
+  buf_printf(&buf, "# TYPE ani_query_duration_seconds histogram\n");
+  render_histogram(&buf, "ani_query_duration_seconds", "", &query_duration);
+
+  if (buf.failed) {
+    ani_free(buf.data);
+
+    return NULL;
+  }
+
+  return buf.data;
+}
+
+bool ani_metrics_write_file(const char *path) {
+  char *text;
+  bool ok;
+
+  if (path == NULL) {
+    return false;
+  }
+
+  text = ani_metrics_render();
+  if (text == NULL) {
+    return false;
+  }
+
+  // Scrapers must never see a half-written file
+  ok = ani_write_file_atomic(path, text, strlen(text));
+  if (!ok) {
+    LOG_WARN("Failed to write metrics file: %s", path);
+  } else {
+    LOG_DEBUG("Wrote metrics to %s", path);
+  }
+
+  ani_free(text);
+  return ok;
+}
@@ -5,7 +5,11 @@
  */
 
 #include "ani/json.h"
+#include "ani/alloc.h"
 #include "ani/log.h"
+#include "ani/metrics.h"
+#include "ani/time.h"
+#include "ani/trace.h"
 #include <stdlib.h>
 #include <string.h>
 #include <yyjson.h>
@@ -15,28 +19,54 @@ struct ani_json_doc {
   yyjson_doc *doc;
 };
 
-// Internal value structure (just wraps yyjson_val)
-struct ani_json_val {
-  yyjson_val *val;
-};
+// Values are yyjson_val pointers handed out under the opaque type, so every
+// lookup returns a distinct, thread-safe handle that lives as long as the doc
+#define TO_YY(v) ((yyjson_val *)(v))
+#define FROM_YY(v) ((ani_json_val *)(v))
+
+static void *alc_malloc(void *ctx, size_t size) {
+  (void)ctx;
+  return ani_malloc(size);
+}
+
+static void *alc_realloc(void *ctx, void *ptr, size_t old_size, size_t size) {
+  (void)ctx;
+  (void)old_size;
+  return ani_realloc(ptr, size);
+}
+
+static void alc_free(void *ctx, void *ptr) {
+  (void)ctx;
+  ani_free(ptr);
+}
+
+static const yyjson_alc json_alc = {alc_malloc, alc_realloc, alc_free, NULL};
+
+const struct yyjson_alc *ani_json_alc(void) { return &json_alc; }
 
 ani_json_doc *ani_json_parse(const char *json_str, size_t len) {
   ani_json_doc *doc;
   yyjson_read_err err;
+  ani_trace_span span;
+  int64_t start_us;
 
   if (json_str == NULL || len == 0) {
     return NULL;
   }
 
-  doc = malloc(sizeof(*doc));
+  doc = ani_malloc(sizeof(*doc));
   if (doc == NULL) {
     return NULL;
   }
 
-  doc->doc = yyjson_read_opts((char *)json_str, len, 0, NULL, &err);
+  ANI_TRACE_BEGIN(span, "json.parse", "json");
+  start_us = ani_monotonic_us();
+  doc->doc = yyjson_read_opts((char *)json_str, len, 0, &json_alc, &err);
+  ani_metrics_observe_parse((double)(ani_monotonic_us() - start_us) / 1e6);
+  ANI_TRACE_END(span);
   if (doc->doc == NULL) {
     LOG_ERROR("JSON parse error: %s (at position %zu)", err.msg, err.pos);
-    free(doc);
+    ani_free(doc);
 
     return NULL;
   }
@@ -50,64 +80,48 @@ void ani_json_doc_free(ani_json_doc *doc) {
   }
 
   yyjson_doc_free(doc->doc);
-  free(doc);
+  ani_free(doc);
 }
 
 ani_json_val *ani_json_get_root(ani_json_doc *doc) {
-  static struct ani_json_val root_wrapper;
-
   if (doc == NULL || doc->doc == NULL) {
     return NULL;
   }
 
-  root_wrapper.val = yyjson_doc_get_root(doc->doc);
-  if (root_wrapper.val == NULL) {
-    return NULL;
-  }
-
-  return &root_wrapper;
+  return FROM_YY(yyjson_doc_get_root(doc->doc));
 }
 
 bool ani_json_is_object(const ani_json_val *val) {
-  return val != NULL && val->val != NULL && yyjson_is_obj(val->val);
+  return val != NULL && yyjson_is_obj(TO_YY(val));
 }
 
 bool ani_json_is_array(const ani_json_val *val) {
-  return val != NULL && val->val != NULL && yyjson_is_arr(val->val);
+  return val != NULL && yyjson_is_arr(TO_YY(val));
 }
 
 bool ani_json_is_string(const ani_json_val *val) {
-  return val != NULL && val->val != NULL && yyjson_is_str(val->val);
+  return val != NULL && yyjson_is_str(TO_YY(val));
 }
 
 bool ani_json_is_int(const ani_json_val *val) {
-  return val != NULL && val->val != NULL &&
-         (yyjson_is_int(val->val) || yyjson_is_uint(val->val));
+  return val != NULL &&
+         (yyjson_is_int(TO_YY(val)) || yyjson_is_uint(TO_YY(val)));
 }
 
 bool ani_json_is_bool(const ani_json_val *val) {
-  return val != NULL && val->val != NULL && yyjson_is_bool(val->val);
+  return val != NULL && yyjson_is_bool(TO_YY(val));
 }
 
 bool ani_json_is_null(const ani_json_val *val) {
-  return val == NULL || val->val == NULL || yyjson_is_null(val->val);
+  return val == NULL || yyjson_is_null(TO_YY(val));
 }
 
 ani_json_val *ani_json_object_get(const ani_json_val *obj, const char *key) {
-  static struct ani_json_val result;
-  yyjson_val *val;
-
   if (!ani_json_is_object(obj) || key == NULL) {
     return NULL;
   }
 
-  val = yyjson_obj_get(obj->val, key);
-  if (val == NULL) {
-    return NULL;
-  }
-
-  result.val = val;
-  return &result;
+  return FROM_YY(yyjson_obj_get(TO_YY(obj), key));
 }
 
 const char *ani_json_object_get_string(const ani_json_val *obj,
@@ -142,29 +156,45 @@ bool ani_json_object_get_bool(const ani_json_val *obj, const char *key,
   return ani_json_get_bool(val);
 }
 
-size_t ani_json_array_size(const ani_json_val *arr) {
-  if (!ani_json_is_array(arr)) {
+size_t ani_json_object_size(const ani_json_val *obj) {
+  if (!ani_json_is_object(obj)) {
     return 0;
   }
 
-  return yyjson_arr_size(arr->val);
+  return yyjson_obj_size(TO_YY(obj));
 }
 
-ani_json_val *ani_json_array_get(const ani_json_val *arr, size_t index) {
-  static struct ani_json_val result;
-  yyjson_val *val;
+ani_json_val *ani_json_object_value_at(const ani_json_val *obj, size_t index) {
+  yyjson_obj_iter iter;
+  yyjson_val *key;
 
-  if (!ani_json_is_array(arr)) {
+  if (!ani_json_is_object(obj) || !yyjson_obj_iter_init(TO_YY(obj), &iter)) {
     return NULL;
   }
 
-  val = yyjson_arr_get(arr->val, index);
-  if (val == NULL) {
+  while ((key = yyjson_obj_iter_next(&iter)) != NULL) {
+    if (index-- == 0) {
+      return FROM_YY(yyjson_obj_iter_get_val(key));
+    }
+  }
+
+  return NULL;
+}
+
+size_t ani_json_array_size(const ani_json_val *arr) {
+  if (!ani_json_is_array(arr)) {
+    return 0;
+  }
+
+  return yyjson_arr_size(TO_YY(arr));
+}
+
+ani_json_val *ani_json_array_get(const ani_json_val *arr, size_t index) {
+  if (!ani_json_is_array(arr)) {
     return NULL;
   }
 
-  result.val = val;
-  return &result;
+  return FROM_YY(yyjson_arr_get(TO_YY(arr), index));
 }
 
 const char *ani_json_get_string(const ani_json_val *val) {
@@ -172,7 +202,7 @@ const char *ani_json_get_string(const ani_json_val *val) {
     return NULL;
   }
 
-  return yyjson_get_str(val->val);
+  return yyjson_get_str(TO_YY(val));
 }
 
 long ani_json_get_int(const ani_json_val *val) {
@@ -180,10 +210,10 @@ long ani_json_get_int(const ani_json_val *val) {
     return 0;
   }
 
-  if (yyjson_is_int(val->val)) {
-    return (long)yyjson_get_sint(val->val);
+  if (yyjson_is_int(TO_YY(val))) {
+    return (long)yyjson_get_sint(TO_YY(val));
   } else {
-    return (long)yyjson_get_uint(val->val);
+    return (long)yyjson_get_uint(TO_YY(val));
   }
 }
 
@@ -192,7 +222,7 @@ bool ani_json_get_bool(const ani_json_val *val) {
     return false;
   }
 
-  return yyjson_get_bool(val->val);
+  return yyjson_get_bool(TO_YY(val));
 }
 
 const char *ani_json_get_string_safe(const ani_json_val *val,
@@ -9,130 +9,356 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
-#include "ani/cache.h"
+#include "ani/alloc.h"
+#include "ani/ani.h"
 #include "ani/cli.h"
 #include "ani/http.h"
 #include "ani/log.h"
+#include "ani/metrics.h"
 #include "ani/models.h"
 #include "ani/output.h"
-#include "ani/providers/anilist.h"
-#include "ani/providers/jikan.h"
-#include "ani/providers/mangadex.h"
+#include "ani/str.h"
+#include "ani/trace.h"
 #include "ani/version.h"
 
-static int process_query(const ani_cli_options *opts) {
-  ani_result *result;
-  bool anime_success;
-  bool manga_success;
+// Suggestions printed by --suggest
+#define SUGGEST_MAX 10
 
-  if (opts == NULL || opts->query == NULL) {
-    fprintf(stderr, "Error: No query provided\n");
+// ANI_ALLOCATOR=count|bump swaps the process allocator (see ani/alloc.h)
+static ani_alloc_counter alloc_counter;
+static ani_bump alloc_bump;
 
-    return 1;
+static void allocator_setup(void) {
+  const char *name;
+  ani_allocator allocator;
+
+  name = getenv("ANI_ALLOCATOR");
+  if (name == NULL || name[0] == '\0' || strcmp(name, "libc") == 0) {
+    return;
   }
 
-  result = ani_result_new();
-  if (result == NULL) {
-    fprintf(stderr, "Error: Failed to allocate result\n");
+  if (strcmp(name, "count") == 0) {
+    ani_alloc_counter_init(&alloc_counter, NULL);
+    allocator = ani_alloc_counter_allocator(&alloc_counter);
+  } else if (strcmp(name, "bump") == 0 && ani_bump_init(&alloc_bump, 0)) {
+    allocator = ani_bump_allocator(&alloc_bump);
+  } else {
+    fprintf(stderr, "Warning: unknown ANI_ALLOCATOR '%s', using libc\n", name);
 
-    return 1;
+    return;
   }
 
-  result->query = strdup(opts->query);
+  ani_set_allocator(&allocator);
+}
 
-  // Query anime if requested
-  if (opts->query_both || opts->query_anime) {
-    LOG_INFO("Searching for anime: %s", opts->query);
-
-    result->anime = ani_series_new();
-    if (result->anime != NULL) {
-      anime_success = ani_jikan_search_anime(opts->query, result->anime);
-      if (anime_success) {
-        result->has_anime = true;
-
-        // Get next episode schedule from AniList
-        if (result->anime->id != NULL) {
-          ani_anilist_get_next_episode(result->anime->id, result->anime);
-        }
-      } else {
-        LOG_WARN("Anime search failed or no results");
-        ani_series_free(result->anime);
-        result->anime = NULL;
-      }
-    }
+// Report counters and drop the custom allocator once everything is freed
+static void allocator_teardown(void) {
+  ani_alloc_stats stats;
+
+  if (ani_get_allocator().ctx == &alloc_counter) {
+    ani_alloc_counter_stats(&alloc_counter, &stats);
+    fprintf(stderr,
+            "allocations: %llu allocs, %llu reallocs, %llu frees, %llu bytes "
+            "(peak %llu live, %llu still live)\n",
+            (unsigned long long)stats.allocs,
+            (unsigned long long)stats.reallocs,
+            (unsigned long long)stats.frees, (unsigned long long)stats.bytes,
+            (unsigned long long)stats.peak_bytes,
+            (unsigned long long)stats.live_bytes);
   }
 
-  // Query manga if requested
+  ani_set_allocator(NULL);
+  ani_bump_destroy(&alloc_bump);
+}
+
+// Batch lines longer than this are skipped
+#define BATCH_LINE_MAX 1024
+
+// Lookup flags shared by every query of this run
+static unsigned int lookup_flags(const ani_cli_options *opts) {
+  unsigned int flags;
+
+  // One arena per query: the result is freed in a single call after output
+  flags = ANI_LOOKUP_ARENA;
+  if (opts->query_both || opts->query_anime) {
+    flags |= ANI_LOOKUP_ANIME;
+  }
   if (opts->query_both || opts->query_manga) {
-    LOG_INFO("Searching for manga: %s", opts->query);
-
-    result->manga = ani_series_new();
-    if (result->manga != NULL) {
-      manga_success = ani_mangadex_search_manga(opts->query, result->manga);
-      if (manga_success) {
-        result->has_manga = true;
-
-        // Get latest chapter info
-        if (result->manga->id != NULL) {
-          ani_mangadex_get_latest_chapter(result->manga->id, result->manga);
-        }
-      } else {
-        LOG_WARN("Manga search failed or no results");
-        ani_series_free(result->manga);
-        result->manga = NULL;
-      }
-    }
+    flags |= ANI_LOOKUP_MANGA;
+  }
+  if (opts->refresh_cache) {
+    flags |= ANI_LOOKUP_REFRESH;
   }
+  if (opts->parallel) {
+    flags |= ANI_LOOKUP_PARALLEL;
+  }
+  if (opts->broadcast) {
+    flags |= ANI_LOOKUP_BROADCAST;
+  }
+
+  return flags;
+}
 
-  // Output results
+static void render_result(const ani_cli_options *opts,
+                          const ani_result *result) {
+  ani_trace_span span;
+
+  ANI_TRACE_BEGIN(span, "output.render", "cli");
   if (opts->output_json) {
     ani_output_print_json(result);
   } else {
     ani_output_print_result(result);
   }
+  ANI_TRACE_END(span);
+}
 
-  // Cleanup
+// Look up a title or an ID; NULL (after an error message) on failure
+static ani_result *lookup_one(ani_ctx *ctx, const ani_id_type *type,
+                              const char *target, unsigned int flags) {
+  ani_result *result;
+
+  if (type != NULL) {
+    if (!ani_lookup_id(ctx, *type, target, flags, &result)) {
+      fprintf(stderr, "Error: Invalid ID: %s\n", target);
+
+      return NULL;
+    }
+  } else if (!ani_lookup(ctx, target, flags, &result)) {
+    fprintf(stderr, "Error: Failed to allocate result\n");
+
+    return NULL;
+  }
+
+  return result;
+}
+
+static int run_one(ani_ctx *ctx, const ani_cli_options *opts,
+                   const ani_id_type *type, const char *target) {
+  ani_result *result;
+
+  result = lookup_one(ctx, type, target, lookup_flags(opts));
+  if (result == NULL) {
+    return 1;
+  }
+
+  render_result(opts, result);
   ani_result_free(result);
 
   return 0;
 }
 
+// One batch line: mal:<id>, anilist:<id>, mangadex:<uuid> or a title
+static ani_result *lookup_line(ani_ctx *ctx, char *line,
+                               unsigned int flags) {
+  static const struct {
+    const char *prefix;
+    ani_id_type type;
+  } id_prefixes[] = {{"mal:", ANI_ID_MAL},
+                     {"anilist:", ANI_ID_ANILIST},
+                     {"mangadex:", ANI_ID_MANGADEX}};
+  size_t len;
+  size_t i;
+
+  for (i = 0; i < sizeof(id_prefixes) / sizeof(id_prefixes[0]); i++) {
+    len = strlen(id_prefixes[i].prefix);
+    if (strncmp(line, id_prefixes[i].prefix, len) == 0) {
+      return lookup_one(ctx, &id_prefixes[i].type, ani_str_trim(line + len),
+                        flags);
+    }
+  }
+
+  return lookup_one(ctx, NULL, line, flags);
+}
+
+// Resolve every line first, then fetch the anime schedules in bulk (one
+// AniList request per 50 titles) and print in input order
+static int run_batch(ani_ctx *ctx, const ani_cli_options *opts) {
+  char line[BATCH_LINE_MAX];
+  FILE *f;
+  ani_result **results;
+  ani_result **grown;
+  ani_result *result;
+  size_t count;
+  size_t cap;
+  size_t len;
+  size_t i;
+  int ret;
+
+  f = strcmp(opts->batch_path, "-") == 0 ? stdin : fopen(opts->batch_path, "r");
+  if (f == NULL) {
+    fprintf(stderr, "Error: Cannot open %s\n", opts->batch_path);
+
+    return 1;
+  }
+
+  ret = 0;
+  results = NULL;
+  count = 0;
+  cap = 0;
+  while (fgets(line, sizeof(line), f) != NULL) {
+    len = strlen(line);
+    if (len == sizeof(line) - 1 && line[len - 1] != '\n' && !feof(f)) {
+      fprintf(stderr, "Warning: Skipping overlong line in %s\n",
+              opts->batch_path);
+      while (fgets(line, sizeof(line), f) != NULL &&
+             line[strlen(line) - 1] != '\n') {
+      }
+      continue;
+    }
+    if (ani_str_collapse_ws(line) == 0 || line[0] == '#') {
+      continue;
+    }
+
+    result =
+        lookup_line(ctx, line, lookup_flags(opts) | ANI_LOOKUP_DEFER_SCHEDULE);
+    if (result == NULL) {
+      ret = 1;
+      continue;
+    }
+
+    if (count == cap) {
+      cap = cap > 0 ? cap * 2 : 16;
+      grown = ani_realloc(results, cap * sizeof(*results));
+      if (grown == NULL) {
+        fprintf(stderr, "Error: Failed to allocate result\n");
+        ani_result_free(result);
+        ret = 1;
+        break;
+      }
+      results = grown;
+    }
+    results[count++] = result;
+  }
+
+  if (f != stdin) {
+    fclose(f);
+  }
+
+  if (!ani_fill_schedules(ctx, results, count)) {
+    LOG_WARN("Some schedules could not be fetched");
+  }
+
+  for (i = 0; i < count; i++) {
+    render_result(opts, results[i]);
+    ani_result_free(results[i]);
+  }
+  ani_free(results);
+
+  return ret;
+}
+
+static int process_query(ani_ctx *ctx, const ani_cli_options *opts) {
+  ani_id_type type;
+  int ret;
+
+  // The title first, then IDs, then the batch file
+  ret = 0;
+  if (opts->query != NULL) {
+    ret |= run_one(ctx, opts, NULL, opts->query);
+  }
+  if (opts->mal_id != NULL) {
+    type = ANI_ID_MAL;
+    ret |= run_one(ctx, opts, &type, opts->mal_id);
+  }
+  if (opts->anilist_id != NULL) {
+    type = ANI_ID_ANILIST;
+    ret |= run_one(ctx, opts, &type, opts->anilist_id);
+  }
+  if (opts->mangadex_id != NULL) {
+    type = ANI_ID_MANGADEX;
+    ret |= run_one(ctx, opts, &type, opts->mangadex_id);
+  }
+  if (opts->batch_path != NULL) {
+    ret |= run_batch(ctx, opts);
+  }
+
+  return ret;
+}
+
+// Episodes airing over the next --days, from one synced AniList calendar
+static int process_calendar(ani_ctx *ctx, const ani_cli_options *opts) {
+  ani_calendar *calendar;
+  int64_t now;
+  int days;
+
+  days = opts->calendar_days;
+  if (days < 1 || days > ANI_CALENDAR_DAYS_MAX) {
+    fprintf(stderr, "Error: --days must be between 1 and %d\n",
+            ANI_CALENDAR_DAYS_MAX);
+
+    return 1;
+  }
+
+  calendar = ani_sync_calendar(ctx, days, opts->refresh_cache);
+  if (calendar == NULL) {
+    fprintf(stderr, "Error: Could not fetch the airing calendar\n");
+
+    return 1;
+  }
+
+  now = (int64_t)time(NULL);
+  ani_output_print_calendar(calendar, now, now + (int64_t)days * 86400,
+                            opts->output_json);
+  ani_calendar_free(calendar);
+
+  return 0;
+}
+
+// Completion candidates from the local title index; never touches the network
+static int process_suggest(ani_ctx *ctx, const ani_cli_options *opts) {
+  ani_index_match matches[SUGGEST_MAX];
+  unsigned int flags;
+  size_t count;
+
+  flags = 0;
+  if (opts->query_both || opts->query_anime) {
+    flags |= ANI_LOOKUP_ANIME;
+  }
+  if (opts->query_both || opts->query_manga) {
+    flags |= ANI_LOOKUP_MANGA;
+  }
+
+  count = ani_suggest(ctx, opts->query, flags, matches, SUGGEST_MAX);
+  ani_output_print_suggestions(matches, count, opts->output_json);
+
+  return 0;
+}
+
 int main(int argc, char **argv) {
   ani_cli_options opts;
+  ani_ctx_options ctx_opts;
+  ani_ctx *ctx;
+  ani_trace_span args_span;
   int ret;
 
   // Set locale for UTF-8
   setlocale(LC_ALL, "");
 
-  // Init HTTP subsystem
-  ani_http_init();
-
-  // Init cache
-  ani_cache_init();
+  // Before anything allocates
+  allocator_setup();
 
   // Handle no arguments - interactive mode
   if (argc < 2) {
     printf("Interactive mode not yet implemented.\n");
     printf("Try: %s --help\n", argv[0]);
-    ani_http_cleanup();
 
     return 0;
   }
 
-  // Parse arguments
+  // Parse arguments (span is kept in case --trace turns up)
+  ani_trace_span_begin(&args_span, "cli.parse_args", "cli");
   if (!ani_cli_parse_args(argc, argv, &opts)) {
     // Check for version/help flags
     for (int i = 1; i < argc; i++) {
       if (strcmp(argv[i], "--version") == 0 || strcmp(argv[i], "-V") == 0) {
         ani_cli_print_version();
-        ani_http_cleanup();
 
         return 0;
       }
       if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
         ani_cli_print_usage(argv[0]);
-        ani_http_cleanup();
 
         return 0;
       }
@@ -140,7 +366,6 @@ int main(int argc, char **argv) {
 
     // Parse error
     ani_cli_print_usage(argv[0]);
-    ani_http_cleanup();
 
     return 1;
   }
@@ -154,22 +379,82 @@ int main(int argc, char **argv) {
     ani_log_set_level(ANI_LOG_DEBUG);
   }
 
-  // Require query
-  if (opts.query == NULL) {
+  // Start tracing before anything else is timed
+  if (opts.trace_path != NULL) {
+    if (!ani_trace_start(opts.trace_path)) {
+      LOG_WARN("Failed to start tracing to %s", opts.trace_path);
+    }
+  }
+  ani_trace_span_end(&args_span);
+
+  // Require something to look up
+  if (opts.calendar && opts.query != NULL) {
+    fprintf(stderr, "Error: calendar takes no query\n");
+    ani_cli_print_usage(argv[0]);
+    ani_trace_stop();
+    ani_cli_options_free(&opts);
+
+    return 1;
+  }
+  if (!opts.calendar && opts.query == NULL &&
+      (opts.suggest || (opts.mal_id == NULL && opts.anilist_id == NULL &&
+                        opts.mangadex_id == NULL && opts.batch_path == NULL))) {
     fprintf(stderr, "Error: No query provided\n");
     ani_cli_print_usage(argv[0]);
+    ani_trace_stop();
+    ani_cli_options_free(&opts);
+
+    return 1;
+  }
+
+  // Init HTTP and cache subsystems
+  ani_ctx_options_init(&ctx_opts);
+  if (opts.timeout_ms > 0) {
+    ctx_opts.timeout_ms = opts.timeout_ms;
+  }
+  if (opts.hedge_ms > 0) {
+    ctx_opts.hedge_ms = opts.hedge_ms;
+  }
+  ctx_opts.estimates = !opts.official_only;
+  if (opts.deadline_ms > 0) {
+    ctx_opts.deadline_ms = opts.deadline_ms;
+  }
+  ctx = ani_ctx_new(&ctx_opts);
+  if (ctx == NULL) {
+    fprintf(stderr, "Error: Failed to initialize\n");
+    ani_trace_stop();
     ani_cli_options_free(&opts);
-    ani_http_cleanup();
 
     return 1;
   }
 
+  // Record per-request timings for the report
+  ani_http_timings_enable(opts.show_timings);
+
   // Process query
-  ret = process_query(&opts);
+  if (opts.calendar) {
+    ret = process_calendar(ctx, &opts);
+  } else if (opts.suggest) {
+    ret = process_suggest(ctx, &opts);
+  } else {
+    ret = process_query(ctx, &opts);
+  }
+
+  // Lost hedges still in flight record into the timings, the metrics and
+  // the trace, so they finish first
+  ani_ctx_drain(ctx);
+  if (!opts.suggest && !opts.output_json && opts.show_timings) {
+    ani_output_print_timings();
+  }
 
   // Cleanup
+  if (opts.metrics_path != NULL) {
+    ani_metrics_write_file(opts.metrics_path);
+  }
+  ani_trace_stop();
   ani_cli_options_free(&opts);
-  ani_http_cleanup();
+  ani_ctx_free(ctx);
+  allocator_teardown();
 
   return ret;
 }
@@ -5,23 +5,47 @@
  */
 
 #include "ani/models.h"
+#include "ani/alloc.h"
 #include "ani/str.h"
 #include <stdlib.h>
 #include <string.h>
 
+static void series_init(ani_series *series) {
+  series->release.latest_number = -1;
+  series->release.next_number = -1;
+  series->release.total_count = -1;
+  series->release.next_source = ANI_SOURCE_UNKNOWN;
+  series->release.next_confidence = ANI_CONFIDENCE_LOW;
+  series->release.broadcast.weekday = -1;
+}
+
 ani_series *ani_series_new(void) {
   ani_series *series;
 
-  series = calloc(1, sizeof(*series));
+  series = ani_calloc(1, sizeof(*series));
   if (series == NULL) {
     return NULL;
   }
 
-  series->release.latest_number = -1;
-  series->release.next_number = -1;
-  series->release.total_count = -1;
-  series->release.next_source = ANI_SOURCE_UNKNOWN;
-  series->release.next_confidence = ANI_CONFIDENCE_LOW;
+  series_init(series);
+
+  return series;
+}
+
+ani_series *ani_series_new_in(ani_arena *arena) {
+  ani_series *series;
+
+  if (arena == NULL) {
+    return ani_series_new();
+  }
+
+  series = ani_arena_alloc(arena, sizeof(*series));
+  if (series == NULL) {
+    return NULL;
+  }
+
+  series_init(series);
+  series->arena = arena;
 
   return series;
 }
@@ -31,9 +55,9 @@ void ani_title_free(ani_title *title) {
     return;
   }
 
-  free(title->english);
-  free(title->japanese);
-  free(title->canonical);
+  ani_free(title->english);
+  ani_free(title->japanese);
+  ani_free(title->canonical);
 
   title->english = NULL;
   title->japanese = NULL;
@@ -45,17 +69,47 @@ void ani_series_free(ani_series *series) {
     return;
   }
 
-  free(series->id);
+  // Arena series go away with their arena
+  if (series->arena != NULL) {
+    return;
+  }
+
+  ani_free(series->id);
   ani_title_free(&series->title);
-  free(series->release.provider_name);
-  free(series->provider);
-  free(series);
+  ani_free(series);
 }
 
 ani_result *ani_result_new(void) {
   ani_result *result;
 
-  result = calloc(1, sizeof(*result));
+  result = ani_calloc(1, sizeof(*result));
+  return result;
+}
+
+ani_result *ani_result_new_arena(ani_arena *arena) {
+  ani_result *result;
+  bool owns_arena;
+
+  owns_arena = arena == NULL;
+  if (owns_arena) {
+    arena = ani_arena_new(0);
+    if (arena == NULL) {
+      return NULL;
+    }
+  }
+
+  result = ani_arena_alloc(arena, sizeof(*result));
+  if (result == NULL) {
+    if (owns_arena) {
+      ani_arena_free(arena);
+    }
+
+    return NULL;
+  }
+
+  result->arena = arena;
+  result->owns_arena = owns_arena;
+
   return result;
 }
 
@@ -64,10 +118,44 @@ void ani_result_free(ani_result *result) {
     return;
   }
 
-  free(result->query);
+  if (result->arena != NULL) {
+    if (result->owns_arena) {
+      ani_arena_free(result->arena);
+    }
+
+    return;
+  }
+
+  ani_free(result->query);
   ani_series_free(result->anime);
   ani_series_free(result->manga);
-  free(result);
+  ani_free(result);
+}
+
+char *ani_series_strdup(ani_series *series, const char *s) {
+  if (series != NULL && series->arena != NULL) {
+    return ani_arena_strdup(series->arena, s);
+  }
+
+  return ani_strdup(s);
+}
+
+void ani_series_set_title(ani_series *series, const char *english,
+                          const char *japanese, const char *canonical) {
+  if (series == NULL) {
+    return;
+  }
+
+  if (series->arena == NULL) {
+    ani_title_set(&series->title, english, japanese, canonical);
+
+    return;
+  }
+
+  // Replaced arena strings are reclaimed with the arena
+  series->title.english = ani_arena_strdup(series->arena, english);
+  series->title.japanese = ani_arena_strdup(series->arena, japanese);
+  series->title.canonical = ani_arena_strdup(series->arena, canonical);
 }
 
 void ani_title_set(ani_title *title, const char *english, const char *japanese,
@@ -0,0 +1,364 @@
+/*
+ * Routine: ani — Anime/Manga scheduling information CLI
+ * Author: DannyBimma
+ * Copyright: (c) 2025 Technomancer Pirate Captain. All Rights Reserved.
+ */
+
+#include "ani/breaker.h"
+#include "ani/alloc.h"
+#include "ani/fs.h"
+#include "ani/log.h"
+#include "ani/metrics.h"
+#include "ani/str.h"
+#include "ani/thread.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_CIRCUITS 8
+#define BREAKER_FILE "breaker.state"
+#define BREAKER_MAGIC "ani-breaker 1"
+
+#define FAILURE_THRESHOLD 5 // Failed attempts in a row that open a circuit
+#define COOLDOWN_MIN 30     // Seconds open after the first trip
+#define COOLDOWN_MAX 300    // Cap while probes keep failing
+#define RETRY_COST 5        // First attempts that earn one retry (20%)
+#define RETRY_BURST 10      // Retries that can be saved up
+
+typedef enum {
+  CIRCUIT_CLOSED,
+  CIRCUIT_OPEN,
+  CIRCUIT_HALF_OPEN // One probe in flight
+} ani_circuit_state;
+
+typedef struct {
+  char name[32];
+  ani_circuit_state state;
+  int failures;      // Consecutive failed attempts
+  time_t open_until; // Wall clock, so other processes can honour it (while
+                     // half-open: when the probe went out)
+  long cooldown;     // Seconds the circuit stays open on the next trip
+} ani_circuit;
+
+struct ani_breaker {
+  ani_mutex lock;
+  char *path; // State file, NULL if not persisted
+  ani_circuit circuits[MAX_CIRCUITS];
+  size_t count;
+  int retry_credit; // First attempts, RETRY_COST per retry; capped
+  bool dirty; // Credit or a circuit changed since the last save
+};
+
+// Circuit for provider, added closed on first use (NULL when full)
+static ani_circuit *find_circuit(ani_breaker *breaker, const char *provider) {
+  ani_circuit *circuit;
+  size_t i;
+
+  for (i = 0; i < breaker->count; i++) {
+    if (strcmp(breaker->circuits[i].name, provider) == 0) {
+      return &breaker->circuits[i];
+    }
+  }
+
+  if (breaker->count == MAX_CIRCUITS) {
+    return NULL;
+  }
+
+  circuit = &breaker->circuits[breaker->count++];
+  memset(circuit, 0, sizeof(*circuit));
+  ani_strlcpy(circuit->name, provider, sizeof(circuit->name));
+  circuit->cooldown = COOLDOWN_MIN;
+
+  return circuit;
+}
+
+// Parse breaker.state:
+//   ani-breaker 1
+//   budget <retry credit>
+//   circuit <provider> <state> <failures> <open until> <cooldown>
+static void load_state(ani_breaker *breaker) {
+  char *data;
+  char *line;
+  char *next;
+  char name[32];
+  ani_circuit *circuit;
+  int credit;
+  int state;
+  int failures;
+  long long open_until;
+  long cooldown;
+
+  data = ani_read_file(breaker->path, NULL);
+  if (data == NULL) {
+    return;
+  }
+
+  if (strncmp(data, BREAKER_MAGIC "\n", sizeof(BREAKER_MAGIC)) != 0) {
+    LOG_WARN("Ignoring unrecognized %s", breaker->path);
+    ani_free(data);
+
+    return;
+  }
+
+  for (line = data; line != NULL && *line != '\0'; line = next) {
+    next = strchr(line, '\n');
+    if (next != NULL) {
+      *next++ = '\0';
+    }
+
+    if (sscanf(line, "budget %d", &credit) == 1) {
+      breaker->retry_credit = credit < 0 ? 0
+                              : credit > RETRY_BURST * RETRY_COST
+                                  ? RETRY_BURST * RETRY_COST
+                                  : credit;
+    } else if (sscanf(line, "circuit %31s %d %d %lld %ld", name, &state,
+                      &failures, &open_until, &cooldown) == 5) {
+      circuit = find_circuit(breaker, name);
+      if (circuit == NULL) {
+        continue;
+      }
+
+      // A probe left in flight by another process is open again
+      circuit->state = state == CIRCUIT_CLOSED ? CIRCUIT_CLOSED : CIRCUIT_OPEN;
+      circuit->failures = failures > 0 ? failures : 0;
+      circuit->open_until = (time_t)open_until;
+      circuit->cooldown = cooldown < COOLDOWN_MIN   ? COOLDOWN_MIN
+                          : cooldown > COOLDOWN_MAX ? COOLDOWN_MAX
+                                                    : cooldown;
+    }
+  }
+
+  ani_free(data);
+}
+
+// Take in circuits other processes changed since we loaded the file: for
+// each provider the side that changed state last (later open_until) wins
+// (lock held)
+static void merge_state(ani_breaker *breaker) {
+  ani_breaker disk;
+  ani_circuit *circuit;
+  size_t i;
+
+  memset(&disk, 0, sizeof(disk));
+  disk.path = breaker->path;
+  disk.retry_credit = breaker->retry_credit;
+  load_state(&disk);
+
+  for (i = 0; i < disk.count; i++) {
+    circuit = find_circuit(breaker, disk.circuits[i].name);
+    if (circuit != NULL &&
+        disk.circuits[i].open_until > circuit->open_until) {
+      *circuit = disk.circuits[i];
+    }
+  }
+}
+
+// Write the state file, merged with what is on disk (lock held)
+static void save_state(ani_breaker *breaker) {
+  char text[64 + MAX_CIRCUITS * 96];
+  size_t used;
+  size_t i;
+  const ani_circuit *circuit;
+
+  breaker->dirty = false;
+  if (breaker->path == NULL) {
+    return;
+  }
+
+  merge_state(breaker);
+  used = (size_t)snprintf(text, sizeof(text), "%s\nbudget %d\n",
+                          BREAKER_MAGIC, breaker->retry_credit);
+  for (i = 0; i < breaker->count && used < sizeof(text); i++) {
+    circuit = &breaker->circuits[i];
+    used += (size_t)snprintf(
+        text + used, sizeof(text) - used, "circuit %s %d %d %lld %ld\n",
+        circuit->name,
+        circuit->state == CIRCUIT_CLOSED ? CIRCUIT_CLOSED : CIRCUIT_OPEN,
+        circuit->failures, (long long)circuit->open_until, circuit->cooldown);
+  }
+
+  if (used >= sizeof(text) ||
+      !ani_write_file_atomic(breaker->path, text, used)) {
+    LOG_WARN("Failed to save circuit breaker state");
+  }
+}
+
+ani_breaker *ani_breaker_new(const char *dir) {
+  ani_breaker *breaker;
+
+  breaker = ani_calloc(1, sizeof(*breaker));
+  if (breaker == NULL) {
+    return NULL;
+  }
+
+  ani_mutex_init(&breaker->lock);
+  breaker->retry_credit = RETRY_BURST * RETRY_COST;
+
+  if (dir != NULL) {
+    breaker->path = ani_path_join(dir, BREAKER_FILE);
+    if (breaker->path != NULL) {
+      load_state(breaker);
+    }
+  }
+
+  return breaker;
+}
+
+void ani_breaker_free(ani_breaker *breaker) {
+  if (breaker == NULL) {
+    return;
+  }
+
+  if (breaker->dirty) {
+    save_state(breaker);
+  }
+
+  ani_mutex_destroy(&breaker->lock);
+  ani_free(breaker->path);
+  ani_free(breaker);
+}
+
+// Open circuit for its current cooldown (lock held)
+static void trip(ani_circuit *circuit) {
+  circuit->state = CIRCUIT_OPEN;
+  circuit->open_until = time(NULL) + circuit->cooldown;
+
+  LOG_WARN("%s is failing: circuit open for %ld s", circuit->name,
+           circuit->cooldown);
+}
+
+bool ani_breaker_allow(ani_breaker *breaker, const char *provider) {
+  ani_circuit *circuit;
+  time_t now;
+  bool allowed;
+
+  if (breaker == NULL || provider == NULL) {
+    return true;
+  }
+
+  ani_mutex_lock(&breaker->lock);
+  // The budget alone is not worth a write now; it is saved on free
+  if (breaker->retry_credit < RETRY_BURST * RETRY_COST) {
+    breaker->retry_credit++;
+    breaker->dirty = true;
+  }
+
+  allowed = true;
+  circuit = find_circuit(breaker, provider);
+  now = time(NULL);
+  if (circuit != NULL && circuit->state == CIRCUIT_OPEN) {
+    if (now >= circuit->open_until) {
+      LOG_INFO("Probing %s after %ld s", provider, circuit->cooldown);
+      circuit->state = CIRCUIT_HALF_OPEN;
+      circuit->open_until = now; // When the probe went out
+      breaker->dirty = true;
+    } else {
+      allowed = false;
+    }
+  } else if (circuit != NULL && circuit->state == CIRCUIT_HALF_OPEN) {
+    // Only the probe goes out until it has an answer, unless it was
+    // cancelled and never reported back
+    if (now - circuit->open_until >= COOLDOWN_MIN) {
+      circuit->open_until = now;
+    } else {
+      allowed = false;
+    }
+  }
+  ani_mutex_unlock(&breaker->lock);
+
+  if (!allowed) {
+    LOG_DEBUG("Circuit open for %s, failing fast", provider);
+    ani_metrics_http_short_circuit(provider);
+  }
+
+  return allowed;
+}
+
+bool ani_breaker_retry(ani_breaker *breaker, const char *provider) {
+  ani_circuit *circuit;
+  bool allowed;
+
+  if (breaker == NULL || provider == NULL) {
+    return true;
+  }
+
+  ani_mutex_lock(&breaker->lock);
+  circuit = find_circuit(breaker, provider);
+  allowed = circuit == NULL || circuit->state == CIRCUIT_CLOSED;
+  if (allowed && breaker->retry_credit >= RETRY_COST) {
+    breaker->retry_credit -= RETRY_COST;
+    breaker->dirty = true;
+  } else if (allowed) {
+    LOG_WARN("Retry budget exhausted, not retrying %s", provider);
+    allowed = false;
+  }
+  ani_mutex_unlock(&breaker->lock);
+
+  return allowed;
+}
+
+void ani_breaker_record(ani_breaker *breaker, const char *provider, bool ok) {
+  ani_circuit *circuit;
+  ani_circuit_state before;
+
+  if (breaker == NULL || provider == NULL) {
+    return;
+  }
+
+  ani_mutex_lock(&breaker->lock);
+  circuit = find_circuit(breaker, provider);
+  if (circuit == NULL) {
+    ani_mutex_unlock(&breaker->lock);
+
+    return;
+  }
+
+  before = circuit->state;
+  if (ok) {
+    if (before != CIRCUIT_CLOSED) {
+      LOG_INFO("%s is answering again: circuit closed", provider);
+      circuit->open_until = time(NULL); // Newer than the trip when merged
+    }
+    circuit->state = CIRCUIT_CLOSED;
+    circuit->failures = 0;
+    circuit->cooldown = COOLDOWN_MIN;
+  } else {
+    circuit->failures++;
+    if (before == CIRCUIT_HALF_OPEN) {
+      circuit->cooldown = circuit->cooldown * 2 > COOLDOWN_MAX
+                              ? COOLDOWN_MAX
+                              : circuit->cooldown * 2;
+      trip(circuit);
+    } else if (before == CIRCUIT_CLOSED &&
+               circuit->failures >= FAILURE_THRESHOLD) {
+      trip(circuit);
+    }
+  }
+
+  // Other processes should learn about a trip or recovery right away; a
+  // failure count is saved on free, so short runs still add up to a trip
+  if (circuit->state != before) {
+    save_state(breaker);
+  } else {
+    breaker->dirty = true;
+  }
+  ani_mutex_unlock(&breaker->lock);
+}
+
+bool ani_breaker_is_open(ani_breaker *breaker, const char *provider) {
+  ani_circuit *circuit;
+  bool open;
+
+  if (breaker == NULL || provider == NULL) {
+    return false;
+  }
+
+  ani_mutex_lock(&breaker->lock);
+  circuit = find_circuit(breaker, provider);
+  open = circuit != NULL && circuit->state == CIRCUIT_OPEN &&
+         time(NULL) < circuit->open_until;
+  ani_mutex_unlock(&breaker->lock);
+
+  return open;
+}
@@ -5,16 +5,19 @@
  */
 
 #include "ani/http.h"
+#include "ani/alloc.h"
+#include "ani/breaker.h"
+#include "ani/limiter.h"
 #include "ani/log.h"
+#include "ani/metrics.h"
 #include "ani/str.h"
+#include "ani/thread.h"
+#include "ani/time.h"
+#include "ani/trace.h"
+#include "ani/transport.h"
 #include <curl/curl.h>
 #include <stdlib.h>
 #include <string.h>
-#ifdef _WIN32
-#include <windows.h>
-#else
-#include <unistd.h>
-#endif
 
 // Buffer for accumulating response data
 typedef struct {
@@ -39,7 +42,7 @@ static size_t write_callback(void *contents, size_t size, size_t nmemb,
       new_capacity = buf->size + realsize + 1;
     }
 
-    new_data = realloc(buf->data, new_capacity);
+    new_data = ani_realloc(buf->data, new_capacity);
     if (new_data == NULL) {
       LOG_ERROR("Failed to allocate memory for HTTP response");
 
@@ -57,9 +60,260 @@ static size_t write_callback(void *contents, size_t size, size_t nmemb,
   return realsize;
 }
 
-void ani_http_init(void) { curl_global_init(CURL_GLOBAL_DEFAULT); }
+// Cancel flag bound by a hedged request running on this thread, if any
+static ANI_THREAD_LOCAL const bool *bound_cancel = NULL;
+
+// Backoff sleeps are sliced so a cancelled request stops waiting promptly
+#define CANCEL_POLL_MS 50
+
+#if defined(__GNUC__) || defined(__clang__)
+#define CANCEL_LOAD(p) __atomic_load_n((p), __ATOMIC_RELAXED)
+#else
+#define CANCEL_LOAD(p) (*(volatile const bool *)(p))
+#endif
+
+static bool cancelled(void) {
+  return bound_cancel != NULL && CANCEL_LOAD(bound_cancel);
+}
+
+// Progress callback: a non-zero return aborts the transfer
+static int cancel_callback(void *userp, curl_off_t dltotal, curl_off_t dlnow,
+                           curl_off_t ultotal, curl_off_t ulnow) {
+  (void)userp;
+  (void)dltotal;
+  (void)dlnow;
+  (void)ultotal;
+  (void)ulnow;
+
+  return cancelled() ? 1 : 0;
+}
+
+// Sleep ms, returning early once the request is cancelled
+static void backoff_sleep(long ms) {
+  while (ms > 0 && !cancelled()) {
+    ani_sleep_ms(ms < CANCEL_POLL_MS ? ms : CANCEL_POLL_MS);
+    ms -= CANCEL_POLL_MS;
+  }
+}
+
+struct ani_http_client {
+  CURLSH *share;
+  ani_mutex locks[CURL_LOCK_DATA_LAST];
+};
+
+// Recorded request timings (only filled when enabled)
+static ani_mutex timings_lock;
+static bool timings_enabled = false;
+static ani_http_timing_record *timings_log = NULL;
+static size_t timings_count = 0;
+static size_t timings_capacity = 0;
+
+static void timings_log_free(void) {
+  size_t i;
+
+  for (i = 0; i < timings_count; i++) {
+    ani_free(timings_log[i].provider);
+    ani_free(timings_log[i].method);
+    ani_free(timings_log[i].url);
+  }
+  ani_free(timings_log);
+
+  timings_log = NULL;
+  timings_count = 0;
+  timings_capacity = 0;
+}
+
+static void timings_log_append(const char *provider, const char *method,
+                               const char *url,
+                               const ani_http_response *resp) {
+  ani_http_timing_record *rec;
+
+  ani_mutex_lock(&timings_lock);
+  if (timings_count == timings_capacity) {
+    size_t new_capacity = timings_capacity == 0 ? 8 : timings_capacity * 2;
+    ani_http_timing_record *new_log =
+        ani_realloc(timings_log, new_capacity * sizeof(*new_log));
+    if (new_log == NULL) {
+      ani_mutex_unlock(&timings_lock);
+
+      return;
+    }
+
+    timings_log = new_log;
+    timings_capacity = new_capacity;
+  }
+
+  rec = &timings_log[timings_count++];
+  rec->provider = ani_strdup(provider != NULL ? provider : "unknown");
+  rec->method = ani_strdup(method);
+  rec->url = ani_strdup(url);
+  rec->status_code = resp->status_code;
+  rec->timings = resp->timings;
+  ani_mutex_unlock(&timings_lock);
+}
+
+// Convert a curl microsecond timer to milliseconds
+static double curl_time_ms(CURL *curl, CURLINFO info) {
+  curl_off_t us;
+
+  us = 0;
+  if (curl_easy_getinfo(curl, info, &us) != CURLE_OK) {
+    return 0.0;
+  }
+
+  return (double)us / 1000.0;
+}
+
+static void collect_timings(CURL *curl, int retries, ani_http_timings *out) {
+  curl_off_t downloaded;
+  long num_connects;
+
+  out->namelookup_ms = curl_time_ms(curl, CURLINFO_NAMELOOKUP_TIME_T);
+  out->connect_ms = curl_time_ms(curl, CURLINFO_CONNECT_TIME_T);
+  out->appconnect_ms = curl_time_ms(curl, CURLINFO_APPCONNECT_TIME_T);
+  out->pretransfer_ms = curl_time_ms(curl, CURLINFO_PRETRANSFER_TIME_T);
+  out->starttransfer_ms = curl_time_ms(curl, CURLINFO_STARTTRANSFER_TIME_T);
+  out->total_ms = curl_time_ms(curl, CURLINFO_TOTAL_TIME_T);
+
+  downloaded = 0;
+  curl_easy_getinfo(curl, CURLINFO_SIZE_DOWNLOAD_T, &downloaded);
+  out->bytes_downloaded = downloaded > 0 ? (size_t)downloaded : 0;
+
+  // No new connections means the request went over a reused one
+  num_connects = 0;
+  curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &num_connects);
+  out->reused_connection = num_connects == 0;
+
+  out->retries = retries;
+}
+
+// libcurl allocation hooks; they follow whatever ani_set_allocator installed
+static void *curl_alloc_malloc(size_t size) { return ani_malloc(size); }
+
+static void curl_alloc_free(void *ptr) { ani_free(ptr); }
+
+static void *curl_alloc_realloc(void *ptr, size_t size) {
+  return ani_realloc(ptr, size);
+}
+
+static char *curl_alloc_strdup(const char *str) { return ani_strdup(str); }
+
+static void *curl_alloc_calloc(size_t nmemb, size_t size) {
+  return ani_calloc(nmemb, size);
+}
+
+void ani_http_init(void) {
+  curl_global_init_mem(CURL_GLOBAL_DEFAULT, curl_alloc_malloc, curl_alloc_free,
+                       curl_alloc_realloc, curl_alloc_strdup,
+                       curl_alloc_calloc);
+  ani_mutex_init(&timings_lock);
+  ani_transport_init();
+}
+
+void ani_http_cleanup(void) {
+  timings_log_free();
+  ani_mutex_destroy(&timings_lock);
+  ani_transport_cleanup();
+  curl_global_cleanup();
+}
+
+static void share_lock(CURL *handle, curl_lock_data data,
+                       curl_lock_access access, void *userptr) {
+  ani_http_client *client = userptr;
+
+  (void)handle;
+  (void)access;
+  ani_mutex_lock(&client->locks[data]);
+}
+
+static void share_unlock(CURL *handle, curl_lock_data data, void *userptr) {
+  ani_http_client *client = userptr;
+
+  (void)handle;
+  ani_mutex_unlock(&client->locks[data]);
+}
+
+ani_http_client *ani_http_client_new(void) {
+  ani_http_client *client;
+  int i;
+
+  client = ani_calloc(1, sizeof(*client));
+  if (client == NULL) {
+    return NULL;
+  }
+
+  client->share = curl_share_init();
+  if (client->share == NULL) {
+    ani_free(client);
+
+    return NULL;
+  }
+
+  for (i = 0; i < CURL_LOCK_DATA_LAST; i++) {
+    ani_mutex_init(&client->locks[i]);
+  }
+
+  curl_share_setopt(client->share, CURLSHOPT_LOCKFUNC, share_lock);
+  curl_share_setopt(client->share, CURLSHOPT_UNLOCKFUNC, share_unlock);
+  curl_share_setopt(client->share, CURLSHOPT_USERDATA, client);
+  curl_share_setopt(client->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+  curl_share_setopt(client->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+#if LIBCURL_VERSION_NUM >= 0x073900
+  // Connection cache sharing needs curl 7.57.0
+  curl_share_setopt(client->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+#endif
+
+  return client;
+}
+
+void ani_http_client_free(ani_http_client *client) {
+  int i;
+
+  if (client == NULL) {
+    return;
+  }
+
+  curl_share_cleanup(client->share);
+  for (i = 0; i < CURL_LOCK_DATA_LAST; i++) {
+    ani_mutex_destroy(&client->locks[i]);
+  }
+  ani_free(client);
+}
+
+const bool *ani_http_bind_cancel(const bool *cancel) {
+  const bool *prev = bound_cancel;
 
-void ani_http_cleanup(void) { curl_global_cleanup(); }
+  bound_cancel = cancel;
+
+  return prev;
+}
+
+void ani_http_timings_enable(bool enable) { timings_enabled = enable; }
+
+bool ani_http_timings_enabled(void) { return timings_enabled; }
+
+size_t ani_http_timings_count(void) {
+  size_t count;
+
+  ani_mutex_lock(&timings_lock);
+  count = timings_count;
+  ani_mutex_unlock(&timings_lock);
+
+  return count;
+}
+
+bool ani_http_timings_get(size_t index, ani_http_timing_record *out) {
+  bool found;
+
+  ani_mutex_lock(&timings_lock);
+  found = index < timings_count;
+  if (found) {
+    *out = timings_log[index];
+  }
+  ani_mutex_unlock(&timings_lock);
+
+  return found;
+}
 
 ani_http_config ani_http_default_config(void) {
   ani_http_config config;
@@ -69,55 +323,67 @@ ani_http_config ani_http_default_config(void) {
   config.max_retries = 3;
   config.user_agent = "ani/0.1.0 (https://github.com/DannyBimma/ani)";
   config.verify_ssl = true;
+  config.provider = NULL;
+  config.client = NULL;
+  config.limiter = NULL;
+  config.breaker = NULL;
 
   return config;
 }
 
-static ani_http_response *
-ani_http_request_internal(const char *url,
-                          const char *method __attribute__((unused)),
-                          const char *post_body, const char *content_type,
-                          const ani_http_config *config) {
+// Perform the request over the network, with retries
+static ani_http_response *http_perform_live(const char *url,
+                                            const char *post_body,
+                                            const char *content_type,
+                                            const ani_http_config *config) {
   CURL *curl;
   CURLcode res;
   ani_http_buffer buf;
+  ani_http_buffer header_buf;
   ani_http_response *resp;
   int retry;
+  int attempts;
   struct curl_slist *headers;
   long retry_after;
 
-  if (url == NULL) {
+  // Fail fast while the provider is known to be down
+  if (!ani_breaker_allow(config->breaker, config->provider)) {
     return NULL;
   }
 
-  // Use default config if not provided
-  if (config == NULL) {
-    static ani_http_config default_config;
-    default_config = ani_http_default_config();
-    config = &default_config;
-  }
-
-  // Init response buffer
+  // Init response buffers
   buf.capacity = 4096;
-  buf.data = malloc(buf.capacity);
+  buf.data = ani_malloc(buf.capacity);
   buf.size = 0;
   if (buf.data == NULL) {
     return NULL;
   }
   buf.data[0] = '\0';
 
+  header_buf.capacity = 1024;
+  header_buf.data = ani_malloc(header_buf.capacity);
+  header_buf.size = 0;
+  if (header_buf.data == NULL) {
+    ani_free(buf.data);
+
+    return NULL;
+  }
+  header_buf.data[0] = '\0';
+
   // Create response structure
-  resp = calloc(1, sizeof(*resp));
+  resp = ani_calloc(1, sizeof(*resp));
   if (resp == NULL) {
-    free(buf.data);
+    ani_free(buf.data);
+    ani_free(header_buf.data);
 
     return NULL;
   }
 
   curl = curl_easy_init();
   if (curl == NULL) {
-    free(buf.data);
-    free(resp);
+    ani_free(buf.data);
+    ani_free(header_buf.data);
+    ani_free(resp);
 
     return NULL;
   }
@@ -125,6 +391,14 @@ ani_http_request_internal(const char *url,
   // Set URL
   curl_easy_setopt(curl, CURLOPT_URL, url);
 
+  // Reuse pooled connections, DNS and TLS sessions
+  if (config->client != NULL) {
+    curl_easy_setopt(curl, CURLOPT_SHARE, config->client->share);
+  }
+
+  // No signals: timeouts must not longjmp across threads
+  curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+
   // Set time-outs
   curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, config->connect_timeout_ms);
   curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, config->timeout_ms);
@@ -145,9 +419,17 @@ ani_http_request_internal(const char *url,
   curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
   curl_easy_setopt(curl, CURLOPT_MAXREDIRS, 5L);
 
-  // Set write callback
+  // Hedged requests abort as soon as another answer wins
+  if (bound_cancel != NULL) {
+    curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, cancel_callback);
+    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+  }
+
+  // Set write callbacks (headers use the same accumulator)
   curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
   curl_easy_setopt(curl, CURLOPT_WRITEDATA, &buf);
+  curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, write_callback);
+  curl_easy_setopt(curl, CURLOPT_HEADERDATA, &header_buf);
 
   // Set method and body for POST
   headers = NULL;
@@ -164,49 +446,65 @@ ani_http_request_internal(const char *url,
   }
 
   // Retry loop
+  attempts = 0;
   for (retry = 0; retry <= config->max_retries; retry++) {
     if (retry > 0) {
+      if (cancelled()) {
+        LOG_DEBUG("Request cancelled: %s", url);
+        break;
+      }
+      if (!ani_breaker_retry(config->breaker, config->provider)) {
+        break;
+      }
+
       LOG_DEBUG("Retrying request (attempt %d/%d): %s", retry + 1,
                 config->max_retries + 1, url);
-      // Exponential backoff (cross-platform)
-#ifdef _WIN32
-      Sleep((DWORD)(1000U * (1U << (retry - 1))));
-#else
-      sleep((unsigned int)(1U << (retry - 1)));
-#endif
+      // Exponential backoff
+      backoff_sleep(1000L << (retry - 1));
     }
 
-    // Reset buffer for retry
+    // Reset buffers for retry
     buf.size = 0;
     buf.data[0] = '\0';
+    header_buf.size = 0;
+    header_buf.data[0] = '\0';
 
     // Perform request
+    ani_limiter_acquire(config->limiter, config->provider);
     res = curl_easy_perform(curl);
+    attempts++;
 
     if (res != CURLE_OK) {
       LOG_ERROR("curl_easy_perform() failed: %s", curl_easy_strerror(res));
+      ani_free(resp->error);
       resp->error = ani_strdup(curl_easy_strerror(res));
+
+      // A hedge cancelling its loser says nothing about the provider
+      if (res != CURLE_ABORTED_BY_CALLBACK) {
+        ani_breaker_record(config->breaker, config->provider, false);
+      }
       continue; // Retry
     }
 
-    // Get status code
+    // Get status code; a 429 still means the provider is up
     curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &resp->status_code);
+    ani_breaker_record(config->breaker, config->provider,
+                       resp->status_code < 500);
 
     LOG_DEBUG("HTTP %ld %s", resp->status_code, url);
 
     // Check for rate limit (429) or server error (5xx)
     if (resp->status_code == 429 || resp->status_code >= 500) {
+      if (resp->status_code == 429) {
+        ani_metrics_http_rate_limited(config->provider);
+      }
+
       // Check for Retry-After header
       retry_after = 0;
       curl_easy_getinfo(curl, CURLINFO_RETRY_AFTER, &retry_after);
       if (retry_after > 0 && retry_after < 60) {
         LOG_WARN("Rate limited, waiting %ld seconds", retry_after);
-        // Cross-platform sleep
-#ifdef _WIN32
-        Sleep((DWORD)(retry_after * 1000));
-#else
-        sleep((unsigned int)retry_after);
-#endif
+        backoff_sleep(retry_after * 1000);
       }
 
       if (retry < config->max_retries) {
@@ -219,15 +517,79 @@ ani_http_request_internal(const char *url,
     break;
   }
 
+  // Timing breakdown of the final attempt; the loop can also end before a
+  // retry goes out (cancelled, or refused by the retry budget)
+  collect_timings(curl, attempts > 0 ? attempts - 1 : 0, &resp->timings);
+
   // Cleanup
   if (headers != NULL) {
     curl_slist_free_all(headers);
   }
   curl_easy_cleanup(curl);
 
-  // Set response body
+  // Set response body and headers
   resp->body = buf.data;
   resp->body_len = buf.size;
+  resp->headers = header_buf.data;
+  resp->headers_len = header_buf.size;
+
+  return resp;
+}
+
+static ani_http_response *
+ani_http_request_internal(const char *url, const char *method,
+                          const char *post_body, const char *content_type,
+                          const ani_http_config *config) {
+  ani_http_response *resp;
+  ani_http_config default_config;
+  ani_trace_span span;
+  int64_t start_us;
+
+  if (url == NULL) {
+    return NULL;
+  }
+
+  // Use default config if not provided
+  if (config == NULL) {
+    default_config = ani_http_default_config();
+    config = &default_config;
+  }
+
+  ANI_TRACE_BEGIN(span, "http.request", "net");
+  ANI_TRACE_DETAIL(span, url);
+  start_us = ani_monotonic_us();
+
+  // Serve from recordings, or go to the network (recording if asked)
+  if (ani_transport_get_mode() == ANI_TRANSPORT_REPLAY) {
+    resp = ani_transport_replay(method, url, post_body);
+  } else {
+    resp = http_perform_live(url, post_body, content_type, config);
+    if (resp != NULL && ani_transport_get_mode() == ANI_TRANSPORT_RECORD) {
+      ani_transport_record(method, url, post_body, resp);
+    }
+  }
+
+  if (resp == NULL) {
+    ANI_TRACE_END(span);
+
+    return NULL;
+  }
+
+  LOG_DEBUG("HTTP timings %s: dns %.1f connect %.1f tls %.1f ttfb %.1f total "
+            "%.1f ms, %zu bytes",
+            url, resp->timings.namelookup_ms, resp->timings.connect_ms,
+            resp->timings.appconnect_ms, resp->timings.starttransfer_ms,
+            resp->timings.total_ms, resp->timings.bytes_downloaded);
+
+  if (timings_enabled) {
+    timings_log_append(config->provider, method, url, resp);
+  }
+
+  ani_metrics_http_request(config->provider, resp->status_code,
+                           resp->timings.retries,
+                           (double)(ani_monotonic_us() - start_us) / 1e6);
+
+  ANI_TRACE_END(span);
 
   return resp;
 }
@@ -248,7 +610,8 @@ void ani_http_response_free(ani_http_response *resp) {
     return;
   }
 
-  free(resp->body);
-  free(resp->error);
-  free(resp);
+  ani_free(resp->body);
+  ani_free(resp->headers);
+  ani_free(resp->error);
+  ani_free(resp);
 }
@@ -0,0 +1,133 @@
+/*
+ * Routine: ani — Anime/Manga scheduling information CLI
+ * Author: DannyBimma
+ * Copyright: (c) 2025 Technomancer Pirate Captain. All Rights Reserved.
+ */
+
+#include "ani/limiter.h"
+#include "ani/alloc.h"
+#include "ani/log.h"
+#include "ani/str.h"
+#include "ani/thread.h"
+#include "ani/time.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_BUCKETS 8
+
+typedef struct {
+  char name[32];
+  double per_second;
+  double burst;
+  double tokens; // May go negative: callers reserve tokens before sleeping
+  int64_t last_us;
+} ani_bucket;
+
+struct ani_limiter {
+  ani_mutex lock;
+  ani_bucket buckets[MAX_BUCKETS];
+  size_t count;
+};
+
+ani_limiter *ani_limiter_new(void) {
+  ani_limiter *limiter;
+
+  limiter = ani_calloc(1, sizeof(*limiter));
+  if (limiter == NULL) {
+    return NULL;
+  }
+  ani_mutex_init(&limiter->lock);
+
+  // Published API limits
+  ani_limiter_set_rate(limiter, "jikan", 3.0, 3.0);
+  ani_limiter_set_rate(limiter, "anilist", 1.5, 5.0);
+  ani_limiter_set_rate(limiter, "mangadex", 5.0, 5.0);
+
+  return limiter;
+}
+
+void ani_limiter_free(ani_limiter *limiter) {
+  if (limiter == NULL) {
+    return;
+  }
+
+  ani_mutex_destroy(&limiter->lock);
+  ani_free(limiter);
+}
+
+static ani_bucket *find_bucket(ani_limiter *limiter, const char *provider) {
+  size_t i;
+
+  for (i = 0; i < limiter->count; i++) {
+    if (strcmp(limiter->buckets[i].name, provider) == 0) {
+      return &limiter->buckets[i];
+    }
+  }
+
+  return NULL;
+}
+
+bool ani_limiter_set_rate(ani_limiter *limiter, const char *provider,
+                          double per_second, double burst) {
+  ani_bucket *bucket;
+
+  if (limiter == NULL || provider == NULL) {
+    return false;
+  }
+
+  ani_mutex_lock(&limiter->lock);
+  bucket = find_bucket(limiter, provider);
+  if (bucket == NULL) {
+    if (limiter->count == MAX_BUCKETS) {
+      ani_mutex_unlock(&limiter->lock);
+
+      return false;
+    }
+    bucket = &limiter->buckets[limiter->count++];
+    ani_strlcpy(bucket->name, provider, sizeof(bucket->name));
+  }
+
+  bucket->per_second = per_second;
+  bucket->burst = burst >= 1.0 ? burst : 1.0;
+  bucket->tokens = bucket->burst;
+  bucket->last_us = ani_monotonic_us();
+  ani_mutex_unlock(&limiter->lock);
+
+  return true;
+}
+
+void ani_limiter_acquire(ani_limiter *limiter, const char *provider) {
+  ani_bucket *bucket;
+  int64_t now_us;
+  long wait_ms;
+
+  if (limiter == NULL || provider == NULL) {
+    return;
+  }
+
+  wait_ms = 0;
+  ani_mutex_lock(&limiter->lock);
+  bucket = find_bucket(limiter, provider);
+  if (bucket != NULL && bucket->per_second > 0.0) {
+    // Refill, then take a token; a deficit is how long this caller waits
+    now_us = ani_monotonic_us();
+    bucket->tokens +=
+        (double)(now_us - bucket->last_us) / 1e6 * bucket->per_second;
+    if (bucket->tokens > bucket->burst) {
+      bucket->tokens = bucket->burst;
+    }
+    bucket->last_us = now_us;
+
+    bucket->tokens -= 1.0;
+    if (bucket->tokens < 0.0) {
+      wait_ms = (long)(-bucket->tokens / bucket->per_second * 1000.0 + 0.5);
+    }
+  }
+  ani_mutex_unlock(&limiter->lock);
+
+  if (wait_ms > 0) {
+    LOG_DEBUG("Rate limiting %s: waiting %ld ms", provider, wait_ms);
+    ani_sleep_ms(wait_ms);
+  }
+}
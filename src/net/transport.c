@@ -0,0 +1,335 @@
+/*
+ * Routine: ani — Anime/Manga scheduling information CLI
+ * Author: DannyBimma
+ * Copyright: (c) 2025 Technomancer Pirate Captain. All Rights Reserved.
+ */
+
+#include "ani/transport.h"
+#include "ani/alloc.h"
+#include "ani/fs.h"
+#include "ani/json.h"
+#include "ani/log.h"
+#include "ani/str.h"
+#include "ani/thread.h"
+#include "ani/time.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <yyjson.h>
+
+static ani_transport_mode mode = ANI_TRANSPORT_LIVE;
+static char *transport_dir = NULL;
+static long replay_latency_ms = 0;
+static bool replay_latency_recorded = false;
+static long replay_jitter_ms = 0;
+static uint64_t jitter_state = 1;
+static ani_mutex jitter_lock;
+
+void ani_transport_init(void) {
+  const char *record_dir;
+  const char *replay_dir;
+  const char *val;
+
+  record_dir = getenv("ANI_HTTP_RECORD");
+  replay_dir = getenv("ANI_HTTP_REPLAY");
+
+  // Replay wins: it is the mode that must never touch the network
+  if (replay_dir != NULL && replay_dir[0] != '\0') {
+    mode = ANI_TRANSPORT_REPLAY;
+    transport_dir = ani_strdup(replay_dir);
+  } else if (record_dir != NULL && record_dir[0] != '\0') {
+    if (!ani_mkdir_p(record_dir)) {
+      LOG_WARN("Failed to create record directory: %s", record_dir);
+
+      return;
+    }
+    mode = ANI_TRANSPORT_RECORD;
+    transport_dir = ani_strdup(record_dir);
+  } else {
+    return;
+  }
+  ani_mutex_init(&jitter_lock);
+
+  val = getenv("ANI_HTTP_REPLAY_LATENCY");
+  if (val != NULL) {
+    if (strcmp(val, "recorded") == 0) {
+      replay_latency_recorded = true;
+    } else {
+      replay_latency_ms = atol(val);
+    }
+  }
+
+  val = getenv("ANI_HTTP_REPLAY_JITTER");
+  if (val != NULL) {
+    replay_jitter_ms = atol(val);
+  }
+
+  val = getenv("ANI_HTTP_REPLAY_SEED");
+  if (val != NULL && atol(val) != 0) {
+    jitter_state = (uint64_t)atol(val);
+  }
+
+  LOG_INFO("HTTP transport: %s %s",
+           mode == ANI_TRANSPORT_REPLAY ? "replaying from" : "recording to",
+           transport_dir);
+}
+
+void ani_transport_cleanup(void) {
+  if (mode != ANI_TRANSPORT_LIVE) {
+    ani_mutex_destroy(&jitter_lock);
+  }
+  ani_free(transport_dir);
+  transport_dir = NULL;
+  mode = ANI_TRANSPORT_LIVE;
+}
+
+ani_transport_mode ani_transport_get_mode(void) { return mode; }
+
+void ani_transport_key(const char *method, const char *url, const char *body,
+                       char *buf, size_t size) {
+  const char *parts[3];
+  uint64_t hash;
+  size_t i;
+
+  // FNV-1a over method, URL and body, separated by newlines
+  parts[0] = method != NULL ? method : "GET";
+  parts[1] = url != NULL ? url : "";
+  parts[2] = body != NULL ? body : "";
+
+  hash = 0xcbf29ce484222325ULL;
+  for (i = 0; i < 3; i++) {
+    const unsigned char *p = (const unsigned char *)parts[i];
+    for (; *p != '\0'; p++) {
+      hash ^= *p;
+      hash *= 0x100000001b3ULL;
+    }
+    hash ^= '\n';
+    hash *= 0x100000001b3ULL;
+  }
+
+  snprintf(buf, size, "%016llx.json", (unsigned long long)hash);
+}
+
+static char *recording_path(const char *method, const char *url,
+                            const char *body) {
+  char name[32];
+
+  ani_transport_key(method, url, body, name, sizeof(name));
+
+  return ani_path_join(transport_dir, name);
+}
+
+bool ani_transport_record(const char *method, const char *url,
+                          const char *body, const ani_http_response *resp) {
+  yyjson_mut_doc *doc;
+  yyjson_mut_val *root;
+  yyjson_mut_val *timings;
+  yyjson_write_err werr;
+  char *path;
+  char *json;
+  size_t json_len;
+  bool ok;
+
+  if (mode != ANI_TRANSPORT_RECORD || resp == NULL) {
+    return false;
+  }
+
+  doc = yyjson_mut_doc_new(ani_json_alc());
+  if (doc == NULL) {
+    return false;
+  }
+  root = yyjson_mut_obj(doc);
+  yyjson_mut_doc_set_root(doc, root);
+
+  yyjson_mut_obj_add_str(doc, root, "method", method);
+  yyjson_mut_obj_add_str(doc, root, "url", url);
+  if (body != NULL) {
+    yyjson_mut_obj_add_str(doc, root, "request_body", body);
+  } else {
+    yyjson_mut_obj_add_null(doc, root, "request_body");
+  }
+  yyjson_mut_obj_add_int(doc, root, "status", resp->status_code);
+  yyjson_mut_obj_add_strn(doc, root, "headers",
+                          resp->headers != NULL ? resp->headers : "",
+                          resp->headers_len);
+  yyjson_mut_obj_add_strn(doc, root, "body",
+                          resp->body != NULL ? resp->body : "",
+                          resp->body_len);
+  if (resp->error != NULL) {
+    yyjson_mut_obj_add_str(doc, root, "error", resp->error);
+  }
+
+  timings = yyjson_mut_obj(doc);
+  yyjson_mut_obj_add_real(doc, timings, "namelookup_ms",
+                          resp->timings.namelookup_ms);
+  yyjson_mut_obj_add_real(doc, timings, "connect_ms", resp->timings.connect_ms);
+  yyjson_mut_obj_add_real(doc, timings, "appconnect_ms",
+                          resp->timings.appconnect_ms);
+  yyjson_mut_obj_add_real(doc, timings, "pretransfer_ms",
+                          resp->timings.pretransfer_ms);
+  yyjson_mut_obj_add_real(doc, timings, "starttransfer_ms",
+                          resp->timings.starttransfer_ms);
+  yyjson_mut_obj_add_real(doc, timings, "total_ms", resp->timings.total_ms);
+  yyjson_mut_obj_add_uint(doc, timings, "bytes",
+                          resp->timings.bytes_downloaded);
+  yyjson_mut_obj_add_int(doc, timings, "retries", resp->timings.retries);
+  yyjson_mut_obj_add(root, yyjson_mut_str(doc, "timings"), timings);
+
+  json_len = 0;
+  json = yyjson_mut_write_opts(doc, YYJSON_WRITE_PRETTY, ani_json_alc(),
+                               &json_len, &werr);
+  yyjson_mut_doc_free(doc);
+  if (json == NULL) {
+    return false;
+  }
+
+  ok = false;
+  path = recording_path(method, url, body);
+  if (path != NULL) {
+    ok = ani_write_file_atomic(path, json, json_len);
+    if (ok) {
+      LOG_DEBUG("Recorded %s %s -> %s", method, url, path);
+    } else {
+      LOG_WARN("Failed to record %s %s", method, url);
+    }
+  }
+
+  ani_free(path);
+  ani_free(json);
+  return ok;
+}
+
+// Deterministic xorshift64 for jitter (shared by all replaying threads)
+static long next_jitter(long range) {
+  uint64_t x;
+
+  if (range <= 0) {
+    return 0;
+  }
+
+  ani_mutex_lock(&jitter_lock);
+  jitter_state ^= jitter_state << 13;
+  jitter_state ^= jitter_state >> 7;
+  jitter_state ^= jitter_state << 17;
+  x = jitter_state;
+  ani_mutex_unlock(&jitter_lock);
+
+  return (long)(x % (uint64_t)(2 * range + 1)) - range;
+}
+
+static double object_get_real(yyjson_val *obj, const char *key) {
+  yyjson_val *val = yyjson_obj_get(obj, key);
+
+  return yyjson_is_num(val) ? yyjson_get_num(val) : 0.0;
+}
+
+static char *dup_json_str(yyjson_val *val, size_t *len_out) {
+  const char *str;
+  size_t len;
+  char *copy;
+
+  str = yyjson_is_str(val) ? yyjson_get_str(val) : "";
+  len = yyjson_is_str(val) ? yyjson_get_len(val) : 0;
+
+  copy = ani_malloc(len + 1);
+  if (copy == NULL) {
+    return NULL;
+  }
+  memcpy(copy, str, len);
+  copy[len] = '\0';
+
+  if (len_out != NULL) {
+    *len_out = len;
+  }
+
+  return copy;
+}
+
+ani_http_response *ani_transport_replay(const char *method, const char *url,
+                                        const char *body) {
+  ani_http_response *resp;
+  yyjson_doc *doc;
+  yyjson_val *root;
+  yyjson_val *timings;
+  yyjson_val *val;
+  char *path;
+  char *data;
+  size_t data_len;
+  long delay_ms;
+
+  resp = ani_calloc(1, sizeof(*resp));
+  if (resp == NULL) {
+    return NULL;
+  }
+
+  path = recording_path(method, url, body);
+  data = path != NULL ? ani_read_file(path, &data_len) : NULL;
+  if (data == NULL) {
+    LOG_WARN("No recording for %s %s (%s)", method, url,
+             path != NULL ? path : "?");
+    ani_free(path);
+    resp->error = ani_strdup("no recording for request");
+    resp->body = ani_strdup("");
+
+    return resp;
+  }
+  ani_free(path);
+
+  doc = yyjson_read_opts(data, data_len, 0, ani_json_alc(), NULL);
+  ani_free(data);
+  root = doc != NULL ? yyjson_doc_get_root(doc) : NULL;
+  if (!yyjson_is_obj(root)) {
+    LOG_WARN("Corrupt recording for %s %s", method, url);
+    yyjson_doc_free(doc);
+    resp->error = ani_strdup("corrupt recording");
+    resp->body = ani_strdup("");
+
+    return resp;
+  }
+
+  val = yyjson_obj_get(root, "status");
+  resp->status_code = yyjson_is_int(val) ? (long)yyjson_get_sint(val) : 0;
+  resp->body = dup_json_str(yyjson_obj_get(root, "body"), &resp->body_len);
+  resp->headers =
+      dup_json_str(yyjson_obj_get(root, "headers"), &resp->headers_len);
+  val = yyjson_obj_get(root, "error");
+  if (yyjson_is_str(val)) {
+    resp->error = ani_strdup(yyjson_get_str(val));
+  }
+
+  timings = yyjson_obj_get(root, "timings");
+  if (yyjson_is_obj(timings)) {
+    resp->timings.namelookup_ms = object_get_real(timings, "namelookup_ms");
+    resp->timings.connect_ms = object_get_real(timings, "connect_ms");
+    resp->timings.appconnect_ms = object_get_real(timings, "appconnect_ms");
+    resp->timings.pretransfer_ms = object_get_real(timings, "pretransfer_ms");
+    resp->timings.starttransfer_ms =
+        object_get_real(timings, "starttransfer_ms");
+    resp->timings.total_ms = object_get_real(timings, "total_ms");
+    resp->timings.bytes_downloaded =
+        (size_t)object_get_real(timings, "bytes");
+    resp->timings.retries = (int)object_get_real(timings, "retries");
+  }
+  yyjson_doc_free(doc);
+
+  // A replayed response never opens a connection
+  resp->timings.reused_connection = true;
+
+  // Simulated latency
+  delay_ms = replay_latency_recorded ? (long)resp->timings.total_ms
+                                     : replay_latency_ms;
+  delay_ms += next_jitter(replay_jitter_ms);
+  ani_sleep_ms(delay_ms);
+
+  LOG_DEBUG("Replayed HTTP %ld %s (%ld ms simulated)", resp->status_code, url,
+            delay_ms > 0 ? delay_ms : 0);
+
+  if (resp->body == NULL || resp->headers == NULL) {
+    ani_http_response_free(resp);
+
+    return NULL;
+  }
+
+  return resp;
+}
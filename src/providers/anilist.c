@@ -5,27 +5,114 @@
  */
 
 #include "ani/providers/anilist.h"
+#include "ani/alloc.h"
+#include "ani/cache.h"
+#include "ani/ctx.h"
 #include "ani/http.h"
 #include "ani/json.h"
 #include "ani/log.h"
 #include "ani/str.h"
+#include "ani/trace.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #define ANILIST_GRAPHQL_URL "https://graphql.anilist.co"
+#define ANILIST_GRAPHQL_URL_ENV "ANI_ANILIST_URL"
+#define ANILIST_BATCH_MAX 50 // Largest page AniList serves
+#define ANILIST_CALENDAR_PAGES 40 // 2000 episodes, beyond any fortnight
 
-bool ani_anilist_get_next_episode(const char *mal_id, ani_series *series) {
+// Schedule selection shared by every Media query: the next episode, which
+// also numbers the latest one. Media.airingSchedule cannot be sorted or
+// paged to an episode not yet known, so the latest episode's date is not
+// asked for.
+#define ANILIST_SCHEDULE_FIELDS                                                \
+  "episodes status nextAiringEpisode{ episode airingAt } "
+
+// Everything parse_media reads
+#define MEDIA_DETAIL_FIELDS                                                    \
+  "id idMal startDate{ year month day } "                                      \
+  "title{ romaji english native } " ANILIST_SCHEDULE_FIELDS
+
+// GraphQL endpoint, overridable for local stubs and benchmarks
+static const char *anilist_graphql_url(void) {
+  const char *url = getenv(ANILIST_GRAPHQL_URL_ENV);
+
+  return url != NULL && url[0] != '\0' ? url : ANILIST_GRAPHQL_URL;
+}
+
+// Fill the next episode from a Media object's nextAiringEpisode
+static bool parse_next_airing(ani_json_val *media, ani_series *series) {
+  ani_json_val *next_airing;
+  ani_json_val *val;
+
+  next_airing = ani_json_object_get(media, "nextAiringEpisode");
+  if (next_airing == NULL || !ani_json_is_object(next_airing)) {
+    return false;
+  }
+
+  // Get episode number
+  val = ani_json_object_get(next_airing, "episode");
+  if (val != NULL) {
+    series->release.next_number = (int)ani_json_get_int(val);
+  }
+
+  // Get airing timestamp (Unix seconds)
+  val = ani_json_object_get(next_airing, "airingAt");
+  if (val != NULL) {
+    ani_parse_unix_timestamp(ani_json_get_int(val),
+                             &series->release.next_date);
+  }
+
+  // Set source metadata
+  series->release.next_source = ANI_SOURCE_AGGREGATED_API;
+  series->release.next_confidence = ANI_CONFIDENCE_OFFICIAL;
+  series->release.provider_name = "AniList";
+
+  LOG_INFO("Found next episode: Ep %d via AniList",
+           series->release.next_number);
+  return true;
+}
+
+// Fill the latest aired episode number from the same Media object: the one
+// before nextAiringEpisode, or the last once finished. Its date is unknown,
+// so the premiere date is dropped rather than shown against this episode.
+static void parse_latest_aired(ani_json_val *media, ani_series *series) {
+  ani_json_val *next_airing;
+  const char *status;
+  long number;
+
+  next_airing = ani_json_object_get(media, "nextAiringEpisode");
+  status = ani_json_object_get_string(media, "status");
+  if (ani_json_is_object(next_airing)) {
+    number = ani_json_object_get_int(next_airing, "episode", 0) - 1;
+  } else if (status != NULL && strcmp(status, "FINISHED") == 0) {
+    number = ani_json_object_get_int(media, "episodes", -1);
+  } else {
+    number = -1;
+  }
+
+  if (number <= 0) {
+    return;
+  }
+
+  series->release.latest_number = (int)number;
+  memset(&series->release.latest_date, 0,
+         sizeof(series->release.latest_date));
+
+  LOG_DEBUG("Latest aired episode: Ep %ld", number);
+}
+
+bool ani_anilist_get_next_episode(ani_ctx *ctx, const char *mal_id,
+                                  ani_series *series) {
   char query_body[1024];
+  ani_http_config config;
   ani_http_response *resp;
+  ani_trace_span span;
   ani_json_doc *doc;
   ani_json_val *root;
   ani_json_val *data;
   ani_json_val *media;
-  ani_json_val *next_airing;
-  ani_json_val *val;
-  long airing_at;
-  long episode_num;
   bool success;
 
   if (mal_id == NULL || series == NULL) {
@@ -37,10 +124,7 @@ bool ani_anilist_get_next_episode(const char *mal_id, ani_series *series) {
            "{"
            "\"query\": \"query($idMal:Int!){ "
            "Media(idMal:$idMal,type:ANIME){ "
-           "id idMal "
-           "nextAiringEpisode{ episode airingAt timeUntilAiring } "
-           "title{ romaji english native } "
-           "} }\","
+           "id idMal " ANILIST_SCHEDULE_FIELDS "} }\","
            "\"variables\": {\"idMal\": %s}"
            "}",
            mal_id);
@@ -48,8 +132,9 @@ bool ani_anilist_get_next_episode(const char *mal_id, ani_series *series) {
   LOG_DEBUG("AniList GraphQL query for MAL ID: %s", mal_id);
 
   // Make HTTP POST request
-  resp =
-      ani_http_post(ANILIST_GRAPHQL_URL, query_body, "application/json", NULL);
+  config = ani_ctx_http_config(ctx, "anilist");
+  resp = ani_http_post(anilist_graphql_url(), query_body, "application/json",
+                       &config);
   if (resp == NULL || resp->status_code != 200) {
     LOG_WARN("AniList query failed: HTTP %ld", resp ? resp->status_code : 0);
     ani_http_response_free(resp);
@@ -66,44 +151,454 @@ bool ani_anilist_get_next_episode(const char *mal_id, ani_series *series) {
   }
 
   success = false;
+  ANI_TRACE_BEGIN(span, "anilist.extract_next_episode", "provider");
   root = ani_json_get_root(doc);
   if (root != NULL) {
     data = ani_json_object_get(root, "data");
     if (data != NULL) {
       media = ani_json_object_get(data, "Media");
       if (media != NULL) {
-        next_airing = ani_json_object_get(media, "nextAiringEpisode");
-        if (next_airing != NULL) {
-          // Get episode number
-          val = ani_json_object_get(next_airing, "episode");
-          if (val != NULL) {
-            episode_num = ani_json_get_int(val);
-            series->release.next_number = (int)episode_num;
-          }
-
-          // Get airing timestamp (Unix seconds)
-          val = ani_json_object_get(next_airing, "airingAt");
-          if (val != NULL) {
-            airing_at = ani_json_get_int(val);
-            ani_parse_unix_timestamp(airing_at, &series->release.next_date);
-          }
-
-          // Set source metadata
-          series->release.next_source = ANI_SOURCE_AGGREGATED_API;
-          series->release.next_confidence = ANI_CONFIDENCE_OFFICIAL;
-          free(series->release.provider_name);
-          series->release.provider_name = ani_strdup("AniList");
-
-          success = true;
-          LOG_INFO("Found next episode: Ep %d via AniList",
-                   series->release.next_number);
-        } else {
+        parse_latest_aired(media, series);
+        success = parse_next_airing(media, series);
+        if (!success) {
           LOG_DEBUG("No upcoming episode found for MAL ID %s", mal_id);
         }
       }
     }
   }
 
+  ANI_TRACE_END(span);
+
   ani_json_doc_free(doc);
   return success;
 }
+
+// Fill series (details and schedule) from a Media object selected with
+// MEDIA_DETAIL_FIELDS
+static void parse_media(ani_json_val *media, const char *anilist_id,
+                        ani_series *series) {
+  ani_json_val *title;
+  ani_json_val *start;
+
+  series->id = ani_series_strdup(series, anilist_id);
+
+  title = ani_json_object_get(media, "title");
+  ani_series_set_title(series, ani_json_object_get_string(title, "english"),
+                       ani_json_object_get_string(title, "native"),
+                       ani_json_object_get_string(title, "romaji"));
+
+  series->release.total_count =
+      (int)ani_json_object_get_int(media, "episodes", -1);
+
+  // The premiere, like Jikan's aired.from
+  start = ani_json_object_get(media, "startDate");
+  if (start != NULL && ani_json_object_get_int(start, "year", 0) > 0) {
+    series->release.latest_date.year =
+        (int)ani_json_object_get_int(start, "year", 0);
+    series->release.latest_date.month =
+        (int)ani_json_object_get_int(start, "month", 1);
+    series->release.latest_date.day =
+        (int)ani_json_object_get_int(start, "day", 1);
+    series->release.latest_date.hour = -1;
+    series->release.latest_date.minute = -1;
+    series->release.latest_date.second = -1;
+  }
+
+  series->media_type = ANI_MEDIA_ANIME;
+  series->provider = "anilist";
+  parse_latest_aired(media, series);
+  parse_next_airing(media, series);
+}
+
+bool ani_anilist_get_anime(ani_ctx *ctx, const char *anilist_id, bool refresh,
+                           ani_series *series) {
+  char query_body[1024];
+  char cache_key[64];
+  char *body;
+  size_t body_len;
+  ani_trace_span span;
+  ani_json_doc *doc;
+  ani_json_val *root;
+  ani_json_val *data;
+  ani_json_val *media;
+  bool success;
+
+  if (anilist_id == NULL || series == NULL) {
+    return false;
+  }
+
+  // Details and schedule in one request
+  snprintf(query_body, sizeof(query_body),
+           "{"
+           "\"query\": \"query($id:Int!){ "
+           "Media(id:$id,type:ANIME){ " MEDIA_DETAIL_FIELDS "} }\","
+           "\"variables\": {\"id\": %s}"
+           "}",
+           anilist_id);
+  snprintf(cache_key, sizeof(cache_key), "media_%s", anilist_id);
+
+  LOG_DEBUG("AniList GraphQL query for AniList ID: %s", anilist_id);
+
+  // The response carries the schedule, so it expires like one
+  body = ani_ctx_fetch(ctx, "anilist", anilist_graphql_url(), query_body,
+                       cache_key, refresh ? 0 : ANI_CACHE_TTL_SCHEDULE,
+                       &body_len);
+  if (body == NULL) {
+    return false;
+  }
+
+  doc = ani_json_parse(body, body_len);
+  ani_free(body);
+
+  if (doc == NULL) {
+    return false;
+  }
+
+  success = false;
+  ANI_TRACE_BEGIN(span, "anilist.extract_anime", "provider");
+  root = ani_json_get_root(doc);
+  data = root != NULL ? ani_json_object_get(root, "data") : NULL;
+  media = data != NULL ? ani_json_object_get(data, "Media") : NULL;
+  if (media != NULL && ani_json_is_object(media)) {
+    parse_media(media, anilist_id, series);
+
+    success = series->id != NULL;
+    LOG_INFO("Found anime: %s (AniList ID: %s)",
+             series->title.canonical ? series->title.canonical : "unknown",
+             anilist_id);
+  }
+
+  ANI_TRACE_END(span);
+
+  ani_json_doc_free(doc);
+  return success;
+}
+
+// Copy src into dst as a JSON string body: quotes and backslashes escaped,
+// control characters turned into spaces. False if it does not fit.
+static bool json_escape(const char *src, char *dst, size_t size) {
+  size_t used;
+
+  used = 0;
+  for (; *src != '\0'; src++) {
+    if (used + 3 > size) {
+      return false;
+    }
+    if (*src == '"' || *src == '\\') {
+      dst[used++] = '\\';
+      dst[used++] = *src;
+    } else if ((unsigned char)*src < 0x20) {
+      dst[used++] = ' ';
+    } else {
+      dst[used++] = *src;
+    }
+  }
+  dst[used] = '\0';
+
+  return true;
+}
+
+bool ani_anilist_search_anime(ani_ctx *ctx, const char *query,
+                              ani_series *series, char *mal_id,
+                              size_t mal_id_size) {
+  char escaped[512];
+  char query_body[1536];
+  char anilist_id[32];
+  ani_http_config config;
+  ani_http_response *resp;
+  ani_trace_span span;
+  ani_json_doc *doc;
+  ani_json_val *root;
+  ani_json_val *media;
+  long id_mal;
+  bool success;
+
+  if (query == NULL || series == NULL) {
+    return false;
+  }
+  if (mal_id != NULL && mal_id_size > 0) {
+    mal_id[0] = '\0';
+  }
+
+  if (!json_escape(query, escaped, sizeof(escaped))) {
+    LOG_WARN("Query too long for AniList search");
+
+    return false;
+  }
+
+  // The title travels as a variable, so JSON escaping is all it needs
+  snprintf(query_body, sizeof(query_body),
+           "{"
+           "\"query\": \"query($search:String){ "
+           "Media(search:$search,type:ANIME){ " MEDIA_DETAIL_FIELDS "} }\","
+           "\"variables\": {\"search\": \"%s\"}"
+           "}",
+           escaped);
+
+  LOG_DEBUG("AniList GraphQL search: %s", query);
+
+  config = ani_ctx_http_config(ctx, "anilist");
+  resp = ani_http_post(anilist_graphql_url(), query_body, "application/json",
+                       &config);
+  if (resp == NULL || resp->status_code != 200) {
+    LOG_WARN("AniList search failed: HTTP %ld", resp ? resp->status_code : 0);
+    ani_http_response_free(resp);
+
+    return false;
+  }
+
+  doc = ani_json_parse(resp->body, resp->body_len);
+  ani_http_response_free(resp);
+
+  if (doc == NULL) {
+    return false;
+  }
+
+  success = false;
+  ANI_TRACE_BEGIN(span, "anilist.extract_search", "provider");
+  root = ani_json_get_root(doc);
+  media = ani_json_object_get(ani_json_object_get(root, "data"), "Media");
+  if (media != NULL && ani_json_is_object(media)) {
+    snprintf(anilist_id, sizeof(anilist_id), "%ld",
+             ani_json_object_get_int(media, "id", 0));
+    parse_media(media, anilist_id, series);
+
+    id_mal = ani_json_object_get_int(media, "idMal", 0);
+    if (mal_id != NULL && mal_id_size > 0 && id_mal > 0) {
+      snprintf(mal_id, mal_id_size, "%ld", id_mal);
+    }
+
+    success = series->id != NULL;
+    LOG_INFO("Found anime: %s (AniList ID: %s, MAL ID: %ld)",
+             series->title.canonical ? series->title.canonical : "unknown",
+             anilist_id, id_mal);
+  }
+
+  ANI_TRACE_END(span);
+
+  ani_json_doc_free(doc);
+  return success;
+}
+
+// One Page request for up to ANILIST_BATCH_MAX series
+static bool next_episode_page(ani_ctx *ctx, ani_series **series,
+                              size_t count) {
+  char *query_body;
+  size_t size;
+  size_t used;
+  size_t ids;
+  size_t i;
+  size_t j;
+  ani_http_config config;
+  ani_http_response *resp;
+  ani_trace_span span;
+  ani_json_doc *doc;
+  ani_json_val *root;
+  ani_json_val *page;
+  ani_json_val *media_list;
+  ani_json_val *media;
+  char mal_id[32];
+  size_t media_count;
+
+  // Room for the query text plus ten digits and a comma per ID
+  size = 512 + count * 11;
+  query_body = ani_malloc(size);
+  if (query_body == NULL) {
+    return false;
+  }
+
+  used = (size_t)snprintf(
+      query_body, size,
+      "{"
+      "\"query\": \"query($ids:[Int]){ "
+      "Page(perPage:%d){ media(idMal_in:$ids,type:ANIME){ "
+      "idMal " ANILIST_SCHEDULE_FIELDS "} } }\","
+      "\"variables\": {\"ids\": [",
+      ANILIST_BATCH_MAX);
+  ids = 0;
+  for (i = 0; i < count && used < size; i++) {
+    // Anything but a decimal ID must not reach the query
+    if (!ani_str_is_decimal_id(series[i]->id)) {
+      continue;
+    }
+    used += (size_t)snprintf(query_body + used, size - used, "%s%s",
+                             ids > 0 ? "," : "", series[i]->id);
+    ids++;
+  }
+  if (used < size) {
+    used += (size_t)snprintf(query_body + used, size - used, "]}}");
+  }
+  if (ids == 0 || used >= size) {
+    ani_free(query_body);
+
+    return ids == 0;
+  }
+
+  LOG_DEBUG("AniList GraphQL page query for %zu MAL IDs", ids);
+
+  config = ani_ctx_http_config(ctx, "anilist");
+  resp = ani_http_post(anilist_graphql_url(), query_body, "application/json",
+                       &config);
+  ani_free(query_body);
+  if (resp == NULL || resp->status_code != 200) {
+    LOG_WARN("AniList page query failed: HTTP %ld",
+             resp ? resp->status_code : 0);
+    ani_http_response_free(resp);
+
+    return false;
+  }
+
+  doc = ani_json_parse(resp->body, resp->body_len);
+  ani_http_response_free(resp);
+
+  if (doc == NULL) {
+    return false;
+  }
+
+  ANI_TRACE_BEGIN(span, "anilist.extract_next_episodes", "provider");
+  root = ani_json_get_root(doc);
+  page = ani_json_object_get(ani_json_object_get(root, "data"), "Page");
+  media_list = ani_json_object_get(page, "media");
+  media_count = ani_json_array_size(media_list);
+
+  // Spread each media back to every series with its MAL ID
+  for (i = 0; i < media_count; i++) {
+    media = ani_json_array_get(media_list, i);
+    snprintf(mal_id, sizeof(mal_id), "%ld",
+             ani_json_object_get_int(media, "idMal", -1));
+    for (j = 0; j < count; j++) {
+      if (series[j]->id != NULL && strcmp(series[j]->id, mal_id) == 0) {
+        parse_latest_aired(media, series[j]);
+        parse_next_airing(media, series[j]);
+      }
+    }
+  }
+
+  ANI_TRACE_END(span);
+
+  ani_json_doc_free(doc);
+  return true;
+}
+
+bool ani_anilist_get_next_episodes(ani_ctx *ctx, ani_series **series,
+                                   size_t count) {
+  size_t i;
+  size_t n;
+  bool ok;
+
+  if (series == NULL) {
+    return false;
+  }
+
+  ok = true;
+  for (i = 0; i < count; i += n) {
+    n = count - i < ANILIST_BATCH_MAX ? count - i : ANILIST_BATCH_MAX;
+    if (!next_episode_page(ctx, series + i, n)) {
+      ok = false;
+    }
+  }
+
+  return ok;
+}
+
+// One page of the airing calendar; *more says whether another follows
+static bool airing_page(ani_ctx *ctx, ani_calendar *calendar, int page,
+                        bool *more) {
+  char query_body[1024];
+  ani_http_config config;
+  ani_http_response *resp;
+  ani_trace_span span;
+  ani_json_doc *doc;
+  ani_json_val *page_obj;
+  ani_json_val *schedules;
+  ani_json_val *schedule;
+  ani_json_val *media;
+  ani_json_val *title;
+  const char *name;
+  size_t count;
+  size_t i;
+  bool ok;
+
+  snprintf(query_body, sizeof(query_body),
+           "{"
+           "\"query\": \"query($page:Int,$from:Int,$to:Int){ "
+           "Page(page:$page,perPage:%d){ pageInfo{ hasNextPage } "
+           "airingSchedules(airingAt_greater:$from,airingAt_lesser:$to,"
+           "sort:TIME){ episode airingAt media{ id idMal episodes "
+           "title{ romaji english } } } } }\","
+           "\"variables\": {\"page\": %d, \"from\": %lld, \"to\": %lld}"
+           "}",
+           ANILIST_BATCH_MAX, page, (long long)calendar->from,
+           (long long)calendar->to);
+
+  LOG_DEBUG("AniList airing calendar page %d", page);
+
+  config = ani_ctx_http_config(ctx, "anilist");
+  resp = ani_http_post(anilist_graphql_url(), query_body, "application/json",
+                       &config);
+  if (resp == NULL || resp->status_code != 200) {
+    LOG_WARN("AniList calendar query failed: HTTP %ld",
+             resp ? resp->status_code : 0);
+    ani_http_response_free(resp);
+
+    return false;
+  }
+
+  doc = ani_json_parse(resp->body, resp->body_len);
+  ani_http_response_free(resp);
+
+  if (doc == NULL) {
+    return false;
+  }
+
+  ok = true;
+  ANI_TRACE_BEGIN(span, "anilist.extract_calendar", "provider");
+  page_obj = ani_json_object_get(
+      ani_json_object_get(ani_json_get_root(doc), "data"), "Page");
+  schedules = ani_json_object_get(page_obj, "airingSchedules");
+  count = ani_json_array_size(schedules);
+  for (i = 0; i < count && ok; i++) {
+    schedule = ani_json_array_get(schedules, i);
+    media = ani_json_object_get(schedule, "media");
+    title = ani_json_object_get(media, "title");
+    name = ani_json_object_get_string(title, "romaji");
+    if (name == NULL) {
+      name = ani_json_object_get_string(title, "english");
+    }
+
+    ok = ani_calendar_add(
+        calendar, ani_json_object_get_int(schedule, "airingAt", 0),
+        (int)ani_json_object_get_int(schedule, "episode", -1),
+        ani_json_object_get_int(media, "idMal", 0),
+        ani_json_object_get_int(media, "id", 0),
+        (int)ani_json_object_get_int(media, "episodes", -1), name);
+  }
+  *more = ani_json_object_get_bool(
+      ani_json_object_get(page_obj, "pageInfo"), "hasNextPage", false);
+  ANI_TRACE_END(span);
+
+  ani_json_doc_free(doc);
+  return ok && page_obj != NULL;
+}
+
+bool ani_anilist_get_airing(ani_ctx *ctx, ani_calendar *calendar) {
+  int page;
+  bool more;
+
+  if (calendar == NULL) {
+    return false;
+  }
+
+  more = true;
+  for (page = 1; more && page <= ANILIST_CALENDAR_PAGES; page++) {
+    if (!airing_page(ctx, calendar, page, &more)) {
+      return false;
+    }
+  }
+  if (more) {
+    LOG_WARN("Airing calendar cut off after %d pages", ANILIST_CALENDAR_PAGES);
+  }
+
+  ani_calendar_sort(calendar);
+  return true;
+}
@@ -5,57 +5,28 @@
  */
 
 #include "ani/providers/jikan.h"
+#include "ani/alloc.h"
+#include "ani/cache.h"
+#include "ani/ctx.h"
 #include "ani/http.h"
 #include "ani/json.h"
 #include "ani/log.h"
 #include "ani/str.h"
+#include "ani/trace.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #define JIKAN_BASE_URL "https://api.jikan.moe/v4"
-#define JIKAN_SEARCH_URL                                                       \
-  JIKAN_BASE_URL "/anime?q=%s&limit=1&order_by=popularity"
-#define JIKAN_ANIME_URL JIKAN_BASE_URL "/anime/%s"
-
-// URL encode a query string
-static char *url_encode(const char *str) {
-  size_t len;
-  size_t i;
-  size_t j;
-  char *encoded;
-  const char *hex = "0123456789ABCDEF";
-
-  if (str == NULL) {
-    return NULL;
-  }
-
-  len = strlen(str);
-  // Worst case: every char becomes %XX (3x expansion)
-  encoded = malloc(len * 3 + 1);
-  if (encoded == NULL) {
-    return NULL;
-  }
-
-  j = 0;
-  for (i = 0; i < len; i++) {
-    unsigned char c = (unsigned char)str[i];
-
-    if ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') ||
-        (c >= '0' && c <= '9') || c == '-' || c == '_' || c == '.' ||
-        c == '~') {
-      encoded[j++] = (char)c;
-    } else if (c == ' ') {
-      encoded[j++] = '+';
-    } else {
-      encoded[j++] = '%';
-      encoded[j++] = hex[(c >> 4) & 0xF];
-      encoded[j++] = hex[c & 0xF];
-    }
-  }
-  encoded[j] = '\0';
+#define JIKAN_BASE_URL_ENV "ANI_JIKAN_URL"
+#define JIKAN_SEARCH_URL "%s/anime?q=%s&limit=1&order_by=popularity"
+#define JIKAN_ANIME_URL "%s/anime/%s"
 
-  return encoded;
+// Base URL, overridable for local stubs and benchmarks
+static const char *jikan_base_url(void) {
+  const char *url = getenv(JIKAN_BASE_URL_ENV);
+
+  return url != NULL && url[0] != '\0' ? url : JIKAN_BASE_URL;
 }
 
 // Parse anime titles from JSON
@@ -82,7 +53,52 @@ static void parse_titles(ani_json_val *anime_obj, ani_series *series) {
   japanese = ani_json_get_string(title_obj);
 
   // Set titles
-  ani_title_set(&series->title, english, japanese, canonical);
+  ani_series_set_title(series, english, japanese, canonical);
+}
+
+// Parse the weekly slot: broadcast { day: "Saturdays", time: "23:00",
+// timezone: "Asia/Tokyo" } on top of the premiere date (aired.from, a
+// Japanese date written as midnight UTC)
+static void parse_broadcast(ani_json_val *anime_obj, ani_series *series) {
+  static const char *const days[] = {"Sun", "Mon", "Tue", "Wed",
+                                     "Thu", "Fri", "Sat"};
+  ani_broadcast *slot;
+  ani_json_val *broadcast;
+  const char *day;
+  const char *time_str;
+  const char *timezone;
+  ani_instant premiere;
+  int hour;
+  int minute;
+  int i;
+
+  slot = &series->release.broadcast;
+  slot->airing = ani_json_object_get_bool(anime_obj, "airing", false);
+
+  broadcast = ani_json_object_get(anime_obj, "broadcast");
+  day = ani_json_object_get_string(broadcast, "day");
+  time_str = ani_json_object_get_string(broadcast, "time");
+  timezone = ani_json_object_get_string(broadcast, "timezone");
+  if (day == NULL || time_str == NULL || timezone == NULL ||
+      strcmp(timezone, "Asia/Tokyo") != 0 ||
+      sscanf(time_str, "%d:%d", &hour, &minute) != 2 || hour < 0 ||
+      hour > 23 || minute < 0 || minute > 59) {
+    return;
+  }
+
+  for (i = 0; i < 7; i++) {
+    if (strncmp(day, days[i], 3) == 0) {
+      slot->weekday = i;
+      slot->minute = hour * 60 + minute;
+    }
+  }
+
+  if (slot->weekday >= 0 &&
+      ani_parse_instant(ani_json_object_get_string(
+                            ani_json_object_get(anime_obj, "aired"), "from"),
+                        &premiere)) {
+    slot->premiere = premiere.epoch + (slot->minute - 9 * 60) * 60;
+  }
 }
 
 // Parse episode count and aired dates
@@ -116,17 +132,47 @@ static void parse_details(ani_json_val *anime_obj, ani_series *series) {
     const char *status = ani_json_get_string(val);
     LOG_DEBUG("Anime status: %s", status ? status : "unknown");
   }
+
+  parse_broadcast(anime_obj, series);
+}
+
+// Fill series from one anime object (search hit or details)
+static bool parse_anime(ani_json_val *anime_obj, ani_series *series) {
+  ani_json_val *mal_id_val;
+  char mal_id_str[32];
+
+  mal_id_val = ani_json_object_get(anime_obj, "mal_id");
+  if (mal_id_val == NULL) {
+    return false;
+  }
+
+  snprintf(mal_id_str, sizeof(mal_id_str), "%ld", ani_json_get_int(mal_id_val));
+  series->id = ani_series_strdup(series, mal_id_str);
+
+  // Parse titles and details
+  parse_titles(anime_obj, series);
+  parse_details(anime_obj, series);
+
+  series->media_type = ANI_MEDIA_ANIME;
+  series->provider = "jikan";
+
+  LOG_INFO("Found anime: %s (MAL ID: %s)",
+           series->title.canonical ? series->title.canonical : "unknown",
+           series->id ? series->id : "unknown");
+  return series->id != NULL;
 }
 
-bool ani_jikan_search_anime(const char *query, ani_series *series) {
+bool ani_jikan_search_anime(ani_ctx *ctx, const char *query,
+                            ani_series *series) {
   char url[512];
   char *encoded_query;
+  ani_http_config config;
   ani_http_response *resp;
+  ani_trace_span span;
   ani_json_doc *doc;
   ani_json_val *root;
   ani_json_val *data_array;
   ani_json_val *anime_obj;
-  ani_json_val *mal_id_val;
   bool success;
 
   if (query == NULL || series == NULL) {
@@ -134,19 +180,21 @@ bool ani_jikan_search_anime(const char *query, ani_series *series) {
   }
 
   // URL encode query
-  encoded_query = url_encode(query);
+  encoded_query = ani_url_encode(query);
   if (encoded_query == NULL) {
     return false;
   }
 
   // Build search URL
-  snprintf(url, sizeof(url), JIKAN_SEARCH_URL, encoded_query);
-  free(encoded_query);
+  snprintf(url, sizeof(url), JIKAN_SEARCH_URL, jikan_base_url(),
+           encoded_query);
+  ani_free(encoded_query);
 
   LOG_DEBUG("Jikan search: %s", url);
 
   // Make HTTP request
-  resp = ani_http_get(url, NULL);
+  config = ani_ctx_http_config(ctx, "jikan");
+  resp = ani_http_get(url, &config);
   if (resp == NULL || resp->status_code != 200) {
     LOG_ERROR("Jikan search failed: HTTP %ld", resp ? resp->status_code : 0);
     ani_http_response_free(resp);
@@ -162,36 +210,70 @@ bool ani_jikan_search_anime(const char *query, ani_series *series) {
   }
 
   success = false;
+  ANI_TRACE_BEGIN(span, "jikan.extract_search", "provider");
   root = ani_json_get_root(doc);
   if (root != NULL) {
     data_array = ani_json_object_get(root, "data");
     if (data_array != NULL && ani_json_array_size(data_array) > 0) {
       anime_obj = ani_json_array_get(data_array, 0);
       if (anime_obj != NULL) {
-        // Get MAL ID
-        mal_id_val = ani_json_object_get(anime_obj, "mal_id");
-        if (mal_id_val != NULL) {
-          long mal_id = ani_json_get_int(mal_id_val);
-          char mal_id_str[32];
-          snprintf(mal_id_str, sizeof(mal_id_str), "%ld", mal_id);
-          series->id = ani_strdup(mal_id_str);
-        }
-
-        // Parse titles and details
-        parse_titles(anime_obj, series);
-        parse_details(anime_obj, series);
-
-        series->media_type = ANI_MEDIA_ANIME;
-        series->provider = ani_strdup("jikan");
-        success = true;
-
-        LOG_INFO("Found anime: %s (MAL ID: %s)",
-                 series->title.canonical ? series->title.canonical : "unknown",
-                 series->id ? series->id : "unknown");
+        success = parse_anime(anime_obj, series);
       }
     }
   }
 
+  ANI_TRACE_END(span);
+
+  ani_json_doc_free(doc);
+  return success;
+}
+
+bool ani_jikan_get_anime(ani_ctx *ctx, const char *mal_id, bool refresh,
+                         ani_series *series) {
+  char url[512];
+  char cache_key[64];
+  char *body;
+  size_t body_len;
+  ani_trace_span span;
+  ani_json_doc *doc;
+  ani_json_val *root;
+  ani_json_val *anime_obj;
+  bool success;
+
+  if (mal_id == NULL || series == NULL) {
+    return false;
+  }
+
+  snprintf(url, sizeof(url), JIKAN_ANIME_URL, jikan_base_url(), mal_id);
+  snprintf(cache_key, sizeof(cache_key), "anime_%s", mal_id);
+
+  LOG_DEBUG("Jikan anime: %s", url);
+
+  body = ani_ctx_fetch(ctx, "jikan", url, NULL, cache_key,
+                       refresh ? 0 : ANI_CACHE_TTL_DETAILS, &body_len);
+  if (body == NULL) {
+    return false;
+  }
+
+  doc = ani_json_parse(body, body_len);
+  ani_free(body);
+
+  if (doc == NULL) {
+    return false;
+  }
+
+  success = false;
+  ANI_TRACE_BEGIN(span, "jikan.extract_anime", "provider");
+  root = ani_json_get_root(doc);
+  if (root != NULL) {
+    anime_obj = ani_json_object_get(root, "data");
+    if (anime_obj != NULL && ani_json_is_object(anime_obj)) {
+      success = parse_anime(anime_obj, series);
+    }
+  }
+
+  ANI_TRACE_END(span);
+
   ani_json_doc_free(doc);
   return success;
 }
@@ -5,60 +5,40 @@
  */
 
 #include "ani/providers/mangadex.h"
+#include "ani/alloc.h"
+#include "ani/cache.h"
+#include "ani/ctx.h"
 #include "ani/http.h"
 #include "ani/json.h"
 #include "ani/log.h"
 #include "ani/str.h"
+#include "ani/trace.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #define MANGADEX_BASE_URL "https://api.mangadex.org"
-#define MANGADEX_SEARCH_URL                                                    \
-  MANGADEX_BASE_URL "/manga?title=%s&limit=1&order[relevance]=desc"
+#define MANGADEX_BASE_URL_ENV "ANI_MANGADEX_URL"
+#define MANGADEX_SEARCH_URL "%s/manga?title=%s&limit=1&order[relevance]=desc"
+#define MANGADEX_MANGA_URL "%s/manga/%s"
 #define MANGADEX_CHAPTER_URL                                                   \
-  MANGADEX_BASE_URL "/chapter?manga=%s&translatedLanguage[]=en&limit=1&order[" \
-                    "publishAt]=desc"
-#define MANGADEX_AGGREGATE_URL                                                 \
-  MANGADEX_BASE_URL "/manga/%s/aggregate?translatedLanguage[]=en"
-
-// URL encode helper (same as jikan.c)
-static char *url_encode(const char *str) {
-  size_t len;
-  size_t i;
-  size_t j;
-  char *encoded;
-  const char *hex = "0123456789ABCDEF";
-
-  if (str == NULL) {
-    return NULL;
-  }
-
-  len = strlen(str);
-  encoded = malloc(len * 3 + 1);
-  if (encoded == NULL) {
-    return NULL;
-  }
-
-  j = 0;
-  for (i = 0; i < len; i++) {
-    unsigned char c = (unsigned char)str[i];
-
-    if ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') ||
-        (c >= '0' && c <= '9') || c == '-' || c == '_' || c == '.' ||
-        c == '~') {
-      encoded[j++] = (char)c;
-    } else if (c == ' ') {
-      encoded[j++] = '+';
-    } else {
-      encoded[j++] = '%';
-      encoded[j++] = hex[(c >> 4) & 0xF];
-      encoded[j++] = hex[c & 0xF];
-    }
-  }
-  encoded[j] = '\0';
-
-  return encoded;
+  "%s/chapter?manga=%s&translatedLanguage[]=en&limit=1&order[publishAt]=desc"
+#define MANGADEX_HISTORY_URL                                                   \
+  "%s/chapter?manga=%s&translatedLanguage[]=en&limit=%d&order[publishAt]=desc"
+#define MANGADEX_AGGREGATE_URL "%s/manga/%s/aggregate?translatedLanguage[]=en"
+#define MANGADEX_CHAPTER_ID_URL "%s/chapter/%s"
+// Lists by ID; the ratings undo the default filter, as for /manga/{id}
+#define MANGADEX_LIST_URL                                                      \
+  "%s/%s?limit=%d&contentRating[]=safe&contentRating[]=suggestive"             \
+  "&contentRating[]=erotica&contentRating[]=pornographic"
+#define MANGADEX_BATCH_MAX 100 // Largest page MangaDex serves
+#define MANGADEX_UUID_LEN 36
+
+// Base URL, overridable for local stubs and benchmarks
+static const char *mangadex_base_url(void) {
+  const char *url = getenv(MANGADEX_BASE_URL_ENV);
+
+  return url != NULL && url[0] != '\0' ? url : MANGADEX_BASE_URL;
 }
 
 // Parse manga titles from JSON
@@ -123,18 +103,95 @@ static void parse_titles(ani_json_val *manga_obj, ani_series *series) {
     english = canonical;
   }
 
-  ani_title_set(&series->title, english, japanese, canonical);
+  ani_series_set_title(series, english, japanese, canonical);
 }
 
-bool ani_mangadex_search_manga(const char *query, ani_series *series) {
+// Fill series from a manga entity (search result or details)
+static bool parse_manga(ani_json_val *manga_obj, ani_series *series) {
+  const char *id;
+  const char *last_chapter;
+
+  id = ani_json_object_get_string(manga_obj, "id");
+  if (id == NULL) {
+    return false;
+  }
+
+  // A series refreshed by ID keeps its copy
+  if (series->id == NULL) {
+    series->id = ani_series_strdup(series, id);
+  }
+  parse_titles(manga_obj, series);
+
+  series->media_type = ANI_MEDIA_MANGA;
+  series->provider = "mangadex";
+
+  // Set once the series has finished; "" while it runs
+  last_chapter = ani_json_object_get_string(
+      ani_json_object_get(manga_obj, "attributes"), "lastChapter");
+  if (last_chapter != NULL && atoi(last_chapter) > 0) {
+    series->release.total_count = atoi(last_chapter);
+  }
+
+  LOG_INFO("Found manga: %s (ID: %s)",
+           series->title.canonical ? series->title.canonical : "unknown", id);
+
+  return series->id != NULL;
+}
+
+// Remember the manga's latest upload for the chapter lookup; only live
+// answers may be trusted with it
+static void parse_latest_upload(ani_json_val *manga_obj, ani_series *series) {
+  const char *latest_id;
+
+  latest_id = ani_json_object_get_string(
+      ani_json_object_get(manga_obj, "attributes"), "latestUploadedChapter");
+  if (ani_str_is_uuid(latest_id)) {
+    ani_strlcpy(series->release.latest_id, latest_id,
+                sizeof(series->release.latest_id));
+  }
+}
+
+// Latest chapter from a chapter entity; false unless it is in English
+static bool parse_chapter(ani_json_val *chapter_obj, ani_series *series) {
+  ani_json_val *attributes;
+  const char *language;
+  const char *chapter_num_str;
+  const char *publish_date_str;
+
+  attributes = ani_json_object_get(chapter_obj, "attributes");
+  language = ani_json_object_get_string(attributes, "translatedLanguage");
+  if (language == NULL || strcmp(language, "en") != 0) {
+    return false;
+  }
+
+  // Get chapter number
+  chapter_num_str = ani_json_object_get_string(attributes, "chapter");
+  if (chapter_num_str != NULL) {
+    series->release.latest_number = atoi(chapter_num_str);
+  }
+
+  // Get publish date
+  publish_date_str = ani_json_object_get_string(attributes, "publishAt");
+  if (publish_date_str != NULL) {
+    ani_parse_iso8601(publish_date_str, &series->release.latest_date);
+  }
+
+  LOG_DEBUG("Latest chapter: %d on %s", series->release.latest_number,
+            publish_date_str ? publish_date_str : "unknown");
+
+  return true;
+}
+
+bool ani_mangadex_search_manga(ani_ctx *ctx, const char *query,
+                               ani_series *series) {
   char url[512];
   char *encoded_query;
+  ani_http_config config;
   ani_http_response *resp;
+  ani_trace_span span;
   ani_json_doc *doc;
   ani_json_val *root;
-  ani_json_val *data_array;
   ani_json_val *manga_obj;
-  ani_json_val *id_val;
   bool success;
 
   if (query == NULL || series == NULL) {
@@ -142,19 +199,21 @@ bool ani_mangadex_search_manga(const char *query, ani_series *series) {
   }
 
   // URL encode query
-  encoded_query = url_encode(query);
+  encoded_query = ani_url_encode(query);
   if (encoded_query == NULL) {
     return false;
   }
 
   // Build search URL
-  snprintf(url, sizeof(url), MANGADEX_SEARCH_URL, encoded_query);
-  free(encoded_query);
+  snprintf(url, sizeof(url), MANGADEX_SEARCH_URL, mangadex_base_url(),
+           encoded_query);
+  ani_free(encoded_query);
 
   LOG_DEBUG("MangaDex search: %s", url);
 
   // Make HTTP request
-  resp = ani_http_get(url, NULL);
+  config = ani_ctx_http_config(ctx, "mangadex");
+  resp = ani_http_get(url, &config);
   if (resp == NULL || resp->status_code != 200) {
     LOG_ERROR("MangaDex search failed: HTTP %ld", resp ? resp->status_code : 0);
     ani_http_response_free(resp);
@@ -170,64 +229,84 @@ bool ani_mangadex_search_manga(const char *query, ani_series *series) {
     return false;
   }
 
-  success = false;
+  ANI_TRACE_BEGIN(span, "mangadex.extract_search", "provider");
   root = ani_json_get_root(doc);
-  if (root != NULL) {
-    data_array = ani_json_object_get(root, "data");
-    if (data_array != NULL && ani_json_array_size(data_array) > 0) {
-      manga_obj = ani_json_array_get(data_array, 0);
-      if (manga_obj != NULL) {
-        // Get manga ID
-        id_val = ani_json_object_get(manga_obj, "id");
-        if (id_val != NULL) {
-          const char *id = ani_json_get_string(id_val);
-          if (id != NULL) {
-            series->id = ani_strdup(id);
-
-            // Parse titles
-            parse_titles(manga_obj, series);
-
-            series->media_type = ANI_MEDIA_MANGA;
-            series->provider = ani_strdup("mangadex");
-            success = true;
-
-            LOG_INFO("Found manga: %s (ID: %s)",
-                     series->title.canonical ? series->title.canonical
-                                             : "unknown",
-                     series->id);
-          }
-        }
-      }
-    }
+  manga_obj = ani_json_array_get(ani_json_object_get(root, "data"), 0);
+  success = manga_obj != NULL && parse_manga(manga_obj, series);
+  if (success) {
+    parse_latest_upload(manga_obj, series);
   }
 
+  ANI_TRACE_END(span);
+
   ani_json_doc_free(doc);
   return success;
 }
 
-bool ani_mangadex_get_latest_chapter(const char *manga_id, ani_series *series) {
+bool ani_mangadex_get_manga(ani_ctx *ctx, const char *manga_id, bool refresh,
+                            ani_series *series) {
   char url[512];
-  ani_http_response *resp;
+  char cache_key[64];
+  char *body;
+  size_t body_len;
+  ani_trace_span span;
   ani_json_doc *doc;
   ani_json_val *root;
-  ani_json_val *data_array;
-  ani_json_val *chapter_obj;
-  ani_json_val *attributes;
-  const char *chapter_num_str;
-  const char *publish_date_str;
   bool success;
 
   if (manga_id == NULL || series == NULL) {
     return false;
   }
 
+  snprintf(url, sizeof(url), MANGADEX_MANGA_URL, mangadex_base_url(),
+           manga_id);
+  snprintf(cache_key, sizeof(cache_key), "manga_%s", manga_id);
+
+  LOG_DEBUG("MangaDex manga: %s", url);
+
+  body = ani_ctx_fetch(ctx, "mangadex", url, NULL, cache_key,
+                       refresh ? 0 : ANI_CACHE_TTL_DETAILS, &body_len);
+  if (body == NULL) {
+    return false;
+  }
+
+  doc = ani_json_parse(body, body_len);
+  ani_free(body);
+
+  if (doc == NULL) {
+    return false;
+  }
+
+  // latestUploadedChapter is left out: these details may be hours old
+  ANI_TRACE_BEGIN(span, "mangadex.extract_manga", "provider");
+  root = ani_json_get_root(doc);
+  success = parse_manga(ani_json_object_get(root, "data"), series);
+  ANI_TRACE_END(span);
+
+  ani_json_doc_free(doc);
+  return success;
+}
+
+// Latest English chapter from the manga's chapter feed
+static bool latest_from_feed(ani_ctx *ctx, const char *manga_id,
+                             ani_series *series) {
+  char url[512];
+  ani_http_config config;
+  ani_http_response *resp;
+  ani_trace_span span;
+  ani_json_doc *doc;
+  ani_json_val *root;
+  bool success;
+
   // Build chapter URL
-  snprintf(url, sizeof(url), MANGADEX_CHAPTER_URL, manga_id);
+  snprintf(url, sizeof(url), MANGADEX_CHAPTER_URL, mangadex_base_url(),
+           manga_id);
 
   LOG_DEBUG("MangaDex latest chapter: %s", url);
 
   // Make HTTP request
-  resp = ani_http_get(url, NULL);
+  config = ani_ctx_http_config(ctx, "mangadex");
+  resp = ani_http_get(url, &config);
   if (resp == NULL || resp->status_code != 200) {
     LOG_WARN("MangaDex chapter query failed: HTTP %ld",
              resp ? resp->status_code : 0);
@@ -243,36 +322,445 @@ bool ani_mangadex_get_latest_chapter(const char *manga_id, ani_series *series) {
     return false;
   }
 
-  success = false;
+  ANI_TRACE_BEGIN(span, "mangadex.extract_chapter", "provider");
   root = ani_json_get_root(doc);
-  if (root != NULL) {
-    data_array = ani_json_object_get(root, "data");
-    if (data_array != NULL && ani_json_array_size(data_array) > 0) {
-      chapter_obj = ani_json_array_get(data_array, 0);
-      if (chapter_obj != NULL) {
-        attributes = ani_json_object_get(chapter_obj, "attributes");
-        if (attributes != NULL) {
-          // Get chapter number
-          chapter_num_str = ani_json_object_get_string(attributes, "chapter");
-          if (chapter_num_str != NULL) {
-            series->release.latest_number = atoi(chapter_num_str);
-          }
-
-          // Get publish date
-          publish_date_str =
-              ani_json_object_get_string(attributes, "publishAt");
-          if (publish_date_str != NULL) {
-            ani_parse_iso8601(publish_date_str, &series->release.latest_date);
-          }
-
-          success = true;
-          LOG_DEBUG("Latest chapter: %d on %s", series->release.latest_number,
-                    publish_date_str ? publish_date_str : "unknown");
-        }
+  success = parse_chapter(
+      ani_json_array_get(ani_json_object_get(root, "data"), 0), series);
+  ANI_TRACE_END(span);
+
+  ani_json_doc_free(doc);
+  return success;
+}
+
+// Latest chapter from the upload named by the search; a chapter never
+// changes, so the answer is cached
+static bool latest_from_id(ani_ctx *ctx, ani_series *series) {
+  char url[512];
+  char cache_key[64];
+  char *body;
+  size_t body_len;
+  ani_trace_span span;
+  ani_json_doc *doc;
+  ani_json_val *data;
+  bool success;
+
+  snprintf(url, sizeof(url), MANGADEX_CHAPTER_ID_URL, mangadex_base_url(),
+           series->release.latest_id);
+  snprintf(cache_key, sizeof(cache_key), "chapter_%s",
+           series->release.latest_id);
+
+  LOG_DEBUG("MangaDex chapter: %s", url);
+
+  body = ani_ctx_fetch(ctx, "mangadex", url, NULL, cache_key,
+                       ANI_CACHE_TTL_DETAILS, &body_len);
+  if (body == NULL) {
+    return false;
+  }
+
+  doc = ani_json_parse(body, body_len);
+  ani_free(body);
+
+  if (doc == NULL) {
+    return false;
+  }
+
+  ANI_TRACE_BEGIN(span, "mangadex.extract_chapter", "provider");
+  data = ani_json_object_get(ani_json_get_root(doc), "data");
+  if (ani_json_is_array(data)) {
+    data = ani_json_array_get(data, 0);
+  }
+  success = parse_chapter(data, series);
+  ANI_TRACE_END(span);
+
+  ani_json_doc_free(doc);
+  return success;
+}
+
+bool ani_mangadex_get_latest_chapter(ani_ctx *ctx, const char *manga_id,
+                                     ani_series *series) {
+  if (manga_id == NULL || series == NULL) {
+    return false;
+  }
+
+  // The latest upload may be in another language; then ask the feed
+  if (series->release.latest_id[0] != '\0' && latest_from_id(ctx, series)) {
+    return true;
+  }
+
+  return latest_from_feed(ctx, manga_id, series);
+}
+
+// List URL for path ("manga" or "chapter") asking for the UUID of each
+// series, or of its latest upload; NULL if none is valid
+static char *list_url(const char *path, ani_series **series, size_t count,
+                      bool latest) {
+  char *url;
+  const char *id;
+  size_t size;
+  size_t used;
+  size_t ids;
+  size_t i;
+
+  // Room for the base URL and filters plus "&ids[]=" and a UUID per series
+  size = strlen(mangadex_base_url()) + 256 + count * (8 + MANGADEX_UUID_LEN);
+  url = ani_malloc(size);
+  if (url == NULL) {
+    return NULL;
+  }
+
+  used = (size_t)snprintf(url, size, MANGADEX_LIST_URL, mangadex_base_url(),
+                          path, MANGADEX_BATCH_MAX);
+  ids = 0;
+  for (i = 0; i < count && used < size; i++) {
+    id = latest ? series[i]->release.latest_id : series[i]->id;
+    if (!ani_str_is_uuid(id)) {
+      continue;
+    }
+    used += (size_t)snprintf(url + used, size - used, "&ids[]=%s", id);
+    ids++;
+  }
+  if (ids == 0 || used >= size) {
+    ani_free(url);
+
+    return NULL;
+  }
+
+  return url;
+}
+
+// One chapter list request for up to MANGADEX_BATCH_MAX latest uploads
+static bool chapter_page(ani_ctx *ctx, ani_series **series, size_t count) {
+  char *url;
+  size_t i;
+  size_t j;
+  bool resolved[MANGADEX_BATCH_MAX];
+  ani_http_config config;
+  ani_http_response *resp;
+  ani_trace_span span;
+  ani_json_doc *doc;
+  ani_json_val *data_array;
+  ani_json_val *chapter_obj;
+  const char *id;
+  size_t chapter_count;
+  bool ok;
+
+  url = list_url("chapter", series, count, true);
+  if (url == NULL) {
+    return false;
+  }
+
+  LOG_DEBUG("MangaDex chapter list for %zu chapters", count);
+
+  config = ani_ctx_http_config(ctx, "mangadex");
+  resp = ani_http_get(url, &config);
+  ani_free(url);
+  if (resp == NULL || resp->status_code != 200) {
+    LOG_WARN("MangaDex chapter list failed: HTTP %ld",
+             resp ? resp->status_code : 0);
+    ani_http_response_free(resp);
+
+    return false;
+  }
+
+  doc = ani_json_parse(resp->body, resp->body_len);
+  ani_http_response_free(resp);
+
+  if (doc == NULL) {
+    return false;
+  }
+
+  memset(resolved, 0, sizeof(resolved));
+  ANI_TRACE_BEGIN(span, "mangadex.extract_chapters", "provider");
+  data_array = ani_json_object_get(ani_json_get_root(doc), "data");
+  chapter_count = ani_json_array_size(data_array);
+  for (i = 0; i < chapter_count; i++) {
+    chapter_obj = ani_json_array_get(data_array, i);
+    id = ani_json_object_get_string(chapter_obj, "id");
+    for (j = 0; id != NULL && j < count; j++) {
+      if (strcmp(series[j]->release.latest_id, id) == 0) {
+        resolved[j] = parse_chapter(chapter_obj, series[j]);
       }
     }
   }
+  ANI_TRACE_END(span);
 
   ani_json_doc_free(doc);
-  return success;
+
+  // Uploads in other languages (or withheld from the list) take the feed
+  ok = true;
+  for (i = 0; i < count; i++) {
+    if (!resolved[i] && !latest_from_feed(ctx, series[i]->id, series[i])) {
+      ok = false;
+    }
+  }
+
+  return ok;
+}
+
+// One manga list request for up to MANGADEX_BATCH_MAX series
+static bool manga_page(ani_ctx *ctx, ani_series **series, size_t count) {
+  char *url;
+  size_t i;
+  size_t j;
+  ani_http_config config;
+  ani_http_response *resp;
+  ani_trace_span span;
+  ani_json_doc *doc;
+  ani_json_val *data_array;
+  ani_json_val *manga_obj;
+  const char *id;
+  size_t manga_count;
+
+  url = list_url("manga", series, count, false);
+  if (url == NULL) {
+    return true; // Nothing to ask for
+  }
+
+  LOG_DEBUG("MangaDex manga list for %zu series", count);
+
+  config = ani_ctx_http_config(ctx, "mangadex");
+  resp = ani_http_get(url, &config);
+  ani_free(url);
+  if (resp == NULL || resp->status_code != 200) {
+    LOG_WARN("MangaDex manga list failed: HTTP %ld",
+             resp ? resp->status_code : 0);
+    ani_http_response_free(resp);
+
+    return false;
+  }
+
+  doc = ani_json_parse(resp->body, resp->body_len);
+  ani_http_response_free(resp);
+
+  if (doc == NULL) {
+    return false;
+  }
+
+  ANI_TRACE_BEGIN(span, "mangadex.extract_mangas", "provider");
+  data_array = ani_json_object_get(ani_json_get_root(doc), "data");
+  manga_count = ani_json_array_size(data_array);
+  for (i = 0; i < manga_count; i++) {
+    manga_obj = ani_json_array_get(data_array, i);
+    id = ani_json_object_get_string(manga_obj, "id");
+    for (j = 0; id != NULL && j < count; j++) {
+      if (series[j]->id != NULL && strcmp(series[j]->id, id) == 0 &&
+          parse_manga(manga_obj, series[j])) {
+        parse_latest_upload(manga_obj, series[j]);
+      }
+    }
+  }
+  ANI_TRACE_END(span);
+
+  ani_json_doc_free(doc);
+  return true;
+}
+
+bool ani_mangadex_get_mangas(ani_ctx *ctx, ani_series **series, size_t count) {
+  size_t i;
+  size_t n;
+  bool ok;
+
+  if (series == NULL) {
+    return false;
+  }
+
+  ok = true;
+  for (i = 0; i < count; i += n) {
+    n = count - i < MANGADEX_BATCH_MAX ? count - i : MANGADEX_BATCH_MAX;
+    if (!manga_page(ctx, series + i, n)) {
+      ok = false;
+    }
+  }
+
+  return ok;
+}
+
+bool ani_mangadex_get_latest_chapters(ani_ctx *ctx, ani_series **series,
+                                      size_t count) {
+  ani_series *page[MANGADEX_BATCH_MAX];
+  ani_series **unknown;
+  size_t unknown_count;
+  size_t n;
+  size_t i;
+  bool ok;
+
+  if (series == NULL) {
+    return false;
+  }
+
+  // Series resolved from the index or by ID carry no latest upload; a
+  // manga list names it for 100 at a time
+  unknown = ani_malloc((count + 1) * sizeof(*unknown));
+  if (unknown == NULL) {
+    return false;
+  }
+
+  unknown_count = 0;
+  for (i = 0; i < count; i++) {
+    if (series[i] != NULL && series[i]->id != NULL &&
+        series[i]->release.latest_id[0] == '\0') {
+      unknown[unknown_count++] = series[i];
+    }
+  }
+  if (unknown_count > 0) {
+    ani_mangadex_get_mangas(ctx, unknown, unknown_count);
+  }
+  ani_free(unknown);
+
+  ok = true;
+  n = 0;
+  for (i = 0; i < count; i++) {
+    if (series[i] == NULL || series[i]->id == NULL) {
+      continue;
+    }
+
+    // Still unknown: missing from the list, or the list failed
+    if (series[i]->release.latest_id[0] == '\0') {
+      if (!latest_from_feed(ctx, series[i]->id, series[i])) {
+        ok = false;
+      }
+      continue;
+    }
+
+    page[n++] = series[i];
+    if (n == MANGADEX_BATCH_MAX) {
+      ok = chapter_page(ctx, page, n) && ok;
+      n = 0;
+    }
+  }
+  if (n > 0) {
+    ok = chapter_page(ctx, page, n) && ok;
+  }
+
+  return ok;
+}
+
+bool ani_mangadex_get_chapter_history(ani_ctx *ctx, const char *manga_id,
+                                      ani_cadence *history) {
+  char url[512];
+  ani_http_config config;
+  ani_http_response *resp;
+  ani_trace_span span;
+  ani_json_doc *doc;
+  ani_json_val *data_array;
+  ani_json_val *attributes;
+  const char *chapter_num_str;
+  ani_instant published;
+  size_t count;
+  size_t i;
+
+  if (manga_id == NULL || history == NULL) {
+    return false;
+  }
+
+  snprintf(url, sizeof(url), MANGADEX_HISTORY_URL, mangadex_base_url(),
+           manga_id, ANI_CADENCE_MAX);
+
+  LOG_DEBUG("MangaDex chapter history: %s", url);
+
+  config = ani_ctx_http_config(ctx, "mangadex");
+  resp = ani_http_get(url, &config);
+  if (resp == NULL || resp->status_code != 200) {
+    LOG_WARN("MangaDex chapter history failed: HTTP %ld",
+             resp ? resp->status_code : 0);
+    ani_http_response_free(resp);
+
+    return false;
+  }
+
+  doc = ani_json_parse(resp->body, resp->body_len);
+  ani_http_response_free(resp);
+
+  if (doc == NULL) {
+    return false;
+  }
+
+  ANI_TRACE_BEGIN(span, "mangadex.extract_history", "provider");
+  data_array = ani_json_object_get(ani_json_get_root(doc), "data");
+  count = ani_json_array_size(data_array);
+  for (i = 0; i < count; i++) {
+    attributes =
+        ani_json_object_get(ani_json_array_get(data_array, i), "attributes");
+    chapter_num_str = ani_json_object_get_string(attributes, "chapter");
+    if (chapter_num_str != NULL &&
+        ani_parse_instant(ani_json_object_get_string(attributes, "publishAt"),
+                          &published)) {
+      ani_cadence_add(history, atoi(chapter_num_str), published.epoch);
+    }
+  }
+  ANI_TRACE_END(span);
+
+  ani_json_doc_free(doc);
+  return true;
+}
+
+bool ani_mangadex_get_chapter_count(ani_ctx *ctx, const char *manga_id,
+                                    bool refresh, ani_series *series) {
+  char url[512];
+  char cache_key[64];
+  char *body;
+  size_t body_len;
+  ani_trace_span span;
+  ani_json_doc *doc;
+  ani_json_val *volumes;
+  ani_json_val *chapters;
+  size_t volume_count;
+  size_t chapter_count;
+  size_t i;
+  size_t j;
+  int number;
+  int highest;
+
+  if (manga_id == NULL || series == NULL) {
+    return false;
+  }
+
+  snprintf(url, sizeof(url), MANGADEX_AGGREGATE_URL, mangadex_base_url(),
+           manga_id);
+  snprintf(cache_key, sizeof(cache_key), "aggregate_%s", manga_id);
+
+  LOG_DEBUG("MangaDex aggregate: %s", url);
+
+  body = ani_ctx_fetch(ctx, "mangadex", url, NULL, cache_key,
+                       refresh ? 0 : ANI_CACHE_TTL_DETAILS, &body_len);
+  if (body == NULL) {
+    return false;
+  }
+
+  doc = ani_json_parse(body, body_len);
+  ani_free(body);
+
+  if (doc == NULL) {
+    return false;
+  }
+
+  // volumes: { "<volume>": { "chapters": { "<chapter>": {...} } } }, keyed
+  // "none" for chapters outside a volume; an empty manga has volumes: []
+  highest = -1;
+  ANI_TRACE_BEGIN(span, "mangadex.extract_aggregate", "provider");
+  volumes = ani_json_object_get(ani_json_get_root(doc), "volumes");
+  volume_count = ani_json_object_size(volumes);
+  for (i = 0; i < volume_count; i++) {
+    chapters =
+        ani_json_object_get(ani_json_object_value_at(volumes, i), "chapters");
+    chapter_count = ani_json_object_size(chapters);
+    for (j = 0; j < chapter_count; j++) {
+      number = atoi(ani_json_get_string_safe(
+          ani_json_object_get(ani_json_object_value_at(chapters, j),
+                              "chapter"),
+          "0"));
+      if (number > highest) {
+        highest = number;
+      }
+    }
+  }
+  ANI_TRACE_END(span);
+
+  ani_json_doc_free(doc);
+
+  if (highest > 0) {
+    series->release.total_count = highest;
+  }
+
+  return true;
 }
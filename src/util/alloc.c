@@ -0,0 +1,301 @@
+/*
+ * Routine: ani — Anime/Manga scheduling information CLI
+ * Author: DannyBimma
+ * Copyright: (c) 2025 Technomancer Pirate Captain. All Rights Reserved.
+ */
+
+#include "ani/alloc.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Size prefix kept by the counting and bump allocators; 16 bytes keeps the
+// returned pointer aligned for anything malloc would return (the bump
+// allocator pads its arena memory to match)
+#define SIZE_HEADER 16
+
+#if defined(__GNUC__) || defined(__clang__)
+#define ATOMIC_ADD(p, v) __atomic_fetch_add((p), (v), __ATOMIC_RELAXED)
+#define ATOMIC_SUB(p, v) __atomic_fetch_sub((p), (v), __ATOMIC_RELAXED)
+#define ATOMIC_LOAD(p) __atomic_load_n((p), __ATOMIC_RELAXED)
+#else
+#define ATOMIC_ADD(p, v) (*(p) += (v))
+#define ATOMIC_SUB(p, v) (*(p) -= (v))
+#define ATOMIC_LOAD(p) (*(p))
+#endif
+
+static void *libc_malloc(void *ctx, size_t size) {
+  (void)ctx;
+  return malloc(size);
+}
+
+static void *libc_realloc(void *ctx, void *ptr, size_t size) {
+  (void)ctx;
+  return realloc(ptr, size);
+}
+
+static void libc_free(void *ctx, void *ptr) {
+  (void)ctx;
+  free(ptr);
+}
+
+static ani_allocator current = {libc_malloc, libc_realloc, libc_free, NULL};
+
+ani_allocator ani_libc_allocator(void) {
+  ani_allocator allocator = {libc_malloc, libc_realloc, libc_free, NULL};
+
+  return allocator;
+}
+
+void ani_set_allocator(const ani_allocator *allocator) {
+  if (allocator == NULL || allocator->malloc_fn == NULL ||
+      allocator->realloc_fn == NULL || allocator->free_fn == NULL) {
+    current = ani_libc_allocator();
+    return;
+  }
+
+  current = *allocator;
+}
+
+ani_allocator ani_get_allocator(void) { return current; }
+
+void *ani_malloc(size_t size) { return current.malloc_fn(current.ctx, size); }
+
+void *ani_calloc(size_t count, size_t size) {
+  void *ptr;
+
+  if (size != 0 && count > SIZE_MAX / size) {
+    return NULL;
+  }
+
+  ptr = current.malloc_fn(current.ctx, count * size);
+  if (ptr != NULL) {
+    memset(ptr, 0, count * size);
+  }
+
+  return ptr;
+}
+
+void *ani_realloc(void *ptr, size_t size) {
+  return current.realloc_fn(current.ctx, ptr, size);
+}
+
+void ani_free(void *ptr) {
+  if (ptr != NULL) {
+    current.free_fn(current.ctx, ptr);
+  }
+}
+
+// --- counting allocator ---
+
+static void counter_grow(ani_alloc_counter *counter, size_t size) {
+  uint64_t live;
+  uint64_t peak;
+
+  ATOMIC_ADD(&counter->stats.bytes, (uint64_t)size);
+  live = ATOMIC_ADD(&counter->stats.live_bytes, (uint64_t)size) + size;
+
+#if defined(__GNUC__) || defined(__clang__)
+  peak = __atomic_load_n(&counter->stats.peak_bytes, __ATOMIC_RELAXED);
+  while (live > peak &&
+         !__atomic_compare_exchange_n(&counter->stats.peak_bytes, &peak, live,
+                                      true, __ATOMIC_RELAXED,
+                                      __ATOMIC_RELAXED)) {
+  }
+#else
+  peak = counter->stats.peak_bytes;
+  if (live > peak) {
+    counter->stats.peak_bytes = live;
+  }
+#endif
+}
+
+static void *counter_malloc(void *ctx, size_t size) {
+  ani_alloc_counter *counter = ctx;
+  char *base;
+
+  if (size > SIZE_MAX - SIZE_HEADER) {
+    return NULL;
+  }
+
+  base = counter->parent.malloc_fn(counter->parent.ctx, SIZE_HEADER + size);
+  if (base == NULL) {
+    return NULL;
+  }
+
+  memcpy(base, &size, sizeof(size));
+  ATOMIC_ADD(&counter->stats.allocs, 1);
+  counter_grow(counter, size);
+
+  return base + SIZE_HEADER;
+}
+
+static void counter_free(void *ctx, void *ptr) {
+  ani_alloc_counter *counter = ctx;
+  char *base;
+  size_t size;
+
+  if (ptr == NULL) {
+    return;
+  }
+
+  base = (char *)ptr - SIZE_HEADER;
+  memcpy(&size, base, sizeof(size));
+  ATOMIC_ADD(&counter->stats.frees, 1);
+  ATOMIC_SUB(&counter->stats.live_bytes, (uint64_t)size);
+  counter->parent.free_fn(counter->parent.ctx, base);
+}
+
+static void *counter_realloc(void *ctx, void *ptr, size_t size) {
+  ani_alloc_counter *counter = ctx;
+  char *base;
+  size_t old_size;
+
+  if (size > SIZE_MAX - SIZE_HEADER) {
+    return NULL;
+  }
+
+  old_size = 0;
+  base = NULL;
+  if (ptr != NULL) {
+    base = (char *)ptr - SIZE_HEADER;
+    memcpy(&old_size, base, sizeof(old_size));
+  }
+
+  base = counter->parent.realloc_fn(counter->parent.ctx, base,
+                                    SIZE_HEADER + size);
+  if (base == NULL) {
+    return NULL;
+  }
+
+  memcpy(base, &size, sizeof(size));
+  ATOMIC_ADD(&counter->stats.reallocs, 1);
+  ATOMIC_SUB(&counter->stats.live_bytes, (uint64_t)old_size);
+  counter_grow(counter, size);
+
+  return base + SIZE_HEADER;
+}
+
+void ani_alloc_counter_init(ani_alloc_counter *counter,
+                            const ani_allocator *parent) {
+  if (counter == NULL) {
+    return;
+  }
+
+  memset(counter, 0, sizeof(*counter));
+  counter->parent = parent != NULL ? *parent : ani_get_allocator();
+}
+
+ani_allocator ani_alloc_counter_allocator(ani_alloc_counter *counter) {
+  ani_allocator allocator;
+
+  allocator.malloc_fn = counter_malloc;
+  allocator.realloc_fn = counter_realloc;
+  allocator.free_fn = counter_free;
+  allocator.ctx = counter;
+
+  return allocator;
+}
+
+void ani_alloc_counter_stats(ani_alloc_counter *counter, ani_alloc_stats *out) {
+  if (counter == NULL || out == NULL) {
+    return;
+  }
+
+  out->allocs = ATOMIC_LOAD(&counter->stats.allocs);
+  out->reallocs = ATOMIC_LOAD(&counter->stats.reallocs);
+  out->frees = ATOMIC_LOAD(&counter->stats.frees);
+  out->bytes = ATOMIC_LOAD(&counter->stats.bytes);
+  out->live_bytes = ATOMIC_LOAD(&counter->stats.live_bytes);
+  out->peak_bytes = ATOMIC_LOAD(&counter->stats.peak_bytes);
+}
+
+// --- bump allocator ---
+
+static void *bump_malloc(void *ctx, size_t size) {
+  ani_bump *bump = ctx;
+  char *raw;
+  char *base;
+
+  if (size > SIZE_MAX - 2 * SIZE_HEADER) {
+    return NULL;
+  }
+
+  // Arena memory is only pointer-aligned: pad so the pointer handed out is
+  // SIZE_HEADER-aligned like malloc's
+  ani_mutex_lock(&bump->lock);
+  raw = ani_arena_alloc(bump->arena, 2 * SIZE_HEADER - 1 + size);
+  ani_mutex_unlock(&bump->lock);
+  if (raw == NULL) {
+    return NULL;
+  }
+  base = raw + (SIZE_HEADER - (uintptr_t)raw % SIZE_HEADER) % SIZE_HEADER;
+
+  // Remember the size so realloc knows how much to copy
+  memcpy(base, &size, sizeof(size));
+
+  return base + SIZE_HEADER;
+}
+
+static void *bump_realloc(void *ctx, void *ptr, size_t size) {
+  size_t old_size;
+  void *grown;
+
+  if (ptr == NULL) {
+    return bump_malloc(ctx, size);
+  }
+
+  memcpy(&old_size, (char *)ptr - SIZE_HEADER, sizeof(old_size));
+  if (size <= old_size) {
+    return ptr;
+  }
+
+  grown = bump_malloc(ctx, size);
+  if (grown == NULL) {
+    return NULL;
+  }
+
+  memcpy(grown, ptr, old_size);
+  return grown;
+}
+
+static void bump_free(void *ctx, void *ptr) {
+  // Reclaimed by ani_bump_destroy
+  (void)ctx;
+  (void)ptr;
+}
+
+bool ani_bump_init(ani_bump *bump, size_t block_size) {
+  if (bump == NULL) {
+    return false;
+  }
+
+  // Blocks come from the allocator installed now, not from the bump itself
+  bump->arena = ani_arena_new(block_size > 0 ? block_size : 64 * 1024);
+  if (bump->arena == NULL) {
+    return false;
+  }
+
+  ani_mutex_init(&bump->lock);
+  return true;
+}
+
+void ani_bump_destroy(ani_bump *bump) {
+  if (bump == NULL || bump->arena == NULL) {
+    return;
+  }
+
+  ani_arena_free(bump->arena);
+  bump->arena = NULL;
+  ani_mutex_destroy(&bump->lock);
+}
+
+ani_allocator ani_bump_allocator(ani_bump *bump) {
+  ani_allocator allocator;
+
+  allocator.malloc_fn = bump_malloc;
+  allocator.realloc_fn = bump_realloc;
+  allocator.free_fn = bump_free;
+  allocator.ctx = bump;
+
+  return allocator;
+}
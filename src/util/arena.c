@@ -0,0 +1,186 @@
+/*
+ * Routine: ani — Anime/Manga scheduling information CLI
+ * Author: DannyBimma
+ * Copyright: (c) 2025 Technomancer Pirate Captain. All Rights Reserved.
+ */
+
+#include "ani/arena.h"
+#include "ani/alloc.h"
+#include <string.h>
+
+#define ARENA_DEFAULT_BLOCK 4096
+// Alignment good enough for pointers, doubles and int64_t
+#define ARENA_ALIGN                                                            \
+  (sizeof(void *) > sizeof(double) ? sizeof(void *) : sizeof(double))
+
+typedef struct ani_arena_block {
+  struct ani_arena_block *next;
+  size_t capacity;
+  size_t used;
+  // Data follows, aligned by the header size
+} ani_arena_block;
+
+struct ani_arena {
+  ani_arena_block *head; // Current block; older blocks follow
+  size_t block_size;
+  size_t used;
+  ani_allocator source; // Allocator at creation time (so an arena can back
+                        // the global allocator without recursing)
+};
+
+#define BLOCK_HEADER                                                           \
+  ((sizeof(ani_arena_block) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1))
+#define BLOCK_DATA(b) ((char *)(b) + BLOCK_HEADER)
+
+static ani_arena_block *block_new(ani_arena *arena, size_t capacity) {
+  ani_arena_block *block;
+
+  block = arena->source.malloc_fn(arena->source.ctx, BLOCK_HEADER + capacity);
+  if (block == NULL) {
+    return NULL;
+  }
+
+  block->next = NULL;
+  block->capacity = capacity;
+  block->used = 0;
+
+  return block;
+}
+
+ani_arena *ani_arena_new(size_t block_size) {
+  ani_allocator source;
+  ani_arena *arena;
+
+  source = ani_get_allocator();
+  arena = source.malloc_fn(source.ctx, sizeof(*arena));
+  if (arena == NULL) {
+    return NULL;
+  }
+
+  arena->source = source;
+  arena->block_size = block_size > 0 ? block_size : ARENA_DEFAULT_BLOCK;
+  arena->used = 0;
+  arena->head = block_new(arena, arena->block_size);
+  if (arena->head == NULL) {
+    source.free_fn(source.ctx, arena);
+
+    return NULL;
+  }
+
+  return arena;
+}
+
+static void free_blocks(ani_arena *arena, ani_arena_block *block) {
+  ani_arena_block *next;
+
+  while (block != NULL) {
+    next = block->next;
+    arena->source.free_fn(arena->source.ctx, block);
+    block = next;
+  }
+}
+
+void ani_arena_free(ani_arena *arena) {
+  if (arena == NULL) {
+    return;
+  }
+
+  free_blocks(arena, arena->head);
+  arena->source.free_fn(arena->source.ctx, arena);
+}
+
+void ani_arena_reset(ani_arena *arena) {
+  ani_arena_block *first;
+  ani_arena_block *block;
+  ani_arena_block *next;
+
+  if (arena == NULL) {
+    return;
+  }
+
+  // The first block is the oldest, at the tail; free everything newer
+  first = arena->head;
+  while (first->next != NULL) {
+    first = first->next;
+  }
+  for (block = arena->head; block != first; block = next) {
+    next = block->next;
+    arena->source.free_fn(arena->source.ctx, block);
+  }
+
+  arena->head = first;
+  first->used = 0;
+  arena->used = 0;
+}
+
+void *ani_arena_alloc(ani_arena *arena, size_t size) {
+  ani_arena_block *block;
+  size_t offset;
+  void *ptr;
+
+  if (arena == NULL) {
+    return NULL;
+  }
+
+  size = (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+  if (size == 0) {
+    size = ARENA_ALIGN;
+  }
+
+  block = arena->head;
+  offset = block->used;
+  if (size > block->capacity - offset) {
+    // Oversized requests get a block of their own
+    block = block_new(arena,
+                      size > arena->block_size ? size : arena->block_size);
+    if (block == NULL) {
+      return NULL;
+    }
+    block->next = arena->head;
+    arena->head = block;
+    offset = 0;
+  }
+
+  ptr = BLOCK_DATA(block) + offset;
+  block->used = offset + size;
+  arena->used += size;
+  memset(ptr, 0, size);
+
+  return ptr;
+}
+
+char *ani_arena_strndup(ani_arena *arena, const char *s, size_t n) {
+  size_t len;
+  char *copy;
+
+  if (s == NULL) {
+    return NULL;
+  }
+
+  len = 0;
+  while (len < n && s[len] != '\0') {
+    len++;
+  }
+
+  copy = ani_arena_alloc(arena, len + 1);
+  if (copy == NULL) {
+    return NULL;
+  }
+
+  memcpy(copy, s, len);
+  copy[len] = '\0';
+
+  return copy;
+}
+
+char *ani_arena_strdup(ani_arena *arena, const char *s) {
+  if (s == NULL) {
+    return NULL;
+  }
+
+  return ani_arena_strndup(arena, s, strlen(s));
+}
+
+size_t ani_arena_used(const ani_arena *arena) {
+  return arena != NULL ? arena->used : 0;
+}
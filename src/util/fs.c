@@ -5,14 +5,17 @@
  */
 
 #include "ani/fs.h"
+#include "ani/alloc.h"
 #include "ani/str.h"
 #include <errno.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
 
 #ifdef _WIN32
 #include <direct.h>
+#include <windows.h>
 #define mkdir(path, mode) _mkdir(path)
 #else
 #include <unistd.h>
@@ -34,7 +37,7 @@ char *ani_get_cache_dir(void) {
   cache_dir = ani_path_join(base, "ani");
   if (cache_dir != NULL) {
     char *full_path = ani_path_join(cache_dir, "Cache");
-    free(cache_dir);
+    ani_free(cache_dir);
     return full_path;
   }
   return NULL;
@@ -47,10 +50,10 @@ char *ani_get_cache_dir(void) {
   cache_dir = ani_path_join(base, "Library");
   if (cache_dir != NULL) {
     char *caches = ani_path_join(cache_dir, "Caches");
-    free(cache_dir);
+    ani_free(cache_dir);
     if (caches != NULL) {
       char *full_path = ani_path_join(caches, "ani");
-      free(caches);
+      ani_free(caches);
       return full_path;
     }
   }
@@ -69,7 +72,7 @@ char *ani_get_cache_dir(void) {
   cache_dir = ani_path_join(base, ".cache");
   if (cache_dir != NULL) {
     char *full_path = ani_path_join(cache_dir, "ani");
-    free(cache_dir);
+    ani_free(cache_dir);
     return full_path;
   }
   return NULL;
@@ -108,12 +111,12 @@ bool ani_mkdir_p(const char *path) {
 
       if (stat(copy, &st) != 0) {
         if (mkdir(copy, 0755) != 0 && errno != EEXIST) {
-          free(copy);
+          ani_free(copy);
 
           return false;
         }
       } else if (!S_ISDIR(st.st_mode)) {
-        free(copy);
+        ani_free(copy);
 
         return false;
       }
@@ -125,11 +128,11 @@ bool ani_mkdir_p(const char *path) {
 
   // Create final directory
   if (mkdir(copy, 0755) != 0 && errno != EEXIST) {
-    free(copy);
+    ani_free(copy);
     return false;
   }
 
-  free(copy);
+  ani_free(copy);
   return true;
 }
 
@@ -152,7 +155,7 @@ char *ani_path_join(const char *base, const char *name) {
       base_len > 0 && base[base_len - 1] != '/' && base[base_len - 1] != '\\';
 
   total_len = base_len + (needs_sep ? 1 : 0) + name_len;
-  result = malloc(total_len + 1);
+  result = ani_malloc(total_len + 1);
   if (result == NULL) {
     return NULL;
   }
@@ -172,3 +175,100 @@ char *ani_path_join(const char *base, const char *name) {
   result[total_len] = '\0';
   return result;
 }
+
+char *ani_read_file(const char *path, size_t *len_out) {
+  FILE *f;
+  struct stat st;
+  char *data;
+  size_t file_size;
+  size_t read_size;
+
+  if (path == NULL || stat(path, &st) != 0) {
+    return NULL;
+  }
+
+  f = fopen(path, "rb");
+  if (f == NULL) {
+    return NULL;
+  }
+
+  file_size = (size_t)st.st_size;
+  data = ani_malloc(file_size + 1);
+  if (data == NULL) {
+    fclose(f);
+
+    return NULL;
+  }
+
+  read_size = fread(data, 1, file_size, f);
+  fclose(f);
+
+  if (read_size != file_size) {
+    ani_free(data);
+
+    return NULL;
+  }
+
+  data[file_size] = '\0';
+  if (len_out != NULL) {
+    *len_out = file_size;
+  }
+
+  return data;
+}
+
+static unsigned long tmp_counter = 0;
+
+bool ani_write_file_atomic(const char *path, const void *data, size_t len) {
+  char *tmp_path;
+  size_t path_len;
+  unsigned long seq;
+  FILE *f;
+  size_t written;
+  bool ok;
+
+  if (path == NULL || (data == NULL && len > 0)) {
+    return false;
+  }
+
+  // Readers must never see a half-written file. The temp name is unique per
+  // process and call so concurrent writers of one path never share it.
+  path_len = strlen(path) + 64;
+  tmp_path = ani_malloc(path_len);
+  if (tmp_path == NULL) {
+    return false;
+  }
+#if defined(__GNUC__) || defined(__clang__)
+  seq = __atomic_add_fetch(&tmp_counter, 1, __ATOMIC_RELAXED);
+#else
+  seq = ++tmp_counter;
+#endif
+#ifdef _WIN32
+  snprintf(tmp_path, path_len, "%s.%lu.%lu.tmp", path,
+           (unsigned long)GetCurrentProcessId(), seq);
+#else
+  snprintf(tmp_path, path_len, "%s.%ld.%lu.tmp", path, (long)getpid(), seq);
+#endif
+
+  ok = false;
+  f = fopen(tmp_path, "wb");
+  if (f != NULL) {
+    written = len > 0 ? fwrite(data, 1, len, f) : 0;
+    ok = fclose(f) == 0 && written == len;
+  }
+
+  if (ok) {
+#ifdef _WIN32
+    ok = MoveFileExA(tmp_path, path, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    ok = rename(tmp_path, path) == 0;
+#endif
+  }
+
+  if (!ok) {
+    remove(tmp_path);
+  }
+
+  ani_free(tmp_path);
+  return ok;
+}
@@ -5,30 +5,57 @@
  */
 
 #include "ani/log.h"
+#include "ani/thread.h"
 #include <stdarg.h>
 #include <time.h>
 
 ani_log_level ani_log_current_level = ANI_LOG_INFO;
 
+// Logger bound by the context running on this thread, if any
+static ANI_THREAD_LOCAL const ani_logger *bound_logger = NULL;
+
 void ani_log_set_level(ani_log_level level) { ani_log_current_level = level; }
 
+const ani_logger *ani_log_bind(const ani_logger *logger) {
+  const ani_logger *prev = bound_logger;
+
+  bound_logger = logger;
+
+  return prev;
+}
+
 static void ani_log_internal(ani_log_level level, const char *level_str,
                              const char *fmt, va_list args) {
-  if (level > ani_log_current_level) {
+  const ani_logger *logger = bound_logger;
+  ani_log_level max_level;
+  char message[1024];
+  char time_buf[32];
+  struct tm tm_info;
+  time_t now;
+
+  max_level = logger != NULL ? logger->level : ani_log_current_level;
+  if (level > max_level) {
     return;
   }
 
-  time_t now;
-  struct tm *tm_info;
-  char time_buf[32];
+  vsnprintf(message, sizeof(message), fmt, args);
+
+  if (logger != NULL && logger->fn != NULL) {
+    logger->fn(level, message, logger->userdata);
+
+    return;
+  }
 
   time(&now);
-  tm_info = localtime(&now);
-  strftime(time_buf, sizeof(time_buf), "%Y-%m-%d %H:%M:%S", tm_info);
+#ifdef _WIN32
+  localtime_s(&tm_info, &now);
+#else
+  localtime_r(&now, &tm_info);
+#endif
+  strftime(time_buf, sizeof(time_buf), "%Y-%m-%d %H:%M:%S", &tm_info);
 
-  fprintf(stderr, "[%s] %s: ", time_buf, level_str);
-  vfprintf(stderr, fmt, args);
-  fprintf(stderr, "\n");
+  // One write per line so lines from different threads never interleave
+  fprintf(stderr, "[%s] %s: %s\n", time_buf, level_str, message);
 }
 
 void ani_log_error(const char *fmt, ...) {
@@ -5,11 +5,601 @@
  */
 
 #include "ani/str.h"
-#include <ctype.h>
+#include "ani/alloc.h"
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define STR_X86 1
+#include <emmintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#include <immintrin.h>
+#define STR_AVX2 1
+#endif
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define STR_NEON 1
+#include <arm_neon.h>
+#endif
+
+// --- Character classes ---
+
+#define CLS_URL_SAFE 0x01 // A-Z a-z 0-9 - _ . ~
+#define CLS_SPACE 0x02    // Space and \t \n \v \f \r
+#define CLS_UPPER 0x04    // A-Z
+#define CLS_LEAD2 0x08    // UTF-8 lead byte of a 2-byte sequence
+#define CLS_LEAD3 0x10    // ... 3-byte
+#define CLS_LEAD4 0x20    // ... 4-byte
+
+static const unsigned char char_class[256] = {
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  2,  2,  2,  2,  2,  0,  0,
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+     2,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  1,  1,  0,
+     1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  0,  0,  0,  0,  0,  0,
+     0,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+     5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  0,  0,  0,  0,  1,
+     0,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,
+     1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  0,  0,  0,  1,  0,
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+     0,  0,  8,  8,  8,  8,  8,  8,  8,  8,  8,  8,  8,  8,  8,  8,
+     8,  8,  8,  8,  8,  8,  8,  8,  8,  8,  8,  8,  8,  8,  8,  8,
+    16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16,
+    32, 32, 32, 32, 32,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+};
+
+#define IS_SPACE(c) (char_class[(unsigned char)(c)] & CLS_SPACE)
+#define FOLD(c)                                                                \
+  ((unsigned char)((unsigned char)(c) |                                        \
+                   ((char_class[(unsigned char)(c)] & CLS_UPPER) << 3)))
+
+// Index of the lowest set bit; mask must be non-zero
+static unsigned first_bit(uint32_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+  return (unsigned)__builtin_ctz(mask);
+#else
+  unsigned i;
+
+  for (i = 0; (mask & 1u) == 0; i++) {
+    mask >>= 1;
+  }
+
+  return i;
+#endif
+}
+
+// --- Kernels ---
+//
+// Every kernel works on a counted buffer and never reads past it. Each
+// returns the length of the leading run with some property, so callers can
+// memcpy whole runs and only handle the odd byte out in scalar code.
+
+typedef struct {
+  ani_str_isa isa;
+  // Leading bytes that need no percent-encoding
+  size_t (*url_safe_run)(const char *s, size_t n);
+  // Leading non-whitespace bytes
+  size_t (*word_run)(const char *s, size_t n);
+  // Leading ASCII (< 0x80) bytes
+  size_t (*ascii_run)(const char *s, size_t n);
+  // Leading bytes equal under ASCII case folding
+  size_t (*fold_eq_run)(const char *a, const char *b, size_t n);
+  // ASCII lowercase copy (dst may equal src)
+  void (*fold)(char *dst, const char *src, size_t n);
+} str_kernels;
+
+static size_t scalar_url_safe_run(const char *s, size_t n) {
+  size_t i;
+
+  for (i = 0; i < n && (char_class[(unsigned char)s[i]] & CLS_URL_SAFE); i++) {
+  }
+
+  return i;
+}
+
+static size_t scalar_word_run(const char *s, size_t n) {
+  size_t i;
+
+  for (i = 0; i < n && !IS_SPACE(s[i]); i++) {
+  }
+
+  return i;
+}
+
+static size_t scalar_ascii_run(const char *s, size_t n) {
+  size_t i;
+
+  for (i = 0; i < n && (unsigned char)s[i] < 0x80; i++) {
+  }
+
+  return i;
+}
+
+static size_t scalar_fold_eq_run(const char *a, const char *b, size_t n) {
+  size_t i;
+
+  for (i = 0; i < n && FOLD(a[i]) == FOLD(b[i]); i++) {
+  }
+
+  return i;
+}
+
+static void scalar_fold(char *dst, const char *src, size_t n) {
+  size_t i;
+
+  for (i = 0; i < n; i++) {
+    dst[i] = (char)FOLD(src[i]);
+  }
+}
+
+static const str_kernels scalar_kernels = {
+    ANI_STR_ISA_SCALAR, scalar_url_safe_run, scalar_word_run,
+    scalar_ascii_run,   scalar_fold_eq_run,  scalar_fold};
+
+#ifdef STR_X86
+// Bytes of v in [lo, hi] (unsigned) set to 0xFF
+#define SSE_IN_RANGE(v, lo, hi)                                                \
+  _mm_cmpeq_epi8(                                                              \
+      _mm_min_epu8(_mm_sub_epi8((v), _mm_set1_epi8((char)(lo))),               \
+                   _mm_set1_epi8((char)((hi) - (lo)))),                        \
+      _mm_sub_epi8((v), _mm_set1_epi8((char)(lo))))
+
+#define SSE_LOAD(p) _mm_loadu_si128((const __m128i *)(const void *)(p))
+
+static __m128i sse_url_safe(__m128i v) {
+  __m128i alpha;
+  __m128i digit;
+  __m128i punct;
+
+  alpha = SSE_IN_RANGE(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 'z');
+  digit = SSE_IN_RANGE(v, '0', '9');
+  punct = _mm_or_si128(
+      _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('-')),
+                   _mm_cmpeq_epi8(v, _mm_set1_epi8('.'))),
+      _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('_')),
+                   _mm_cmpeq_epi8(v, _mm_set1_epi8('~'))));
+
+  return _mm_or_si128(_mm_or_si128(alpha, digit), punct);
+}
+
+static __m128i sse_space(__m128i v) {
+  return _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+                      SSE_IN_RANGE(v, '\t', '\r'));
+}
+
+static __m128i sse_fold(__m128i v) {
+  return _mm_add_epi8(
+      v, _mm_and_si128(SSE_IN_RANGE(v, 'A', 'Z'), _mm_set1_epi8(0x20)));
+}
+
+// Length of the leading run where match has all bits set, within 16 bytes
+#define SSE_RUN(match) ((uint32_t)_mm_movemask_epi8(match) ^ 0xFFFFu)
+
+static size_t sse2_url_safe_run(const char *s, size_t n) {
+  size_t i;
+  uint32_t miss;
+
+  for (i = 0; i + 16 <= n; i += 16) {
+    miss = SSE_RUN(sse_url_safe(SSE_LOAD(s + i)));
+    if (miss != 0) {
+      return i + first_bit(miss);
+    }
+  }
+
+  return i + scalar_url_safe_run(s + i, n - i);
+}
+
+static size_t sse2_word_run(const char *s, size_t n) {
+  size_t i;
+  uint32_t hit;
+
+  for (i = 0; i + 16 <= n; i += 16) {
+    hit = (uint32_t)_mm_movemask_epi8(sse_space(SSE_LOAD(s + i)));
+    if (hit != 0) {
+      return i + first_bit(hit);
+    }
+  }
+
+  return i + scalar_word_run(s + i, n - i);
+}
+
+static size_t sse2_ascii_run(const char *s, size_t n) {
+  size_t i;
+  uint32_t high;
+
+  for (i = 0; i + 16 <= n; i += 16) {
+    high = (uint32_t)_mm_movemask_epi8(SSE_LOAD(s + i));
+    if (high != 0) {
+      return i + first_bit(high);
+    }
+  }
+
+  return i + scalar_ascii_run(s + i, n - i);
+}
+
+static size_t sse2_fold_eq_run(const char *a, const char *b, size_t n) {
+  size_t i;
+  uint32_t miss;
+
+  for (i = 0; i + 16 <= n; i += 16) {
+    miss = SSE_RUN(_mm_cmpeq_epi8(sse_fold(SSE_LOAD(a + i)),
+                                  sse_fold(SSE_LOAD(b + i))));
+    if (miss != 0) {
+      return i + first_bit(miss);
+    }
+  }
+
+  return i + scalar_fold_eq_run(a + i, b + i, n - i);
+}
+
+static void sse2_fold(char *dst, const char *src, size_t n) {
+  size_t i;
+
+  for (i = 0; i + 16 <= n; i += 16) {
+    _mm_storeu_si128((__m128i *)(void *)(dst + i), sse_fold(SSE_LOAD(src + i)));
+  }
+
+  scalar_fold(dst + i, src + i, n - i);
+}
+
+static const str_kernels sse2_kernels = {
+    ANI_STR_ISA_SSE2, sse2_url_safe_run, sse2_word_run,
+    sse2_ascii_run,   sse2_fold_eq_run,  sse2_fold};
+#endif // STR_X86
+
+#ifdef STR_AVX2
+// Compiled for AVX2 regardless of -march; only called after CPU detection
+#define AVX2_FN __attribute__((target("avx2")))
+
+// Below this the 256-bit setup costs more than it saves; stay on SSE2
+#define AVX2_MIN_LEN 64
+
+#define AVX_IN_RANGE(v, lo, hi)                                                \
+  _mm256_cmpeq_epi8(                                                           \
+      _mm256_min_epu8(_mm256_sub_epi8((v), _mm256_set1_epi8((char)(lo))),      \
+                      _mm256_set1_epi8((char)((hi) - (lo)))),                  \
+      _mm256_sub_epi8((v), _mm256_set1_epi8((char)(lo))))
+
+#define AVX_LOAD(p) _mm256_loadu_si256((const __m256i *)(const void *)(p))
+
+AVX2_FN static __m256i avx2_url_safe(__m256i v) {
+  __m256i alpha;
+  __m256i digit;
+  __m256i punct;
+
+  alpha = AVX_IN_RANGE(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), 'a', 'z');
+  digit = AVX_IN_RANGE(v, '0', '9');
+  punct = _mm256_or_si256(
+      _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('-')),
+                      _mm256_cmpeq_epi8(v, _mm256_set1_epi8('.'))),
+      _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('_')),
+                      _mm256_cmpeq_epi8(v, _mm256_set1_epi8('~'))));
+
+  return _mm256_or_si256(_mm256_or_si256(alpha, digit), punct);
+}
+
+AVX2_FN static __m256i avx2_fold_vec(__m256i v) {
+  return _mm256_add_epi8(v, _mm256_and_si256(AVX_IN_RANGE(v, 'A', 'Z'),
+                                             _mm256_set1_epi8(0x20)));
+}
+
+AVX2_FN static size_t avx2_url_safe_run(const char *s, size_t n) {
+  size_t i;
+  uint32_t miss;
+
+  if (n < AVX2_MIN_LEN) {
+    return sse2_url_safe_run(s, n);
+  }
+
+  for (i = 0; i + 32 <= n; i += 32) {
+    miss = ~(uint32_t)_mm256_movemask_epi8(avx2_url_safe(AVX_LOAD(s + i)));
+    if (miss != 0) {
+      return i + first_bit(miss);
+    }
+  }
+
+  return i + scalar_url_safe_run(s + i, n - i);
+}
+
+AVX2_FN static size_t avx2_word_run(const char *s, size_t n) {
+  __m256i v;
+  size_t i;
+  uint32_t hit;
+
+  if (n < AVX2_MIN_LEN) {
+    return sse2_word_run(s, n);
+  }
+
+  for (i = 0; i + 32 <= n; i += 32) {
+    v = AVX_LOAD(s + i);
+    hit = (uint32_t)_mm256_movemask_epi8(
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+                        AVX_IN_RANGE(v, '\t', '\r')));
+    if (hit != 0) {
+      return i + first_bit(hit);
+    }
+  }
+
+  return i + scalar_word_run(s + i, n - i);
+}
+
+AVX2_FN static size_t avx2_ascii_run(const char *s, size_t n) {
+  size_t i;
+  uint32_t high;
+
+  if (n < AVX2_MIN_LEN) {
+    return sse2_ascii_run(s, n);
+  }
+
+  for (i = 0; i + 32 <= n; i += 32) {
+    high = (uint32_t)_mm256_movemask_epi8(AVX_LOAD(s + i));
+    if (high != 0) {
+      return i + first_bit(high);
+    }
+  }
+
+  return i + scalar_ascii_run(s + i, n - i);
+}
+
+AVX2_FN static size_t avx2_fold_eq_run(const char *a, const char *b,
+                                       size_t n) {
+  size_t i;
+  uint32_t miss;
+
+  if (n < AVX2_MIN_LEN) {
+    return sse2_fold_eq_run(a, b, n);
+  }
+
+  for (i = 0; i + 32 <= n; i += 32) {
+    miss = ~(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(
+        avx2_fold_vec(AVX_LOAD(a + i)), avx2_fold_vec(AVX_LOAD(b + i))));
+    if (miss != 0) {
+      return i + first_bit(miss);
+    }
+  }
+
+  return i + scalar_fold_eq_run(a + i, b + i, n - i);
+}
+
+AVX2_FN static void avx2_fold(char *dst, const char *src, size_t n) {
+  size_t i;
+
+  if (n < AVX2_MIN_LEN) {
+    sse2_fold(dst, src, n);
+
+    return;
+  }
+
+  for (i = 0; i + 32 <= n; i += 32) {
+    _mm256_storeu_si256((__m256i *)(void *)(dst + i),
+                        avx2_fold_vec(AVX_LOAD(src + i)));
+  }
+
+  scalar_fold(dst + i, src + i, n - i);
+}
+
+static const str_kernels avx2_kernels = {
+    ANI_STR_ISA_AVX2, avx2_url_safe_run, avx2_word_run,
+    avx2_ascii_run,   avx2_fold_eq_run,  avx2_fold};
+#endif // STR_AVX2
+
+#ifdef STR_NEON
+#define NEON_IN_RANGE(v, lo, hi)                                               \
+  vcleq_u8(vsubq_u8((v), vdupq_n_u8(lo)), vdupq_n_u8((hi) - (lo)))
+
+// Index of the first 0xFF lane, or 16 if none (NEON has no movemask)
+static unsigned neon_first_hit(uint8x16_t match) {
+  uint64_t bits;
+
+  // Narrow each lane to a nibble: 64 bits, 4 per byte
+  bits = vget_lane_u64(
+      vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(match), 4)), 0);
+  if (bits == 0) {
+    return 16;
+  }
+
+  return (unsigned)__builtin_ctzll(bits) / 4;
+}
+
+static uint8x16_t neon_url_safe(uint8x16_t v) {
+  uint8x16_t alpha;
+  uint8x16_t digit;
+  uint8x16_t punct;
+
+  alpha = NEON_IN_RANGE(vorrq_u8(v, vdupq_n_u8(0x20)), 'a', 'z');
+  digit = NEON_IN_RANGE(v, '0', '9');
+  punct = vorrq_u8(vorrq_u8(vceqq_u8(v, vdupq_n_u8('-')),
+                            vceqq_u8(v, vdupq_n_u8('.'))),
+                   vorrq_u8(vceqq_u8(v, vdupq_n_u8('_')),
+                            vceqq_u8(v, vdupq_n_u8('~'))));
+
+  return vorrq_u8(vorrq_u8(alpha, digit), punct);
+}
+
+static uint8x16_t neon_fold_vec(uint8x16_t v) {
+  return vaddq_u8(v, vandq_u8(NEON_IN_RANGE(v, 'A', 'Z'), vdupq_n_u8(0x20)));
+}
+
+#define NEON_LOAD(p) vld1q_u8((const uint8_t *)(p))
+
+static size_t neon_url_safe_run(const char *s, size_t n) {
+  size_t i;
+  unsigned at;
+
+  for (i = 0; i + 16 <= n; i += 16) {
+    at = neon_first_hit(vmvnq_u8(neon_url_safe(NEON_LOAD(s + i))));
+    if (at < 16) {
+      return i + at;
+    }
+  }
+
+  return i + scalar_url_safe_run(s + i, n - i);
+}
+
+static size_t neon_word_run(const char *s, size_t n) {
+  uint8x16_t v;
+  size_t i;
+  unsigned at;
+
+  for (i = 0; i + 16 <= n; i += 16) {
+    v = NEON_LOAD(s + i);
+    at = neon_first_hit(vorrq_u8(vceqq_u8(v, vdupq_n_u8(' ')),
+                                 NEON_IN_RANGE(v, '\t', '\r')));
+    if (at < 16) {
+      return i + at;
+    }
+  }
+
+  return i + scalar_word_run(s + i, n - i);
+}
+
+static size_t neon_ascii_run(const char *s, size_t n) {
+  size_t i;
+  unsigned at;
+
+  for (i = 0; i + 16 <= n; i += 16) {
+    at = neon_first_hit(vcgeq_u8(NEON_LOAD(s + i), vdupq_n_u8(0x80)));
+    if (at < 16) {
+      return i + at;
+    }
+  }
+
+  return i + scalar_ascii_run(s + i, n - i);
+}
+
+static size_t neon_fold_eq_run(const char *a, const char *b, size_t n) {
+  size_t i;
+  unsigned at;
+
+  for (i = 0; i + 16 <= n; i += 16) {
+    at = neon_first_hit(vmvnq_u8(vceqq_u8(neon_fold_vec(NEON_LOAD(a + i)),
+                                          neon_fold_vec(NEON_LOAD(b + i)))));
+    if (at < 16) {
+      return i + at;
+    }
+  }
+
+  return i + scalar_fold_eq_run(a + i, b + i, n - i);
+}
+
+static void neon_fold(char *dst, const char *src, size_t n) {
+  size_t i;
+
+  for (i = 0; i + 16 <= n; i += 16) {
+    vst1q_u8((uint8_t *)(dst + i), neon_fold_vec(NEON_LOAD(src + i)));
+  }
+
+  scalar_fold(dst + i, src + i, n - i);
+}
+
+static const str_kernels neon_kernels = {
+    ANI_STR_ISA_NEON, neon_url_safe_run, neon_word_run,
+    neon_ascii_run,   neon_fold_eq_run,  neon_fold};
+#endif // STR_NEON
+
+// --- Runtime dispatch ---
+
+static const str_kernels *active_kernels = NULL;
+
+static const str_kernels *kernels_for(ani_str_isa isa) {
+  switch (isa) {
+  case ANI_STR_ISA_SCALAR:
+    return &scalar_kernels;
+#ifdef STR_X86
+  case ANI_STR_ISA_SSE2:
+    return &sse2_kernels;
+#endif
+#ifdef STR_AVX2
+  case ANI_STR_ISA_AVX2:
+    return __builtin_cpu_supports("avx2") ? &avx2_kernels : NULL;
+#endif
+#ifdef STR_NEON
+  case ANI_STR_ISA_NEON:
+    return &neon_kernels;
+#endif
+  default:
+    return NULL;
+  }
+}
+
+static const str_kernels *detect_kernels(void) {
+#if defined(STR_AVX2)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return &avx2_kernels;
+  }
+#endif
+#if defined(STR_X86)
+  return &sse2_kernels; // Baseline on x86-64
+#elif defined(STR_NEON)
+  return &neon_kernels;
+#else
+  return &scalar_kernels;
+#endif
+}
+
+// Detection is idempotent, so racing first calls just store the same value
+static const str_kernels *kernels(void) {
+  const str_kernels *k;
+
+#if defined(__GNUC__) || defined(__clang__)
+  k = __atomic_load_n(&active_kernels, __ATOMIC_ACQUIRE);
+  if (k == NULL) {
+    k = detect_kernels();
+    __atomic_store_n(&active_kernels, k, __ATOMIC_RELEASE);
+  }
+#else
+  k = active_kernels;
+  if (k == NULL) {
+    k = detect_kernels();
+    active_kernels = k;
+  }
+#endif
+
+  return k;
+}
+
+ani_str_isa ani_str_get_isa(void) { return kernels()->isa; }
+
+bool ani_str_set_isa(ani_str_isa isa) {
+  const str_kernels *k;
+
+  kernels(); // Run detection (and __builtin_cpu_init) first
+  k = kernels_for(isa);
+  if (k == NULL) {
+    return false;
+  }
+
+#if defined(__GNUC__) || defined(__clang__)
+  __atomic_store_n(&active_kernels, k, __ATOMIC_RELEASE);
+#else
+  active_kernels = k;
+#endif
+
+  return true;
+}
+
+const char *ani_str_isa_name(ani_str_isa isa) {
+  switch (isa) {
+  case ANI_STR_ISA_SCALAR:
+    return "scalar";
+  case ANI_STR_ISA_SSE2:
+    return "sse2";
+  case ANI_STR_ISA_AVX2:
+    return "avx2";
+  case ANI_STR_ISA_NEON:
+    return "neon";
+  default:
+    return "unknown";
+  }
+}
+
+// --- String functions ---
+
 size_t ani_strlcpy(char *dst, const char *src, size_t size) {
   size_t src_len;
 
@@ -46,7 +636,7 @@ char *ani_str_trim(char *str) {
   char *end;
 
   // Trim leading space
-  while (isspace((unsigned char)*str)) {
+  while (IS_SPACE(*str)) {
     str++;
   }
 
@@ -56,7 +646,7 @@ char *ani_str_trim(char *str) {
 
   // Trim trailing space
   end = str + strlen(str) - 1;
-  while (end > str && isspace((unsigned char)*end)) {
+  while (end > str && IS_SPACE(*end)) {
     end--;
   }
 
@@ -65,35 +655,182 @@ char *ani_str_trim(char *str) {
   return str;
 }
 
-int ani_strcasecmp(const char *s1, const char *s2) {
-  while (*s1 && *s2) {
-    int c1 = tolower((unsigned char)*s1);
-    int c2 = tolower((unsigned char)*s2);
-    if (c1 != c2) {
-      return c1 - c2;
+size_t ani_str_collapse_ws(char *str) {
+  const str_kernels *k;
+  size_t len;
+  size_t r;
+  size_t w;
+  size_t run;
+
+  if (str == NULL) {
+    return 0;
+  }
+
+  k = kernels();
+  len = strlen(str);
+  r = 0;
+  w = 0;
+  while (r < len) {
+    while (r < len && IS_SPACE(str[r])) {
+      r++;
+    }
+    if (r == len) {
+      break;
+    }
+
+    if (w > 0) {
+      str[w++] = ' ';
     }
-    s1++;
-    s2++;
+    run = k->word_run(str + r, len - r);
+    memmove(str + w, str + r, run);
+    w += run;
+    r += run;
   }
 
-  return tolower((unsigned char)*s1) - tolower((unsigned char)*s2);
+  str[w] = '\0';
+  return w;
+}
+
+void ani_str_fold(char *dst, const char *src, size_t n) {
+  if (dst == NULL || src == NULL) {
+    return;
+  }
+
+  kernels()->fold(dst, src, n);
+}
+
+int ani_strcasecmp(const char *s1, const char *s2) {
+  size_t len1;
+  size_t len2;
+  size_t n;
+  size_t i;
+
+  len1 = strlen(s1);
+  len2 = strlen(s2);
+  n = len1 < len2 ? len1 : len2;
+
+  // Includes the terminator of the shorter string when the prefix matches
+  i = kernels()->fold_eq_run(s1, s2, n);
+
+  return (int)FOLD(s1[i]) - (int)FOLD(s2[i]);
 }
 
 int ani_strncasecmp(const char *s1, const char *s2, size_t n) {
+  const char *end1;
+  const char *end2;
+  size_t len1;
+  size_t len2;
+  size_t limit;
   size_t i;
 
-  for (i = 0; i < n; i++) {
-    int c1 = tolower((unsigned char)s1[i]);
-    int c2 = tolower((unsigned char)s2[i]);
-    if (c1 != c2) {
-      return c1 - c2;
-    }
-    if (s1[i] == '\0') {
+  // Never look past n bytes (the inputs need not be terminated within n)
+  end1 = memchr(s1, '\0', n);
+  end2 = memchr(s2, '\0', n);
+  len1 = end1 != NULL ? (size_t)(end1 - s1) : n;
+  len2 = end2 != NULL ? (size_t)(end2 - s2) : n;
+  limit = len1 < len2 ? len1 : len2;
+
+  i = kernels()->fold_eq_run(s1, s2, limit);
+  if (i == n) {
+    return 0;
+  }
+
+  return (int)FOLD(s1[i]) - (int)FOLD(s2[i]);
+}
+
+bool ani_utf8_valid(const char *s, size_t len) {
+  const str_kernels *k;
+  const unsigned char *p;
+  unsigned char cls;
+  unsigned char lo;
+  unsigned char hi;
+  size_t i;
+  size_t need;
+  size_t j;
+
+  if (s == NULL) {
+    return false;
+  }
+
+  k = kernels();
+  p = (const unsigned char *)s;
+  i = 0;
+  while (i < len) {
+    // Skip ASCII runs a vector at a time
+    i += k->ascii_run(s + i, len - i);
+    if (i == len) {
       break;
     }
+
+    cls = char_class[p[i]];
+    need = (cls & CLS_LEAD2) ? 1 : (cls & CLS_LEAD3) ? 2 : (cls & CLS_LEAD4) ? 3 : 0;
+    if (need == 0 || len - i <= need) {
+      return false;
+    }
+
+    // Second-byte ranges rule out overlongs, surrogates and > U+10FFFF
+    lo = 0x80;
+    hi = 0xBF;
+    if (p[i] == 0xE0) {
+      lo = 0xA0;
+    } else if (p[i] == 0xED) {
+      hi = 0x9F;
+    } else if (p[i] == 0xF0) {
+      lo = 0x90;
+    } else if (p[i] == 0xF4) {
+      hi = 0x8F;
+    }
+    if (p[i + 1] < lo || p[i + 1] > hi) {
+      return false;
+    }
+    for (j = 2; j <= need; j++) {
+      if ((p[i + j] & 0xC0) != 0x80) {
+        return false;
+      }
+    }
+
+    i += need + 1;
   }
 
-  return 0;
+  return true;
+}
+
+bool ani_str_is_decimal_id(const char *s) {
+  size_t i;
+
+  if (s == NULL || s[0] == '\0') {
+    return false;
+  }
+
+  for (i = 0; s[i] != '\0'; i++) {
+    if (i >= 10 || s[i] < '0' || s[i] > '9') {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool ani_str_is_uuid(const char *s) {
+  size_t i;
+
+  if (s == NULL) {
+    return false;
+  }
+
+  // Stops at the terminator of a shorter string
+  for (i = 0; i < 36; i++) {
+    if (i == 8 || i == 13 || i == 18 || i == 23) {
+      if (s[i] != '-') {
+        return false;
+      }
+    } else if (!((s[i] >= '0' && s[i] <= '9') ||
+                 (s[i] >= 'a' && s[i] <= 'f'))) {
+      return false;
+    }
+  }
+
+  return s[36] == '\0';
 }
 
 char *ani_strdup(const char *s) {
@@ -105,7 +842,7 @@ char *ani_strdup(const char *s) {
   }
 
   len = strlen(s);
-  copy = malloc(len + 1);
+  copy = ani_malloc(len + 1);
   if (copy == NULL) {
     return NULL;
   }
@@ -135,7 +872,7 @@ char *ani_str_join(const char **parts, size_t count, const char *sep) {
     }
   }
 
-  result = malloc(total_len + 1);
+  result = ani_malloc(total_len + 1);
   if (result == NULL) {
     return NULL;
   }
@@ -163,7 +900,7 @@ char *ani_readline(void) {
   int c;
 
   size = 128;
-  buf = malloc(size);
+  buf = ani_malloc(size);
   if (buf == NULL) {
     return NULL;
   }
@@ -172,9 +909,9 @@ char *ani_readline(void) {
   while ((c = fgetc(stdin)) != EOF && c != '\n') {
     if (len + 1 >= size) {
       size *= 2;
-      char *new_buf = realloc(buf, size);
+      char *new_buf = ani_realloc(buf, size);
       if (new_buf == NULL) {
-        free(buf);
+        ani_free(buf);
         return NULL;
       }
       buf = new_buf;
@@ -185,3 +922,50 @@ char *ani_readline(void) {
   buf[len] = '\0';
   return buf;
 }
+
+char *ani_url_encode(const char *str) {
+  static const char hex[] = "0123456789ABCDEF";
+  const str_kernels *k;
+  size_t len;
+  size_t i;
+  size_t j;
+  size_t run;
+  char *encoded;
+
+  if (str == NULL) {
+    return NULL;
+  }
+
+  len = strlen(str);
+  // Worst case: every char becomes %XX (3x expansion)
+  encoded = ani_malloc(len * 3 + 1);
+  if (encoded == NULL) {
+    return NULL;
+  }
+
+  k = kernels();
+  i = 0;
+  j = 0;
+  while (i < len) {
+    // Copy safe runs whole; only the bytes between them are encoded
+    run = k->url_safe_run(str + i, len - i);
+    memcpy(encoded + j, str + i, run);
+    i += run;
+    j += run;
+
+    while (i < len && !(char_class[(unsigned char)str[i]] & CLS_URL_SAFE)) {
+      unsigned char c = (unsigned char)str[i++];
+
+      if (c == ' ') {
+        encoded[j++] = '+';
+      } else {
+        encoded[j++] = '%';
+        encoded[j++] = hex[c >> 4];
+        encoded[j++] = hex[c & 0xF];
+      }
+    }
+  }
+  encoded[j] = '\0';
+
+  return encoded;
+}
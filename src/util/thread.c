@@ -0,0 +1,136 @@
+/*
+ * Routine: ani — Anime/Manga scheduling information CLI
+ * Author: DannyBimma
+ * Copyright: (c) 2025 Technomancer Pirate Captain. All Rights Reserved.
+ */
+
+#include "ani/thread.h"
+#ifndef _WIN32
+#include <errno.h>
+#include <time.h>
+#endif
+
+void ani_mutex_init(ani_mutex *mutex) {
+#ifdef _WIN32
+  InitializeCriticalSection(mutex);
+#else
+  pthread_mutex_init(mutex, NULL);
+#endif
+}
+
+void ani_mutex_destroy(ani_mutex *mutex) {
+#ifdef _WIN32
+  DeleteCriticalSection(mutex);
+#else
+  pthread_mutex_destroy(mutex);
+#endif
+}
+
+void ani_mutex_lock(ani_mutex *mutex) {
+#ifdef _WIN32
+  EnterCriticalSection(mutex);
+#else
+  pthread_mutex_lock(mutex);
+#endif
+}
+
+void ani_mutex_unlock(ani_mutex *mutex) {
+#ifdef _WIN32
+  LeaveCriticalSection(mutex);
+#else
+  pthread_mutex_unlock(mutex);
+#endif
+}
+
+void ani_cond_init(ani_cond *cond) {
+#ifdef _WIN32
+  InitializeConditionVariable(cond);
+#else
+  pthread_cond_init(cond, NULL);
+#endif
+}
+
+void ani_cond_destroy(ani_cond *cond) {
+#ifdef _WIN32
+  (void)cond;
+#else
+  pthread_cond_destroy(cond);
+#endif
+}
+
+void ani_cond_broadcast(ani_cond *cond) {
+#ifdef _WIN32
+  WakeAllConditionVariable(cond);
+#else
+  pthread_cond_broadcast(cond);
+#endif
+}
+
+bool ani_cond_wait_ms(ani_cond *cond, ani_mutex *mutex, long timeout_ms) {
+#ifdef _WIN32
+  return SleepConditionVariableCS(cond, mutex,
+                                  timeout_ms < 0 ? INFINITE
+                                                 : (DWORD)timeout_ms) != 0;
+#else
+  struct timespec deadline;
+
+  if (timeout_ms < 0) {
+    return pthread_cond_wait(cond, mutex) == 0;
+  }
+
+  // pthread deadlines are absolute CLOCK_REALTIME
+  clock_gettime(CLOCK_REALTIME, &deadline);
+  deadline.tv_sec += timeout_ms / 1000;
+  deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+  if (deadline.tv_nsec >= 1000000000L) {
+    deadline.tv_sec++;
+    deadline.tv_nsec -= 1000000000L;
+  }
+
+  return pthread_cond_timedwait(cond, mutex, &deadline) != ETIMEDOUT;
+#endif
+}
+
+#ifdef _WIN32
+static DWORD WINAPI thread_main(LPVOID param) {
+  ani_thread *thread = param;
+
+  thread->fn(thread->arg);
+  return 0;
+}
+#else
+static void *thread_main(void *param) {
+  ani_thread *thread = param;
+
+  thread->fn(thread->arg);
+  return NULL;
+}
+#endif
+
+bool ani_thread_start(ani_thread *thread, void (*fn)(void *arg), void *arg) {
+  if (thread == NULL || fn == NULL) {
+    return false;
+  }
+
+  thread->fn = fn;
+  thread->arg = arg;
+#ifdef _WIN32
+  thread->handle = CreateThread(NULL, 0, thread_main, thread, 0, NULL);
+  return thread->handle != NULL;
+#else
+  return pthread_create(&thread->handle, NULL, thread_main, thread) == 0;
+#endif
+}
+
+void ani_thread_join(ani_thread *thread) {
+  if (thread == NULL) {
+    return;
+  }
+
+#ifdef _WIN32
+  WaitForSingleObject(thread->handle, INFINITE);
+  CloseHandle(thread->handle);
+#else
+  pthread_join(thread->handle, NULL);
+#endif
+}
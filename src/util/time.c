@@ -5,16 +5,121 @@
  */
 
 #include "ani/time.h"
-#include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// Fixed-position ISO-8601:
+//   0         1         2
+//   0123456789012345678901234
+//   YYYY-MM-DD
+//   YYYY-MM-DDThh:mm[:ss[.fff]][Z|+hh:mm|+hhmm|+hh]
+#define DIGIT(c) ((unsigned)((unsigned char)(c) - '0'))
+#define DATE_DIGITS 0x036Fu     // Bits 0-3, 5-6, 8-9
+#define DATETIME_DIGITS 0xDB6Fu // Date digits plus 11-12 and 14-15
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ANI_TIME_SIMD 1
+
+// Bit i set when s[i] is an ASCII digit; s must have 16 readable bytes
+static unsigned digit_mask16(const char *s) {
+  __m128i v;
+  __m128i d;
+  __m128i le9;
+
+  v = _mm_loadu_si128((const __m128i *)(const void *)s);
+  d = _mm_sub_epi8(v, _mm_set1_epi8('0'));
+  le9 = _mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(9)), d);
+
+  return (unsigned)_mm_movemask_epi8(le9);
+}
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define ANI_TIME_SIMD 1
+
+static unsigned digit_mask16(const char *s) {
+  static const uint8_t weights[16] = {1, 2, 4, 8, 16, 32, 64, 128,
+                                      1, 2, 4, 8, 16, 32, 64, 128};
+  uint8x16_t d;
+  uint8x16_t bits;
+
+  d = vsubq_u8(vld1q_u8((const uint8_t *)s), vdupq_n_u8('0'));
+  bits = vandq_u8(vcleq_u8(d, vdupq_n_u8(9)), vld1q_u8(weights));
+
+  return (unsigned)vaddv_u8(vget_low_u8(bits)) |
+         (unsigned)vaddv_u8(vget_high_u8(bits)) << 8;
+}
+#endif
+
+// Scalar digit mask over the first n (<= 16) bytes
+static unsigned digit_mask_scalar(const char *s, size_t n) {
+  unsigned mask;
+  size_t i;
+
+  mask = 0;
+  for (i = 0; i < n; i++) {
+    mask |= (unsigned)(DIGIT(s[i]) <= 9) << i;
+  }
+
+  return mask;
+}
+
+// strlen capped at max (the parser never looks further)
+static size_t bounded_len(const char *s, size_t max) {
+  size_t len;
+
+  len = 0;
+  while (len < max && s[len] != '\0') {
+    len++;
+  }
+
+  return len;
+}
+
+static int two_digits(const char *s) {
+  return (int)(DIGIT(s[0]) * 10 + DIGIT(s[1]));
+}
+
+// Parse [Z|+hh:mm|+hhmm|+hh] at p into *offset; unknown suffixes leave it
+// at 0. False for an offset out of range (hh > 23 or mm > 59).
+static bool parse_offset(const char *p, int *offset) {
+  int hours;
+  int minutes;
+
+  *offset = 0;
+  if (*p != '+' && *p != '-') {
+    return true;
+  }
+  if (DIGIT(p[1]) > 9 || DIGIT(p[2]) > 9) {
+    return true;
+  }
+
+  hours = two_digits(p + 1);
+  minutes = 0;
+  if (p[3] == ':' && DIGIT(p[4]) <= 9 && DIGIT(p[5]) <= 9) {
+    minutes = two_digits(p + 4);
+  } else if (DIGIT(p[3]) <= 9 && DIGIT(p[4]) <= 9) {
+    minutes = two_digits(p + 3);
+  }
+  if (hours > 23 || minutes > 59) {
+    return false;
+  }
+
+  minutes += hours * 60;
+  *offset = *p == '-' ? -minutes : minutes;
+
+  return true;
+}
 
 bool ani_parse_iso8601(const char *str, ani_date *out) {
-  int n;
-  char tz_sign;
-  int tz_hours;
-  int tz_minutes;
+  const char *p;
+  unsigned mask;
+  size_t len;
 
   if (str == NULL || out == NULL) {
     return false;
@@ -24,103 +129,223 @@ bool ani_parse_iso8601(const char *str, ani_date *out) {
   out->hour = -1;
   out->minute = -1;
   out->second = -1;
-  out->offset_minutes = 0;
-  out->has_time = false;
-
-  // Try YYYY-MM-DD format first
-  n = sscanf(str, "%d-%d-%d", &out->year, &out->month, &out->day);
-  if (n == 3) {
-    // Validate date
-    if (out->year < 1900 || out->year > 2100 || out->month < 1 ||
-        out->month > 12 || out->day < 1 || out->day > 31) {
-      return false;
-    }
 
-    // Check for time component
-    const char *t_pos = strchr(str, 'T');
-    if (t_pos == NULL) {
-      return true;
-    }
+  len = bounded_len(str, 16);
+  if (len < 10) {
+    return false;
+  }
 
-    t_pos++; // Skip 'T'
-
-    // Parse time: hh:mm:ss
-    n = sscanf(t_pos, "%d:%d:%d", &out->hour, &out->minute, &out->second);
-    if (n >= 2) {
-      out->has_time = true;
-      if (n == 2) {
-        out->second = 0;
-      }
-
-      // Validate time
-      if (out->hour < 0 || out->hour > 23 || out->minute < 0 ||
-          out->minute > 59 || out->second < 0 || out->second > 59) {
-        return false;
-      }
-
-      // Check for timezone
-      const char *tz_pos = strpbrk(t_pos, "Zz+-");
-      if (tz_pos != NULL) {
-        if (*tz_pos == 'Z' || *tz_pos == 'z') {
-          out->offset_minutes = 0;
-        } else {
-          tz_sign = *tz_pos;
-          n = sscanf(tz_pos + 1, "%d:%d", &tz_hours, &tz_minutes);
-          if (n >= 1) {
-            out->offset_minutes = tz_hours * 60;
-            if (n == 2) {
-              out->offset_minutes += tz_minutes;
-            }
-            if (tz_sign == '-') {
-              out->offset_minutes = -out->offset_minutes;
-            }
-          }
-        }
-      }
-    }
+  // One digit check covers the date and, when present, hh:mm
+#ifdef ANI_TIME_SIMD
+  mask = len == 16 ? digit_mask16(str) : digit_mask_scalar(str, len);
+#else
+  mask = digit_mask_scalar(str, len);
+#endif
+  if ((mask & DATE_DIGITS) != DATE_DIGITS || str[4] != '-' || str[7] != '-') {
+    return false;
+  }
+
+  out->year = two_digits(str) * 100 + two_digits(str + 2);
+  out->month = two_digits(str + 5);
+  out->day = two_digits(str + 8);
+  if (out->year < 1900 || out->year > 2100 || out->month < 1 ||
+      out->month > 12 || out->day < 1 || out->day > 31) {
+    return false;
+  }
 
+  if (DIGIT(str[10]) <= 9) {
+    return false;
+  }
+
+  // Date only, or a time part we can't read (kept as a plain date)
+  if (len < 16 || (str[10] != 'T' && str[10] != 't') ||
+      (mask & DATETIME_DIGITS) != DATETIME_DIGITS || str[13] != ':') {
     return true;
   }
 
-  return false;
+  out->hour = two_digits(str + 11);
+  out->minute = two_digits(str + 14);
+  out->second = 0;
+  p = str + 16;
+  if (p[0] == ':' && DIGIT(p[1]) <= 9 && DIGIT(p[2]) <= 9) {
+    out->second = two_digits(p + 1);
+    p += 3;
+  }
+  if (DIGIT(*p) <= 9 || out->hour > 23 || out->minute > 59 ||
+      out->second > 59) {
+    return false;
+  }
+
+  // Fractional seconds are dropped
+  if (*p == '.') {
+    p++;
+    while (DIGIT(*p) <= 9) {
+      p++;
+    }
+  }
+
+  if (!parse_offset(p, &out->offset_minutes)) {
+    return false;
+  }
+  out->has_time = true;
+
+  return true;
 }
 
-bool ani_parse_unix_timestamp(long timestamp, ani_date *out) {
-  time_t t;
-  struct tm *tm_info;
+// Days since 1970-01-01 for a proleptic Gregorian date
+static int64_t days_from_civil(int64_t year, int month, int day) {
+  int64_t era;
+  int64_t yoe;
+  int64_t doy;
+  int64_t doe;
 
-  if (out == NULL) {
+  year -= month <= 2;
+  era = (year >= 0 ? year : year - 399) / 400;
+  yoe = year - era * 400;
+  doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+  doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+  return era * 146097 + doe - 719468;
+}
+
+// Inverse of days_from_civil
+static void civil_from_days(int64_t days, int *year, int *month, int *day) {
+  int64_t era;
+  int64_t doe;
+  int64_t yoe;
+  int64_t doy;
+  int64_t mp;
+
+  days += 719468;
+  era = (days >= 0 ? days : days - 146096) / 146097;
+  doe = days - era * 146097;
+  yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  mp = (5 * doy + 2) / 153;
+
+  *day = (int)(doy - (153 * mp + 2) / 5 + 1);
+  *month = (int)(mp < 10 ? mp + 3 : mp - 9);
+  *year = (int)(yoe + era * 400 + (*month <= 2));
+}
+
+bool ani_date_to_instant(const ani_date *date, ani_instant *out) {
+  int64_t epoch;
+
+  if (date == NULL || out == NULL || date->month < 1 || date->month > 12) {
     return false;
   }
 
-  t = (time_t)timestamp;
-  tm_info = gmtime(&t);
-  if (tm_info == NULL) {
+  epoch = days_from_civil(date->year, date->month, date->day) * 86400;
+  if (date->has_time) {
+    epoch += (int64_t)date->hour * 3600 + date->minute * 60 + date->second;
+    epoch -= (int64_t)date->offset_minutes * 60;
+  }
+
+  out->epoch = epoch;
+  out->offset_minutes = date->has_time ? (int16_t)date->offset_minutes : 0;
+  out->has_time = date->has_time;
+
+  return true;
+}
+
+void ani_instant_to_date(const ani_instant *instant, ani_date *out) {
+  int64_t local;
+  int64_t days;
+  int64_t secs;
+
+  if (instant == NULL || out == NULL) {
+    return;
+  }
+
+  local = instant->epoch + (int64_t)instant->offset_minutes * 60;
+  days = local / 86400;
+  secs = local % 86400;
+  if (secs < 0) {
+    secs += 86400;
+    days--;
+  }
+
+  civil_from_days(days, &out->year, &out->month, &out->day);
+  out->offset_minutes = instant->offset_minutes;
+  out->has_time = instant->has_time;
+  if (instant->has_time) {
+    out->hour = (int)(secs / 3600);
+    out->minute = (int)(secs / 60 % 60);
+    out->second = (int)(secs % 60);
+  } else {
+    out->hour = -1;
+    out->minute = -1;
+    out->second = -1;
+  }
+}
+
+bool ani_parse_instant(const char *str, ani_instant *out) {
+  ani_date date;
+
+  if (!ani_parse_iso8601(str, &date)) {
     return false;
   }
 
-  out->year = tm_info->tm_year + 1900;
-  out->month = tm_info->tm_mon + 1;
-  out->day = tm_info->tm_mday;
-  out->hour = tm_info->tm_hour;
-  out->minute = tm_info->tm_min;
-  out->second = tm_info->tm_sec;
-  out->offset_minutes = 0; // UTC
-  out->has_time = true;
+  return ani_date_to_instant(&date, out);
+}
+
+bool ani_parse_unix_timestamp(long timestamp, ani_date *out) {
+  ani_instant instant;
+
+  if (out == NULL) {
+    return false;
+  }
+
+  instant.epoch = timestamp;
+  instant.offset_minutes = 0; // UTC
+  instant.has_time = true;
+  ani_instant_to_date(&instant, out);
 
   return true;
 }
 
+// Write a zero-padded decimal of width digits
+static char *put_digits(char *p, int value, int width) {
+  int i;
+
+  for (i = width - 1; i >= 0; i--) {
+    p[i] = (char)('0' + value % 10);
+    value /= 10;
+  }
+
+  return p + width;
+}
+
+// Fields the fast formatters can write without snprintf
+static bool date_is_plain(const ani_date *date) {
+  return date->year >= 0 && date->year <= 9999 && date->month >= 0 &&
+         date->month <= 99 && date->day >= 0 && date->day <= 99;
+}
+
 void ani_format_date(const ani_date *date, char *buf, size_t size) {
+  char *p;
+
   if (date == NULL || buf == NULL || size == 0) {
     return;
   }
 
-  snprintf(buf, size, "%04d-%02d-%02d", date->year, date->month, date->day);
+  if (size < 11 || !date_is_plain(date)) {
+    snprintf(buf, size, "%04d-%02d-%02d", date->year, date->month, date->day);
+
+    return;
+  }
+
+  p = put_digits(buf, date->year, 4);
+  *p++ = '-';
+  p = put_digits(p, date->month, 2);
+  *p++ = '-';
+  p = put_digits(p, date->day, 2);
+  *p = '\0';
 }
 
 void ani_format_datetime(const ani_date *date, char *buf, size_t size) {
-  char offset_str[16];
+  int abs_offset;
+  char *p;
 
   if (date == NULL || buf == NULL || size == 0) {
     return;
@@ -132,18 +357,88 @@ void ani_format_datetime(const ani_date *date, char *buf, size_t size) {
     return;
   }
 
+  abs_offset =
+      date->offset_minutes < 0 ? -date->offset_minutes : date->offset_minutes;
+
+  // Longest form: YYYY-MM-DDThh:mm:ss+hh:mm
+  if (size < 26 || !date_is_plain(date) || date->hour > 99 ||
+      date->minute < 0 || date->minute > 99 || date->second < 0 ||
+      date->second > 99 || abs_offset >= 100 * 60) {
+    char offset_str[16];
+
+    if (date->offset_minutes == 0) {
+      snprintf(offset_str, sizeof(offset_str), "Z");
+    } else {
+      snprintf(offset_str, sizeof(offset_str), "%c%02d:%02d",
+               date->offset_minutes < 0 ? '-' : '+', abs_offset / 60,
+               abs_offset % 60);
+    }
+    snprintf(buf, size, "%04d-%02d-%02dT%02d:%02d:%02d%s", date->year,
+             date->month, date->day, date->hour, date->minute, date->second,
+             offset_str);
+
+    return;
+  }
+
+  ani_format_date(date, buf, size);
+  p = buf + 10;
+  *p++ = 'T';
+  p = put_digits(p, date->hour, 2);
+  *p++ = ':';
+  p = put_digits(p, date->minute, 2);
+  *p++ = ':';
+  p = put_digits(p, date->second, 2);
   if (date->offset_minutes == 0) {
-    snprintf(offset_str, sizeof(offset_str), "Z");
+    *p++ = 'Z';
   } else {
-    int abs_offset =
-        date->offset_minutes < 0 ? -date->offset_minutes : date->offset_minutes;
-    int hours = abs_offset / 60;
-    int minutes = abs_offset % 60;
-    snprintf(offset_str, sizeof(offset_str), "%c%02d:%02d",
-             date->offset_minutes < 0 ? '-' : '+', hours, minutes);
+    *p++ = date->offset_minutes < 0 ? '-' : '+';
+    p = put_digits(p, abs_offset / 60, 2);
+    *p++ = ':';
+    p = put_digits(p, abs_offset % 60, 2);
+  }
+  *p = '\0';
+}
+
+void ani_format_instant(const ani_instant *instant, char *buf, size_t size) {
+  ani_date date;
+
+  if (instant == NULL) {
+    return;
+  }
+
+  ani_instant_to_date(instant, &date);
+  ani_format_datetime(&date, buf, size);
+}
+
+int64_t ani_monotonic_us(void) {
+#ifdef _WIN32
+  LARGE_INTEGER freq;
+  LARGE_INTEGER counter;
+
+  QueryPerformanceFrequency(&freq);
+  QueryPerformanceCounter(&counter);
+
+  return (int64_t)(counter.QuadPart * 1000000 / freq.QuadPart);
+#else
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (int64_t)ts.tv_sec * 1000000 + (int64_t)ts.tv_nsec / 1000;
+#endif
+}
+
+void ani_sleep_ms(long ms) {
+  if (ms <= 0) {
+    return;
   }
 
-  snprintf(buf, size, "%04d-%02d-%02dT%02d:%02d:%02d%s", date->year,
-           date->month, date->day, date->hour, date->minute, date->second,
-           offset_str);
+#ifdef _WIN32
+  Sleep((DWORD)ms);
+#else
+  struct timespec ts;
+  ts.tv_sec = ms / 1000;
+  ts.tv_nsec = (ms % 1000) * 1000000L;
+  nanosleep(&ts, NULL);
+#endif
 }
@@ -0,0 +1,283 @@
+/*
+ * Routine: ani — Anime/Manga scheduling information CLI
+ * Author: DannyBimma
+ * Copyright: (c) 2025 Technomancer Pirate Captain. All Rights Reserved.
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE // RUSAGE_THREAD
+#endif
+
+#include "ani/trace.h"
+#include "ani/alloc.h"
+#include "ani/log.h"
+#include "ani/str.h"
+#include "ani/time.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <process.h>
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+// Completed span
+typedef struct {
+  const char *name;
+  const char *category;
+  char *detail;
+  int64_t ts_us;
+  int64_t dur_us;
+  unsigned long tid;
+  int64_t cpu_user_us;
+  int64_t cpu_sys_us;
+  long max_rss_kb;
+  long max_rss_delta_kb;
+  long minor_faults;
+  long major_faults;
+} ani_trace_event;
+
+bool ani_trace_active = false;
+
+static char *trace_path = NULL;
+static ani_trace_event *events = NULL;
+static size_t event_count = 0;
+static size_t event_capacity = 0;
+
+#ifdef _WIN32
+static CRITICAL_SECTION events_lock;
+#define EVENTS_LOCK() EnterCriticalSection(&events_lock)
+#define EVENTS_UNLOCK() LeaveCriticalSection(&events_lock)
+#else
+static pthread_mutex_t events_lock = PTHREAD_MUTEX_INITIALIZER;
+#define EVENTS_LOCK() pthread_mutex_lock(&events_lock)
+#define EVENTS_UNLOCK() pthread_mutex_unlock(&events_lock)
+#endif
+
+static unsigned long current_tid(void) {
+#if defined(_WIN32)
+  return (unsigned long)GetCurrentThreadId();
+#elif defined(__linux__)
+  return (unsigned long)syscall(SYS_gettid);
+#elif defined(__APPLE__)
+  uint64_t tid;
+
+  pthread_threadid_np(NULL, &tid);
+  return (unsigned long)tid;
+#else
+  return (unsigned long)getpid();
+#endif
+}
+
+// Snapshot resource usage of the calling thread (process-wide if unavailable)
+static void usage_snapshot(ani_trace_span *span) {
+#ifdef _WIN32
+  span->cpu_user_us = 0;
+  span->cpu_sys_us = 0;
+  span->max_rss_kb = 0;
+  span->minor_faults = 0;
+  span->major_faults = 0;
+#else
+  struct rusage ru;
+
+#ifdef RUSAGE_THREAD
+  if (getrusage(RUSAGE_THREAD, &ru) != 0) {
+    getrusage(RUSAGE_SELF, &ru);
+  }
+#else
+  getrusage(RUSAGE_SELF, &ru);
+#endif
+
+  span->cpu_user_us =
+      (int64_t)ru.ru_utime.tv_sec * 1000000 + (int64_t)ru.ru_utime.tv_usec;
+  span->cpu_sys_us =
+      (int64_t)ru.ru_stime.tv_sec * 1000000 + (int64_t)ru.ru_stime.tv_usec;
+#ifdef __APPLE__
+  span->max_rss_kb = ru.ru_maxrss / 1024; // Bytes on macOS
+#else
+  span->max_rss_kb = ru.ru_maxrss;
+#endif
+  span->minor_faults = ru.ru_minflt;
+  span->major_faults = ru.ru_majflt;
+#endif
+}
+
+bool ani_trace_start(const char *path) {
+  if (path == NULL || path[0] == '\0') {
+    return false;
+  }
+
+#ifdef _WIN32
+  InitializeCriticalSection(&events_lock);
+#endif
+
+  ani_free(trace_path);
+  trace_path = ani_strdup(path);
+  if (trace_path == NULL) {
+    return false;
+  }
+
+  ani_trace_active = true;
+  LOG_DEBUG("Tracing to %s", trace_path);
+
+  return true;
+}
+
+void ani_trace_span_begin(ani_trace_span *span, const char *name,
+                          const char *category) {
+  span->name = name;
+  span->category = category;
+  span->detail = NULL;
+  usage_snapshot(span);
+  span->start_us = ani_monotonic_us();
+}
+
+void ani_trace_span_end(ani_trace_span *span) {
+  ani_trace_span end;
+  ani_trace_event *ev;
+  int64_t now;
+
+  now = ani_monotonic_us();
+  if (!ani_trace_active || span->start_us == 0) {
+    return;
+  }
+
+  usage_snapshot(&end);
+
+  // Tracing may have stopped since the check above
+  EVENTS_LOCK();
+  if (!ani_trace_active) {
+    EVENTS_UNLOCK();
+
+    return;
+  }
+  if (event_count == event_capacity) {
+    size_t new_capacity = event_capacity == 0 ? 64 : event_capacity * 2;
+    ani_trace_event *new_events =
+        ani_realloc(events, new_capacity * sizeof(*new_events));
+    if (new_events == NULL) {
+      EVENTS_UNLOCK();
+
+      return;
+    }
+
+    events = new_events;
+    event_capacity = new_capacity;
+  }
+
+  ev = &events[event_count++];
+  ev->name = span->name;
+  ev->category = span->category;
+  ev->detail = span->detail != NULL ? ani_strdup(span->detail) : NULL;
+  ev->ts_us = span->start_us;
+  ev->dur_us = now - span->start_us;
+  ev->tid = current_tid();
+  ev->cpu_user_us = end.cpu_user_us - span->cpu_user_us;
+  ev->cpu_sys_us = end.cpu_sys_us - span->cpu_sys_us;
+  ev->max_rss_kb = end.max_rss_kb;
+  ev->max_rss_delta_kb = end.max_rss_kb - span->max_rss_kb;
+  ev->minor_faults = end.minor_faults - span->minor_faults;
+  ev->major_faults = end.major_faults - span->major_faults;
+  EVENTS_UNLOCK();
+
+  span->start_us = 0;
+}
+
+// Write a JSON string literal with minimal escaping
+static void write_json_string(FILE *f, const char *s) {
+  fputc('"', f);
+  for (; *s != '\0'; s++) {
+    unsigned char c = (unsigned char)*s;
+    if (c == '"' || c == '\\') {
+      fputc('\\', f);
+      fputc(c, f);
+    } else if (c < 0x20) {
+      fprintf(f, "\\u%04x", c);
+    } else {
+      fputc(c, f);
+    }
+  }
+  fputc('"', f);
+}
+
+bool ani_trace_stop(void) {
+  FILE *f;
+  ani_trace_event *stopped;
+  size_t count;
+  size_t i;
+  long pid;
+  bool ok;
+
+  if (!ani_trace_active) {
+    return false;
+  }
+
+  // Take the events; spans still ending on other threads are dropped
+  EVENTS_LOCK();
+  ani_trace_active = false;
+  stopped = events;
+  count = event_count;
+  events = NULL;
+  event_count = 0;
+  event_capacity = 0;
+  EVENTS_UNLOCK();
+
+#ifdef _WIN32
+  pid = (long)_getpid();
+#else
+  pid = (long)getpid();
+#endif
+
+  ok = false;
+  f = fopen(trace_path, "w");
+  if (f == NULL) {
+    LOG_ERROR("Failed to open trace file: %s", trace_path);
+  } else {
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    for (i = 0; i < count; i++) {
+      const ani_trace_event *ev = &stopped[i];
+
+      fprintf(f, "%s\n{\"name\":", i == 0 ? "" : ",");
+      write_json_string(f, ev->name);
+      fprintf(f, ",\"cat\":");
+      write_json_string(f, ev->category);
+      fprintf(f,
+              ",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,\"pid\":%ld,"
+              "\"tid\":%lu,\"args\":{",
+              (long long)ev->ts_us, (long long)ev->dur_us, pid, ev->tid);
+      if (ev->detail != NULL) {
+        fprintf(f, "\"detail\":");
+        write_json_string(f, ev->detail);
+        fputc(',', f);
+      }
+      fprintf(f,
+              "\"cpu_user_us\":%lld,\"cpu_sys_us\":%lld,\"max_rss_kb\":%ld,"
+              "\"max_rss_delta_kb\":%ld,\"minor_faults\":%ld,"
+              "\"major_faults\":%ld}}",
+              (long long)ev->cpu_user_us, (long long)ev->cpu_sys_us,
+              ev->max_rss_kb, ev->max_rss_delta_kb, ev->minor_faults,
+              ev->major_faults);
+    }
+    fprintf(f, "\n]}\n");
+    ok = fclose(f) == 0;
+    LOG_INFO("Wrote %zu trace events to %s", count, trace_path);
+  }
+
+  for (i = 0; i < count; i++) {
+    ani_free(stopped[i].detail);
+  }
+  ani_free(stopped);
+
+  ani_free(trace_path);
+  trace_path = NULL;
+
+  return ok;
+}